@@ -0,0 +1,208 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Per-file memory arena. Data store state and caches are carved out of large,
+// huge-page aligned regions, which are all released when the file is closed.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "svp_arena.h"
+
+/**
+ * @brief Header at the start of each mapped region.
+ *
+ */
+struct svp_arena_region_t {
+  struct svp_arena_region_t *next; ///< Previously mapped region
+  size_t size;              ///< Size of the mapping (bytes)
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Find the size class of an allocation.
+ *
+ * @param nbytes Number of bytes requested.
+ * @param csize Size of the class (bytes).
+ * @return int Index of the class.
+ *
+ * Each power of two is split into four classes, so a block is never more
+ * than 25% larger than requested.
+ */
+static int svp_arena_class(size_t nbytes, size_t *csize) {
+  if (ARENA_MIN_BLOCK >= nbytes) {
+    *csize = ARENA_MIN_BLOCK;
+    return 0;
+  }
+  // 2^k < nbytes <= 2^(k+1)
+  int k = 63 - __builtin_clzl(nbytes - 1);
+  size_t step = (size_t)1 << (k - 2);
+  size_t count = ((nbytes - ((size_t)1 << k)) + step - 1) / step;
+  *csize = ((size_t)1 << k) + count * step;
+  return 4 * (k - 6) + count;
+}  // svp_arena_class
+
+
+/**
+ * @brief Map a new region aligned to ARENA_REGION.
+ *
+ * @param arena Arena object.
+ * @param nbytes Size of the region, a multiple of ARENA_REGION.
+ * @return struct svp_arena_region_t* The region, or NULL on failure.
+ */
+static struct svp_arena_region_t *svp_arena_map(struct svp_arena_t *arena,
+                                                size_t nbytes) {
+  char *base = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (arena->hugetlb) {
+    // Explicit huge pages are aligned, but need pages reserved by the system
+    base = mmap(NULL, nbytes, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (MAP_FAILED == base) {
+      fprintf(stderr, "WARNING %s: No huge pages available, using regular "
+              "pages\n", __func__);
+      arena->hugetlb = 0;
+    }
+  }
+#endif
+  if (MAP_FAILED == base) {
+    // Over-allocate, then trim the mapping down to an aligned region
+    char *raw = mmap(NULL, nbytes + ARENA_REGION, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == raw) {
+      fprintf(stderr, "ERROR %s: Could not map %lu bytes\n", __func__,
+              (unsigned long)nbytes);
+      return NULL;
+    }
+    base = (char *)(((uintptr_t)raw + ARENA_REGION - 1) &
+                    ~(uintptr_t)(ARENA_REGION - 1));
+    if (base > raw) {
+      munmap(raw, base - raw);
+    }
+    if (raw + ARENA_REGION > base) {
+      munmap(base + nbytes, (raw + ARENA_REGION) - base);
+    }
+#ifdef MADV_HUGEPAGE
+    // Let the kernel back the region with transparent huge pages
+    madvise(base, nbytes, MADV_HUGEPAGE);
+#endif
+  }
+  struct svp_arena_region_t *region = (struct svp_arena_region_t *)base;
+  region->next = arena->regions;
+  region->size = nbytes;
+  arena->regions = region;
+  arena->mapped += nbytes;
+  return region;
+}  // svp_arena_map
+
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+void svp_arena_init(struct svp_arena_t *arena) {
+  memset(arena, 0, sizeof(struct svp_arena_t));
+  pthread_mutex_init(&arena->mtx, NULL);
+}  // svp_arena_init
+
+
+void *svp_arena_alloc(struct svp_arena_t *arena, size_t nbytes) {
+  size_t csize;
+  int cls = svp_arena_class(nbytes, &csize);
+  pthread_mutex_lock(&arena->mtx);
+  // Reuse a freed block of the same class
+  char *ptr = arena->free[cls];
+  if (ptr) {
+    arena->free[cls] = *(void **)ptr;
+    pthread_mutex_unlock(&arena->mtx);
+    return ptr;
+  }
+  uintptr_t align = (ARENA_PAGE <= csize) ? ARENA_PAGE : ARENA_MIN_BLOCK;
+  if (ARENA_REGION < csize + ARENA_PAGE) {
+    // Too large to share a region, map one of its own
+    size_t rsize = (csize + ARENA_PAGE + ARENA_REGION - 1) &
+                   ~(size_t)(ARENA_REGION - 1);
+    struct svp_arena_region_t *region = svp_arena_map(arena, rsize);
+    pthread_mutex_unlock(&arena->mtx);
+    return (region) ? (char *)region + ARENA_PAGE : NULL;
+  }
+  // Carve from the current region, starting a new one if it is full
+  ptr = (char *)(((uintptr_t)arena->bptr + align - 1) & ~(align - 1));
+  if (!arena->bptr || (ptr + csize > arena->bend)) {
+    struct svp_arena_region_t *region = svp_arena_map(arena, ARENA_REGION);
+    if (!region) {
+      pthread_mutex_unlock(&arena->mtx);
+      return NULL;
+    }
+    arena->bptr = (char *)region + sizeof(struct svp_arena_region_t);
+    arena->bend = (char *)region + ARENA_REGION;
+    ptr = (char *)(((uintptr_t)arena->bptr + align - 1) & ~(align - 1));
+  }
+  arena->bptr = ptr + csize;
+  pthread_mutex_unlock(&arena->mtx);
+  return ptr;
+}  // svp_arena_alloc
+
+
+void svp_arena_free(struct svp_arena_t *arena, void *ptr, size_t nbytes) {
+  if (!ptr) {
+    return;
+  }
+  size_t csize;
+  int cls = svp_arena_class(nbytes, &csize);
+  // Give back the physical pages, except the one holding the list link. The
+  // length is rounded down, madvise would round it up into the next block
+  if (2 * ARENA_PAGE <= csize) {
+    madvise((char *)ptr + ARENA_PAGE,
+            (csize - ARENA_PAGE) & ~(size_t)(ARENA_PAGE - 1), MADV_DONTNEED);
+  }
+  pthread_mutex_lock(&arena->mtx);
+  *(void **)ptr = arena->free[cls];
+  arena->free[cls] = ptr;
+  pthread_mutex_unlock(&arena->mtx);
+}  // svp_arena_free
+
+
+void *svp_arena_realloc(struct svp_arena_t *arena, void *ptr, size_t oldsize,
+                        size_t newsize) {
+  size_t oldclass;
+  size_t newclass;
+  svp_arena_class(oldsize, &oldclass);
+  svp_arena_class(newsize, &newclass);
+  if (ptr && (oldclass == newclass)) {
+    return ptr;
+  }
+  void *nptr = svp_arena_alloc(arena, newsize);
+  if (ptr && nptr) {
+    memcpy(nptr, ptr, (oldsize < newsize) ? oldsize : newsize);
+  }
+  svp_arena_free(arena, ptr, oldsize);
+  return nptr;
+}  // svp_arena_realloc
+
+
+void svp_arena_destroy(struct svp_arena_t *arena) {
+  struct svp_arena_region_t *region = arena->regions;
+  while (region) {
+    struct svp_arena_region_t *next = region->next;
+    munmap(region, region->size);
+    region = next;
+  }
+  pthread_mutex_destroy(&arena->mtx);
+  memset(arena, 0, sizeof(struct svp_arena_t));
+}  // svp_arena_destroy
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Per-file memory arena. Data store state and caches are carved out of large,
+// huge-page aligned regions, which are all released when the file is closed.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SVP__ARENA__H__
+#define __SVP__ARENA__H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "svp_hdf5_defs.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Initialize an empty arena.
+ *
+ * @param arena Arena object.
+ *
+ * No memory is mapped until the first allocation.
+ */
+void svp_arena_init(struct svp_arena_t *arena);
+
+
+/**
+ * @brief Allocate a block from the arena.
+ *
+ * @param arena Arena object.
+ * @param nbytes Number of bytes needed.
+ * @return void* The block, or NULL if no memory could be mapped.
+ *
+ * Blocks are rounded up to a size class (at most 25% larger), and reuse a
+ * freed block of the same class when there is one. Blocks of a page or more
+ * are page-aligned, smaller ones are cache line aligned. The contents of a
+ * new block are undefined. This is safe to call from any thread.
+ */
+void *svp_arena_alloc(struct svp_arena_t *arena, size_t nbytes);
+
+
+/**
+ * @brief Return a block to the arena for reuse.
+ *
+ * @param arena Arena object.
+ * @param ptr Block, or NULL.
+ * @param nbytes Size the block was allocated with.
+ *
+ * The block stays mapped, but the physical pages of large blocks are given
+ * back to the system until the block is reused.
+ */
+void svp_arena_free(struct svp_arena_t *arena, void *ptr, size_t nbytes);
+
+
+/**
+ * @brief Change the size of a block, keeping its contents.
+ *
+ * @param arena Arena object.
+ * @param ptr Block, or NULL.
+ * @param oldsize Size the block was allocated with.
+ * @param newsize Size needed.
+ * @return void* The resized block, which may have moved.
+ */
+void *svp_arena_realloc(struct svp_arena_t *arena, void *ptr, size_t oldsize,
+                        size_t newsize);
+
+
+/**
+ * @brief Release all regions of the arena in one step.
+ *
+ * @param arena Arena object, every block allocated from it becomes invalid.
+ */
+void svp_arena_destroy(struct svp_arena_t *arena);
+
+#endif
@@ -0,0 +1,342 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Conversion between SystemVerilog packed bit vectors (svBitVecVal) and C
+// arrays of integers.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: Added bit packing of narrow lanes for storage.
+// 16-Oct-26: Added extraction of fields at any offset of a vector.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "svp_bits.h"
+
+/// Lanes can be read with one unaligned 64-bit load (little-endian only)
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define SVP_BITS_LOAD64
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Sign- or zero-extend a lane to 64 bits.
+ *
+ * @param val Lane in the least significant bits, upper bits undefined.
+ * @param width Bits per lane.
+ * @param is_signed Sign-extend, else zero-extend.
+ * @return int64_t Extended lane value.
+ */
+static inline int64_t svp_bits_extend(uint64_t val, int width, int is_signed) {
+  if (64 == width) {
+    return (int64_t)val;
+  }
+  if (is_signed) {
+    return (int64_t)(val << (64 - width)) >> (64 - width);
+  }
+  return (int64_t)(val & ((UINT64_C(1) << width) - 1));
+}  // svp_bits_extend
+
+
+/**
+ * @brief Store one lane into an integer array.
+ *
+ * @param out Integer array.
+ * @param idx Lane index.
+ * @param val Extended lane value.
+ * @param esize Bytes per integer.
+ */
+static inline void svp_bits_store(void *out, long idx, int64_t val,
+                                  int esize) {
+  switch (esize) {
+    case (1) :
+      ((int8_t *)out)[idx] = (int8_t)val;
+      break;
+    case (2) :
+      ((int16_t *)out)[idx] = (int16_t)val;
+      break;
+    case (4) :
+      ((int32_t *)out)[idx] = (int32_t)val;
+      break;
+    default :
+      ((int64_t *)out)[idx] = val;
+  }
+}  // svp_bits_store
+
+
+/**
+ * @brief Read one lane from the words of a packed vector.
+ *
+ * @param vec Packed vector.
+ * @param bit Offset of the least significant bit of the lane.
+ * @param width Bits per lane.
+ * @return uint64_t Lane in the least significant bits, upper bits undefined.
+ */
+static uint64_t svp_bits_field(const svBitVecVal *vec, unsigned long bit,
+                               int width) {
+  unsigned long word = bit >> 5;
+  int have = 32 - (bit & 31);
+  uint64_t val = vec[word] >> (bit & 31);
+  while (have < width) {
+    val |= (uint64_t)vec[++word] << have;
+    have += 32;
+  }
+  return val;
+}  // svp_bits_field
+
+
+/**
+ * @brief Unpack lanes with one 64-bit load each.
+ *
+ * @param out Integer array.
+ * @param in Packed vector, at least 8 bytes readable from each lane start.
+ * @param num Number of lanes (starting from lane 0).
+ * @param width Bits per lane, at most 56.
+ * @param is_signed Sign-extend, else zero-extend.
+ *
+ * Every 8 lanes span exactly width bytes, so within a group of 8 the load
+ * offsets and shifts only depend on the lane. When inlined with a constant
+ * width and sign, the inner loop unrolls into constant loads, shifts and
+ * extensions.
+ */
+static inline void svp_bits_lanes(void *out, const unsigned char *in,
+                                  long num, int width, int is_signed) {
+  int esize = svp_bits_esize(width);
+  long ii = 0;
+  for (; num >= ii + 8; ii += 8) {
+    const unsigned char *gptr = in + (ii / 8) * width;
+    for (int jj = 0; 8 > jj; ++jj) {
+      uint64_t val;
+      memcpy(&val, gptr + ((jj * width) >> 3), sizeof(val));
+      svp_bits_store(out, ii + jj, svp_bits_extend(val >> ((jj * width) & 7),
+                                                   width, is_signed), esize);
+    }
+  }
+  for (; num > ii; ++ii) {
+    unsigned long bit = ii * width;
+    uint64_t val;
+    memcpy(&val, in + (bit >> 3), sizeof(val));
+    svp_bits_store(out, ii, svp_bits_extend(val >> (bit & 7), width,
+                                            is_signed), esize);
+  }
+}  // svp_bits_lanes
+
+
+/**
+ * @brief Unpack lanes, with the sign resolved at compile time.
+ *
+ * @param out Integer array.
+ * @param in Packed vector.
+ * @param num Number of lanes.
+ * @param width Bits per lane, at most 56.
+ * @param is_signed Sign-extend, else zero-extend.
+ */
+static inline void svp_bits_kernel(void *out, const unsigned char *in,
+                                   long num, int width, int is_signed) {
+  if (is_signed) {
+    svp_bits_lanes(out, in, num, width, 1);
+  } else {
+    svp_bits_lanes(out, in, num, width, 0);
+  }
+}  // svp_bits_kernel
+
+
+/**
+ * @brief Pack groups of 8 byte lanes, with the width resolved at compile time.
+ *
+ * @param out Packed bits, width bytes per group.
+ * @param in Byte lanes.
+ * @param ngrp Number of groups of 8 lanes.
+ * @param width Bits per lane, at most 8.
+ *
+ * Every 8 lanes fill exactly width bytes, which are assembled in a 64-bit
+ * register and stored at once (little-endian only).
+ */
+static inline void svp_bits_fold(unsigned char *out, const unsigned char *in,
+                                 long ngrp, int width) {
+  uint64_t mask = (1UL << width) - 1;
+  for (long ii = 0; ngrp > ii; ++ii) {
+    uint64_t acc = 0;
+    for (int jj = 0; 8 > jj; ++jj) {
+      acc |= (in[8 * ii + jj] & mask) << (jj * width);
+    }
+    memcpy(out + ii * width, &acc, width);
+  }
+}  // svp_bits_fold
+
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+int svp_bits_esize(int width) {
+  if (8 >= width) {
+    return 1;
+  } else if (16 >= width) {
+    return 2;
+  } else if (32 >= width) {
+    return 4;
+  }
+  return 8;
+}  // svp_bits_esize
+
+
+long svp_bits_nwords(int width, int size) {
+  return ((long)width * size + 31) / 32;
+}  // svp_bits_nwords
+
+
+void svp_bits_unpack(void *out, const svBitVecVal *vec, int width, int size,
+                     int is_signed) {
+  int esize = svp_bits_esize(width);
+  long nfast = 0;
+#ifdef SVP_BITS_LOAD64
+  // Full-width lanes are already laid out as a C array
+  if (8 * esize == width) {
+    memcpy(out, vec, (size_t)size * esize);
+    return;
+  }
+  // Lanes which can be loaded without reading past the end of the vector
+  long nbytes = 4 * svp_bits_nwords(width, size);
+  if ((56 >= width) && (8 <= nbytes)) {
+    nfast = ((nbytes - 8) * 8 + 7) / width + 1;
+    if (nfast > size) {
+      nfast = size;
+    }
+  }
+  const unsigned char *in = (const unsigned char *)vec;
+  switch (width) {
+    case (1) :
+      svp_bits_kernel(out, in, nfast, 1, is_signed);
+      break;
+    case (2) :
+      svp_bits_kernel(out, in, nfast, 2, is_signed);
+      break;
+    case (3) :
+      svp_bits_kernel(out, in, nfast, 3, is_signed);
+      break;
+    case (4) :
+      svp_bits_kernel(out, in, nfast, 4, is_signed);
+      break;
+    case (5) :
+      svp_bits_kernel(out, in, nfast, 5, is_signed);
+      break;
+    case (6) :
+      svp_bits_kernel(out, in, nfast, 6, is_signed);
+      break;
+    case (7) :
+      svp_bits_kernel(out, in, nfast, 7, is_signed);
+      break;
+    case (9) :
+      svp_bits_kernel(out, in, nfast, 9, is_signed);
+      break;
+    case (10) :
+      svp_bits_kernel(out, in, nfast, 10, is_signed);
+      break;
+    case (11) :
+      svp_bits_kernel(out, in, nfast, 11, is_signed);
+      break;
+    case (12) :
+      svp_bits_kernel(out, in, nfast, 12, is_signed);
+      break;
+    case (13) :
+      svp_bits_kernel(out, in, nfast, 13, is_signed);
+      break;
+    case (14) :
+      svp_bits_kernel(out, in, nfast, 14, is_signed);
+      break;
+    case (15) :
+      svp_bits_kernel(out, in, nfast, 15, is_signed);
+      break;
+    default :
+      svp_bits_kernel(out, in, nfast, width, is_signed);
+  }
+#endif
+  // Lanes at the end of the vector (or all of them, for wide lanes)
+  for (long ii = nfast; size > ii; ++ii) {
+    uint64_t val = svp_bits_field(vec, (unsigned long)ii * width, width);
+    svp_bits_store(out, ii, svp_bits_extend(val, width, is_signed), esize);
+  }
+}  // svp_bits_unpack
+
+
+void svp_bits_extract(void *out, int esize, const svBitVecVal *vec,
+                      unsigned long bit, int width, int size, int is_signed) {
+#ifdef SVP_BITS_LOAD64
+  // Byte-aligned lanes of the full integer width are copied as is
+  if ((0 == (bit & 7)) && (8 * esize == width)) {
+    memcpy(out, (const unsigned char *)vec + (bit >> 3), (size_t)size * esize);
+    return;
+  }
+#endif
+  for (long ii = 0; size > ii; ++ii) {
+    uint64_t val = svp_bits_field(vec, bit + (unsigned long)ii * width, width);
+    svp_bits_store(out, ii, svp_bits_extend(val, width, is_signed), esize);
+  }
+}  // svp_bits_extract
+
+
+long svp_bits_pack(void *out, const void *in, long num, int width) {
+  const unsigned char *iptr = (const unsigned char *)in;
+  unsigned char *optr = (unsigned char *)out;
+  long ii = 0;
+#ifdef SVP_BITS_LOAD64
+  // Whole groups of 8 lanes
+  long ngrp = num / 8;
+  switch (width) {
+    case (1) :
+      svp_bits_fold(optr, iptr, ngrp, 1);
+      break;
+    case (2) :
+      svp_bits_fold(optr, iptr, ngrp, 2);
+      break;
+    case (3) :
+      svp_bits_fold(optr, iptr, ngrp, 3);
+      break;
+    case (4) :
+      svp_bits_fold(optr, iptr, ngrp, 4);
+      break;
+    case (5) :
+      svp_bits_fold(optr, iptr, ngrp, 5);
+      break;
+    case (6) :
+      svp_bits_fold(optr, iptr, ngrp, 6);
+      break;
+    case (7) :
+      svp_bits_fold(optr, iptr, ngrp, 7);
+      break;
+    default :
+      svp_bits_fold(optr, iptr, ngrp, width);
+  }
+  ii = 8 * ngrp;
+  optr += ngrp * width;
+#endif
+  // Remaining lanes, through a bit accumulator
+  unsigned int mask = (1U << width) - 1;
+  unsigned int acc = 0;
+  int nacc = 0;
+  for (; num > ii; ++ii) {
+    acc |= (iptr[ii] & mask) << nacc;
+    nacc += width;
+    while (8 <= nacc) {
+      *optr++ = (unsigned char)acc;
+      acc >>= 8;
+      nacc -= 8;
+    }
+  }
+  // The last byte is padded with zeros
+  if (nacc) {
+    *optr++ = (unsigned char)acc;
+  }
+  return optr - (unsigned char *)out;
+}  // svp_bits_pack
@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Conversion between SystemVerilog packed bit vectors (svBitVecVal) and C
+// arrays of integers.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: Added bit packing of narrow lanes for storage.
+// 16-Oct-26: Added extraction of fields at any offset of a vector.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SVP__BITS__H__
+#define __SVP__BITS__H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "svdpi.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Size of the C integer which holds one lane of a packed vector.
+ *
+ * @param width Bits per lane (1 to 64).
+ * @return int Bytes per lane: 1, 2, 4 or 8.
+ *
+ * This is the smallest integer which fits the lane, the same choice as the
+ * SV dump classes make for their datatype.
+ */
+int svp_bits_esize(int width);
+
+
+/**
+ * @brief Number of 32-bit words of a packed vector.
+ *
+ * @param width Bits per lane.
+ * @param size Number of lanes.
+ * @return long Length of the svBitVecVal array.
+ */
+long svp_bits_nwords(int width, int size);
+
+
+/**
+ * @brief Unpack the lanes of a packed vector into an integer array.
+ *
+ * @param out Array of size integers, each svp_bits_esize(width) bytes.
+ * @param vec Packed vector bit [size-1:0][width-1:0], in the canonical DPI
+ * layout (lane 0 in the least significant bits of vec[0]).
+ * @param width Bits per lane (1 to 64).
+ * @param size Number of lanes.
+ * @param is_signed Sign-extend each lane, else zero-extend.
+ *
+ * Lanes of exactly 8, 16, 32 or 64 bits are copied as is. Lanes of up to 16
+ * bits are extracted by kernels specialized for their width, which the
+ * compiler unrolls into constant shifts and masks. Other widths use a generic
+ * loop.
+ */
+void svp_bits_unpack(void *out, const svBitVecVal *vec, int width, int size,
+                     int is_signed);
+
+
+/**
+ * @brief Unpack the lanes of one field of a packed vector.
+ *
+ * @param out Array of size integers, each esize bytes.
+ * @param esize Bytes per integer (1, 2, 4 or 8), at least width bits.
+ * @param vec Packed vector, in the canonical DPI layout.
+ * @param bit Offset of the least significant bit of lane 0 in the vector.
+ * @param width Bits per lane (1 to 64).
+ * @param size Number of lanes.
+ * @param is_signed Sign-extend each lane, else zero-extend.
+ *
+ * This is svp_bits_unpack for a field which does not start at bit 0, e.g. a
+ * member of a packed struct. Byte-aligned fields which fill their integers
+ * are copied as is, which also passes through the bits of a real.
+ */
+void svp_bits_extract(void *out, int esize, const svBitVecVal *vec,
+                      unsigned long bit, int width, int size, int is_signed);
+
+
+/**
+ * @brief Pack the low bits of byte lanes into a contiguous bit stream.
+ *
+ * @param out Packed bits, at least (num * width + 7) / 8 bytes.
+ * @param in Array of num lanes, one byte each.
+ * @param num Number of lanes.
+ * @param width Bits kept per lane (1 to 8).
+ * @return long Number of bytes written.
+ *
+ * Lane 0 goes to the least significant bits of out[0], and lanes may straddle
+ * bytes. Upper bits of each lane (e.g. the sign extension) are dropped, and
+ * the last byte is padded with zeros. This is the bit order of numpy
+ * unpackbits(bitorder='little').
+ */
+long svp_bits_pack(void *out, const void *in, long num, int width);
+
+#endif
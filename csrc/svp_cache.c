@@ -0,0 +1,240 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Memory budget shared by the data store caches of a file. Caches start small
+// and grow towards a full chunk while the budget allows, and the largest
+// caches are flushed and shrunk early when it is exhausted.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: Caches are allocated from the file arena.
+// 16-Oct-26: Spills of bit-packed caches end on a byte boundary.
+// 16-Oct-26: Spills are committed through the file backend.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "svp_cache.h"
+#include "svp_io.h"
+#include "svp_arena.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Cache memory needed per record.
+ *
+ * @param dat Data store object.
+ * @return size_t Bytes per record, data plus timestamp.
+ */
+static size_t svp_cache_rbytes(const struct svp_dstore_t *dat) {
+  return dat->cstride + ((dat->tcache) ? sizeof(*dat->tcache) : 0);
+}  // svp_cache_rbytes
+
+
+/**
+ * @brief Smallest length a cache is shrunk to.
+ *
+ * @param dat Data store object.
+ * @return unsigned long Number of records.
+ */
+static unsigned long svp_cache_minlen(const struct svp_dstore_t *dat) {
+  return (CACHE_MIN_LEN < dat->clen) ? CACHE_MIN_LEN : dat->clen;
+}  // svp_cache_minlen
+
+
+/**
+ * @brief Change the length of the front caches, keeping their contents.
+ *
+ * @param dat Data store object.
+ * @param ccap New number of records, at least cptr.
+ */
+static void svp_cache_resize(struct svp_dstore_t *dat, unsigned long ccap) {
+  struct svp_arena_t *arena = &dat->file->arena;
+  long delta = ((long)ccap - (long)dat->ccap) * svp_cache_rbytes(dat);
+  dat->dcache = svp_arena_realloc(arena, dat->dcache, dat->ccap * dat->cstride,
+                                  ccap * dat->cstride);
+  if (dat->tcache) {
+    dat->tcache = svp_arena_realloc(arena, dat->tcache,
+                                    dat->ccap * sizeof(*dat->tcache),
+                                    ccap * sizeof(*dat->tcache));
+  }
+  dat->ccap = ccap;
+  svp_cache_track(dat, delta);
+}  // svp_cache_resize
+
+
+/**
+ * @brief Write out a cache before it is full.
+ *
+ * @param dat Data store object.
+ *
+ * Only whole multiples of palign records are written, so that a bit-packed
+ * stream stays byte-aligned. The few records left over are moved to the
+ * start of the cache.
+ */
+static void svp_cache_spill(struct svp_dstore_t *dat) {
+  unsigned long ncommit = dat->cptr - dat->cptr % dat->palign;
+  if (0 == ncommit) {
+    return;
+  }
+  svp_io_wait(dat);
+  svp_io_lock(dat->file);
+  dat->file->backend->commit(dat, dat->tcache, dat->dcache, dat->wptr,
+                             ncommit);
+  svp_io_unlock(dat->file);
+  dat->wptr += ncommit;
+  dat->cptr -= ncommit;
+  if (dat->cptr) {
+    memmove(dat->dcache, (char *)dat->dcache + ncommit * dat->cstride,
+            dat->cptr * dat->cstride);
+    if (dat->tcache) {
+      memmove(dat->tcache, dat->tcache + ncommit,
+              dat->cptr * sizeof(*dat->tcache));
+    }
+  }
+  dat->nspill += 1;
+}  // svp_cache_spill
+
+
+/**
+ * @brief Flush a cache and return its memory to the budget.
+ *
+ * @param dat Data store object.
+ */
+static void svp_cache_shrink(struct svp_dstore_t *dat) {
+  svp_cache_spill(dat);
+  // Back caches are only used by full-length caches, they are allocated
+  // again on the next hand-off
+  svp_io_wait(dat);
+  if (dat->dcache_bk) {
+    svp_arena_free(&dat->file->arena, dat->dcache_bk,
+                   dat->clen * dat->cstride);
+    dat->dcache_bk = NULL;
+    if (dat->tcache_bk) {
+      svp_arena_free(&dat->file->arena, dat->tcache_bk,
+                     dat->clen * sizeof(*dat->tcache_bk));
+      dat->tcache_bk = NULL;
+    }
+    svp_cache_track(dat, -(long)(dat->clen * svp_cache_rbytes(dat)));
+  }
+  svp_cache_resize(dat, svp_cache_minlen(dat));
+}  // svp_cache_shrink
+
+
+/**
+ * @brief Pick the cache to be shrunk in favour of another one.
+ *
+ * @param dat Data store which needs memory.
+ * @return struct svp_dstore_t* Largest shrinkable cache, the least recently
+ * filled one if there is a tie, or NULL if there is none.
+ */
+static struct svp_dstore_t *svp_cache_victim(struct svp_dstore_t *dat) {
+  struct svp_hdf5_data *clsdat = dat->file;
+  struct svp_dstore_t *victim = NULL;
+  for (int ii = 0; clsdat->num_signals > ii; ++ii) {
+    struct svp_dstore_t *cand = clsdat->dptr[ii];
+    if ((dat == cand) || (svp_cache_minlen(cand) >= cand->ccap)) {
+      continue;
+    }
+    if (!victim || (cand->cache_bytes > victim->cache_bytes) ||
+        ((cand->cache_bytes == victim->cache_bytes) &&
+         (cand->ctick < victim->ctick))) {
+      victim = cand;
+    }
+  }
+  return victim;
+}  // svp_cache_victim
+
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+void svp_cache_init(struct svp_dstore_t *dat) {
+  // Start small only if memory is limited
+  unsigned long ccap = (dat->file->cache_budget) ? svp_cache_minlen(dat)
+                                                  : dat->clen;
+  dat->dcache = svp_arena_alloc(&dat->file->arena, ccap * dat->cstride);
+  if (SVP_STORE_SYNC_DATA != dat->store_type) {
+    dat->tcache = svp_arena_alloc(&dat->file->arena,
+                                  ccap * sizeof(*dat->tcache));
+  }
+  dat->ccap = ccap;
+  svp_cache_track(dat, ccap * svp_cache_rbytes(dat));
+}  // svp_cache_init
+
+
+void svp_cache_full(struct svp_dstore_t *dat) {
+  struct svp_hdf5_data *clsdat = dat->file;
+  dat->ctick = ++clsdat->cache_tick;
+  // Double the cache, up to a full chunk
+  unsigned long ccap = 2 * dat->ccap;
+  if (ccap > dat->clen) {
+    ccap = dat->clen;
+  }
+  size_t need = (ccap - dat->ccap) * svp_cache_rbytes(dat);
+  if (clsdat->cache_budget) {
+    // Take memory from the other caches if needed
+    while (clsdat->cache_used + need > clsdat->cache_budget) {
+      struct svp_dstore_t *victim = svp_cache_victim(dat);
+      if (!victim) {
+        break;
+      }
+      svp_cache_shrink(victim);
+    }
+    if (clsdat->cache_used + need > clsdat->cache_budget) {
+      // No room left, write out the cache at its current length
+      svp_cache_spill(dat);
+      return;
+    }
+  }
+  svp_cache_resize(dat, ccap);
+}  // svp_cache_full
+
+
+void svp_cache_track(struct svp_dstore_t *dat, long nbytes) {
+  struct svp_hdf5_data *clsdat = dat->file;
+  dat->cache_bytes += nbytes;
+  clsdat->cache_used += nbytes;
+  if (dat->cache_bytes > dat->cache_peak) {
+    dat->cache_peak = dat->cache_bytes;
+  }
+  if (clsdat->cache_used > clsdat->cache_peak) {
+    clsdat->cache_peak = clsdat->cache_used;
+  }
+}  // svp_cache_track
+
+
+void svp_cache_free(struct svp_dstore_t *dat) {
+  struct svp_arena_t *arena = &dat->file->arena;
+  svp_arena_free(arena, dat->tcache, dat->ccap * sizeof(*dat->tcache));
+  svp_arena_free(arena, dat->dcache, dat->ccap * dat->cstride);
+  svp_arena_free(arena, dat->tcache_bk, dat->clen * sizeof(*dat->tcache_bk));
+  svp_arena_free(arena, dat->dcache_bk, dat->clen * dat->cstride);
+  svp_cache_track(dat, -(long)dat->cache_bytes);
+}  // svp_cache_free
+
+
+void svp_cache_report(struct svp_hdf5_data *clsdat) {
+  printf("INFO %s: Cache memory of %s, budget %lu, peak %lu bytes, "
+         "arena %lu bytes\n", __func__, clsdat->name,
+         (unsigned long)clsdat->cache_budget,
+         (unsigned long)clsdat->cache_peak,
+         (unsigned long)clsdat->arena.mapped);
+  printf("%14s %14s %10s  %s\n", "peak bytes", "chunk bytes", "early",
+         "signal");
+  for (int ii = 0; clsdat->num_signals > ii; ++ii) {
+    struct svp_dstore_t *dat = clsdat->dptr[ii];
+    printf("%14lu %14lu %10lu  %s\n", (unsigned long)dat->cache_peak,
+           (unsigned long)(dat->clen * svp_cache_rbytes(dat)), dat->nspill,
+           dat->name);
+  }
+}  // svp_cache_report
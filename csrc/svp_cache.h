@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Memory budget shared by the data store caches of a file. Caches start small
+// and grow towards a full chunk while the budget allows, and the largest
+// caches are flushed and shrunk early when it is exhausted.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SVP__CACHE__H__
+#define __SVP__CACHE__H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hdf5.h"
+#include "svp_hdf5_defs.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Allocate the initial caches of a new data store.
+ *
+ * @param dat Data store, with clen and cstride already set.
+ *
+ * Without a budget the caches hold a full chunk right away. With a budget
+ * they start at CACHE_MIN_LEN records and grow on demand.
+ */
+void svp_cache_init(struct svp_dstore_t *dat);
+
+
+/**
+ * @brief Make room in a cache which is full but shorter than a chunk.
+ *
+ * @param dat Data store whose cache is full (cptr == ccap < clen).
+ *
+ * The cache is doubled if the budget allows, otherwise the largest (then
+ * least recently filled) caches of other data stores are flushed and shrunk
+ * to make room. If that is not enough, the cache is flushed in place.
+ */
+void svp_cache_full(struct svp_dstore_t *dat);
+
+
+/**
+ * @brief Account for memory allocated or freed for a data store cache.
+ *
+ * @param dat Data store owning the memory.
+ * @param nbytes Number of bytes allocated (positive) or freed (negative).
+ */
+void svp_cache_track(struct svp_dstore_t *dat, long nbytes);
+
+
+/**
+ * @brief Free all caches of a data store.
+ *
+ * @param dat Data store, whose pending writes must already be flushed.
+ */
+void svp_cache_free(struct svp_dstore_t *dat);
+
+
+/**
+ * @brief Print the cache memory used by each data store of a file.
+ *
+ * @param clsdat File handle.
+ */
+void svp_cache_report(struct svp_hdf5_data *clsdat);
+
+#endif
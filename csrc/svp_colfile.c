@@ -0,0 +1,628 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Column storage backend. Each data store appends its caches to raw column
+// files through shared memory mappings, with no HDF5 calls while the
+// simulation runs, and the directory is converted to HDF5 afterwards.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: Time columns of a time base hold ticks, replayed as they are.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "svp_colfile.h"
+#include "svp_file.h"
+#include "svp_dstore.h"
+#include "svp_prof.h"
+#include "svp_arena.h"
+
+/// First bytes of the manifest, the number is the format version
+#define COL_MAGIC "SVPCOL1\n"
+/// Minimum growth of a column file and its mapping (bytes)
+#define COL_MIN_GROW (16UL << 20)
+/// Longest path of a file in the directory
+#define COL_PATH_MAX 4096
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Write a string to the manifest, preceded by its length.
+ *
+ * @param fp Manifest.
+ * @param str String, stored with its terminating NUL.
+ */
+static void svp_col_put_str(FILE *fp, const char *str) {
+  unsigned int len = strlen(str) + 1;
+  fwrite(&len, sizeof(len), 1, fp);
+  fwrite(str, 1, len, fp);
+}  // svp_col_put_str
+
+
+/**
+ * @brief Create (or truncate) a column file.
+ *
+ * @param map Column to be opened.
+ * @param dir Directory of the column files.
+ * @param index Number of the data store.
+ * @param ext File extension, "time" or "data".
+ */
+static void svp_col_map_open(struct svp_col_map_t *map, const char *dir,
+                             unsigned long index, const char *ext) {
+  char path[COL_PATH_MAX];
+  snprintf(path, sizeof(path), "%s/%lu.%s", dir, index, ext);
+  map->base = NULL;
+  map->cap = 0;
+  map->len = 0;
+  map->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (0 > map->fd) {
+    fprintf(stderr, "ERROR %s: Could not create %s: %s\n", __func__, path,
+            strerror(errno));
+  }
+}  // svp_col_map_open
+
+
+/**
+ * @brief Grow a column file and its mapping to hold a number of bytes.
+ *
+ * @param map Column, which fails to grow if it has no file.
+ * @param need Minimum size of the file (bytes).
+ * @return int Returns 0 if the mapping holds need bytes.
+ *
+ * The size is doubled rather than grown to need, so the mapping is only
+ * replaced O(log(N)) times. The file is trimmed to the bytes written when
+ * the column is closed.
+ */
+static int svp_col_map_grow(struct svp_col_map_t *map, size_t need) {
+  if (0 > map->fd) {
+    return 1;
+  }
+  if (need <= map->cap) {
+    return 0;
+  }
+  size_t cap = 2 * map->cap;
+  if (need > cap) {
+    cap = need;
+  }
+  if (COL_MIN_GROW > cap) {
+    cap = COL_MIN_GROW;
+  }
+  size_t page = sysconf(_SC_PAGESIZE);
+  cap = page * ((cap + page - 1) / page);
+  if (map->base) {
+    munmap(map->base, map->cap);
+    map->base = NULL;
+    map->cap = 0;
+  }
+  if (ftruncate(map->fd, cap)) {
+    fprintf(stderr, "ERROR %s: Could not grow a column file: %s\n", __func__,
+            strerror(errno));
+    return 1;
+  }
+  void *base = mmap(NULL, cap, PROT_READ | PROT_WRITE, MAP_SHARED, map->fd, 0);
+  if (MAP_FAILED == base) {
+    fprintf(stderr, "ERROR %s: Could not map a column file: %s\n", __func__,
+            strerror(errno));
+    return 1;
+  }
+  map->base = base;
+  map->cap = cap;
+  return 0;
+}  // svp_col_map_grow
+
+
+/**
+ * @brief Copy records into a column, past the end of the file if needed.
+ *
+ * @param dat Data store owning the column.
+ * @param map Column, nothing is written if it has no file.
+ * @param src Records to be copied.
+ * @param offset Position of the first record in the column (bytes).
+ * @param nbytes Size of the records (bytes).
+ */
+static void svp_col_map_write(struct svp_dstore_t *dat,
+                              struct svp_col_map_t *map, const void *src,
+                              size_t offset, size_t nbytes) {
+  if (0 > map->fd) {
+    return;
+  }
+  unsigned long long start = svp_prof_start(dat);
+  int err = svp_col_map_grow(map, offset + nbytes);
+  svp_prof_stop(&dat->prof.t_extent, start);
+  if (err) {
+    return;
+  }
+  start = svp_prof_start(dat);
+  memcpy(map->base + offset, src, nbytes);
+  svp_prof_stop(&dat->prof.t_write, start);
+  if (offset + nbytes > map->len) {
+    map->len = offset + nbytes;
+  }
+  dat->prof.bytes += nbytes;
+}  // svp_col_map_write
+
+
+/**
+ * @brief Unmap a column, and trim its file to the bytes written.
+ *
+ * @param map Column to be closed.
+ */
+static void svp_col_map_close(struct svp_col_map_t *map) {
+  if (0 > map->fd) {
+    return;
+  }
+  if (map->base) {
+    munmap(map->base, map->cap);
+  }
+  if (ftruncate(map->fd, map->len)) {
+    fprintf(stderr, "WARNING %s: Could not trim a column file: %s\n",
+            __func__, strerror(errno));
+  }
+  close(map->fd);
+  map->fd = -1;
+}  // svp_col_map_close
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Backend
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Create the directory and its manifest.
+ *
+ * @param clsdat File handle.
+ * @param fname Directory, which may already exist.
+ * @return int Returns 0 if successful.
+ */
+static int svp_col_fopen(struct svp_hdf5_data *clsdat, const char *fname) {
+  if (mkdir(fname, 0777) && (EEXIST != errno)) {
+    fprintf(stderr, "ERROR %s: Could not create %s: %s\n", __func__, fname,
+            strerror(errno));
+    return 1;
+  }
+  char path[COL_PATH_MAX];
+  snprintf(path, sizeof(path), "%s/manifest", fname);
+  clsdat->col_fp = fopen(path, "wb");
+  if (!clsdat->col_fp) {
+    fprintf(stderr, "ERROR %s: Could not create %s\n", __func__, path);
+    return 1;
+  }
+  fwrite(COL_MAGIC, 1, strlen(COL_MAGIC), clsdat->col_fp);
+  return 0;
+}  // svp_col_fopen
+
+
+/**
+ * @brief Mark the end of the manifest, and close it.
+ *
+ * @param clsdat File handle, with all of its data stores closed.
+ */
+static void svp_col_fclose(struct svp_hdf5_data *clsdat) {
+  fputc('E', clsdat->col_fp);
+  fclose(clsdat->col_fp);
+}  // svp_col_fclose
+
+
+/**
+ * @brief Record an attribute of the file in the manifest.
+ *
+ * @param clsdat File handle.
+ * @param name Attribute name.
+ * @param value Attribute value.
+ */
+static void svp_col_fattr(struct svp_hdf5_data *clsdat, const char *name,
+                          const char *value) {
+  fputc('A', clsdat->col_fp);
+  svp_col_put_str(clsdat->col_fp, name);
+  svp_col_put_str(clsdat->col_fp, value);
+}  // svp_col_fattr
+
+
+/**
+ * @brief Grow the column files to hold a number of records.
+ *
+ * @param dat Data store owning the columns.
+ * @param num Number of records expected.
+ */
+static void svp_col_reserve(struct svp_dstore_t *dat, unsigned long num) {
+  unsigned long long start = svp_prof_start(dat);
+  svp_col_map_grow(&dat->col->tmap, num * sizeof(double));
+  svp_col_map_grow(&dat->col->dmap, num * dat->cstride);
+  svp_prof_stop(&dat->prof.t_extent, start);
+}  // svp_col_reserve
+
+
+/**
+ * @brief Create the column files of a data store.
+ *
+ * @param dat Data store, whose caches exist.
+ */
+static void svp_col_open(struct svp_dstore_t *dat) {
+  struct svp_hdf5_data *clsdat = dat->file;
+  dat->col = svp_arena_alloc(&clsdat->arena, sizeof(struct svp_col_t));
+  dat->col->index = clsdat->col_count++;
+  dat->col->tmap.fd = -1;
+  // Synchronous data has no timestamps
+  if (SVP_STORE_SYNC_DATA != dat->store_type) {
+    svp_col_map_open(&dat->col->tmap, clsdat->name, dat->col->index, "time");
+  }
+  svp_col_map_open(&dat->col->dmap, clsdat->name, dat->col->index, "data");
+  // Pre-size the files, if a size was given before they existed
+  if (dat->expect) {
+    svp_col_reserve(dat, dat->expect);
+  }
+}  // svp_col_open
+
+
+/**
+ * @brief Append cached records to the column files.
+ *
+ * @param dat Data store owning the columns.
+ * @param tcache Timestamp cache, copied as it is (NULL for synchronous data).
+ * @param dcache Data cache.
+ * @param wptr Record offset within the columns where the block starts.
+ * @param cptr Number of cached records to be written.
+ */
+static void svp_col_commit(struct svp_dstore_t *dat,
+                           union svp_tstamp_u *tcache, void *dcache,
+                           unsigned long wptr, unsigned long cptr) {
+  if (0 == cptr) {
+    return;
+  }
+  dat->prof.flushes += 1;
+  if (tcache) {
+    svp_col_map_write(dat, &dat->col->tmap, tcache, wptr * sizeof(*tcache),
+                      cptr * sizeof(*tcache));
+  }
+  svp_col_map_write(dat, &dat->col->dmap, dcache, wptr * dat->cstride,
+                    cptr * dat->cstride);
+}  // svp_col_commit
+
+
+/**
+ * @brief Close the column files, and describe the data store in the manifest.
+ *
+ * @param dat Data store, with all of its data committed.
+ *
+ * The description holds everything svp_dstore_create needs to build the
+ * same dataset, along with the file settings which shaped it.
+ */
+static void svp_col_close(struct svp_dstore_t *dat) {
+  struct svp_hdf5_data *clsdat = dat->file;
+  FILE *fp = clsdat->col_fp;
+  svp_col_map_close(&dat->col->tmap);
+  svp_col_map_close(&dat->col->dmap);
+  fputc('S', fp);
+  svp_col_put_str(fp, dat->name);
+  fwrite(&dat->col->index, sizeof(unsigned long), 1, fp);
+  int store_type = dat->store_type;
+  fwrite(&store_type, sizeof(int), 1, fp);
+  fwrite(&dat->rank, sizeof(int), 1, fp);
+  fwrite(dat->dims, sizeof(hsize_t), dat->rank, fp);
+  // The record type, which may be a compound
+  size_t tsize = 0;
+  H5Tencode(dat->h5type, NULL, &tsize);
+  unsigned char *tbuf = malloc(tsize);
+  H5Tencode(dat->h5type, tbuf, &tsize);
+  fwrite(&tsize, sizeof(size_t), 1, fp);
+  fwrite(tbuf, 1, tsize, fp);
+  free(tbuf);
+  fwrite(&dat->precision, sizeof(int), 1, fp);
+  fwrite(&dat->filt, sizeof(struct svp_filter_t), 1, fp);
+  fwrite(&dat->clen, sizeof(unsigned long), 1, fp);
+  fwrite(&dat->wptr, sizeof(unsigned long), 1, fp);
+  fwrite(&dat->nsample, sizeof(unsigned long), 1, fp);
+  // Settings of the file
+  fwrite(&clsdat->chunk_bytes, sizeof(clsdat->chunk_bytes), 1, fp);
+  fwrite(&clsdat->time_res, sizeof(double), 1, fp);
+  fwrite(&clsdat->layout, sizeof(int), 1, fp);
+  // And the attributes, which were kept until now
+  int nattr = 0;
+  for (struct svp_attr_t *attr = dat->attrs; attr; attr = attr->next) {
+    ++nattr;
+  }
+  fwrite(&nattr, sizeof(int), 1, fp);
+  for (struct svp_attr_t *attr = dat->attrs; attr; attr = attr->next) {
+    svp_col_put_str(fp, attr->name);
+    svp_col_put_str(fp, attr->value);
+  }
+  svp_arena_free(&clsdat->arena, dat->col, sizeof(struct svp_col_t));
+  dat->col = NULL;
+}  // svp_col_close
+
+
+const struct svp_backend_t svp_backend_column = {
+  .name = "column",
+  .fopen = svp_col_fopen,
+  .fclose = svp_col_fclose,
+  .fattr = svp_col_fattr,
+  .open = svp_col_open,
+  .commit = svp_col_commit,
+  .reserve = svp_col_reserve,
+  .attr = NULL,
+  .close = svp_col_close,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Conversion
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Position within the manifest being converted.
+ *
+ */
+struct svp_col_cursor_t {
+  const char *pos;          ///< Next byte to be read
+  const char *end;          ///< End of the manifest
+};
+
+
+/**
+ * @brief Read bytes from the manifest.
+ *
+ * @param cur Position in the manifest.
+ * @param dst Where the bytes are copied.
+ * @param nbytes Number of bytes.
+ * @return int Returns 0 if the manifest held nbytes more bytes.
+ */
+static int svp_col_get(struct svp_col_cursor_t *cur, void *dst,
+                       size_t nbytes) {
+  if ((size_t)(cur->end - cur->pos) < nbytes) {
+    return 1;
+  }
+  memcpy(dst, cur->pos, nbytes);
+  cur->pos += nbytes;
+  return 0;
+}  // svp_col_get
+
+
+/**
+ * @brief Read a string from the manifest.
+ *
+ * @param cur Position in the manifest.
+ * @return const char* String within the manifest, NULL if it is truncated.
+ */
+static const char *svp_col_get_str(struct svp_col_cursor_t *cur) {
+  unsigned int len;
+  if (svp_col_get(cur, &len, sizeof(len)) || (0 == len) ||
+      ((size_t)(cur->end - cur->pos) < len) || cur->pos[len - 1]) {
+    return NULL;
+  }
+  const char *str = cur->pos;
+  cur->pos += len;
+  return str;
+}  // svp_col_get_str
+
+
+/**
+ * @brief Map a column file for reading.
+ *
+ * @param dir Directory of the column files.
+ * @param index Number of the data store.
+ * @param ext File extension, "time" or "data".
+ * @param nbytes Bytes expected in the file.
+ * @return void* Mapping of the file, NULL if it is empty or too short.
+ */
+static void *svp_col_map_read(const char *dir, unsigned long index,
+                              const char *ext, size_t nbytes) {
+  if (0 == nbytes) {
+    return NULL;
+  }
+  char path[COL_PATH_MAX];
+  snprintf(path, sizeof(path), "%s/%lu.%s", dir, index, ext);
+  int fd = open(path, O_RDONLY);
+  struct stat fstat_buf;
+  if ((0 > fd) || fstat(fd, &fstat_buf) ||
+      ((size_t)fstat_buf.st_size < nbytes)) {
+    fprintf(stderr, "ERROR %s: Missing or short column file %s\n", __func__,
+            path);
+    if (0 <= fd) {
+      close(fd);
+    }
+    return NULL;
+  }
+  void *base = mmap(NULL, nbytes, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  return (MAP_FAILED == base) ? NULL : base;
+}  // svp_col_map_read
+
+
+/**
+ * @brief Write one data store of the manifest to the HDF5 file.
+ *
+ * @param dir Directory of the column files.
+ * @param cur Position in the manifest, just after the 'S'.
+ * @param out HDF5 file.
+ * @param h5type Set to the decoded record type, which the caller closes.
+ * @return int Returns 0 if successful.
+ */
+static int svp_col_convert_signal(const char *dir,
+                                  struct svp_col_cursor_t *cur,
+                                  struct svp_hdf5_data *out, hid_t *h5type) {
+  const char *name = svp_col_get_str(cur);
+  unsigned long index, clen, count, nsample;
+  int store_type, rank, nattr, layout;
+  size_t tsize;
+  double time_res;
+  hsize_t dims[H5S_MAX_RANK];
+  int idims[H5S_MAX_RANK];
+  struct svp_dstore_opt_t opt = {};
+  *h5type = -1;
+  if (!name || svp_col_get(cur, &index, sizeof(index)) ||
+      svp_col_get(cur, &store_type, sizeof(int)) ||
+      svp_col_get(cur, &rank, sizeof(int)) || (0 > rank) ||
+      (H5S_MAX_RANK < rank) ||
+      svp_col_get(cur, dims, rank * sizeof(hsize_t)) ||
+      svp_col_get(cur, &tsize, sizeof(size_t)) ||
+      ((size_t)(cur->end - cur->pos) < tsize)) {
+    return 1;
+  }
+  *h5type = H5Tdecode(cur->pos);
+  cur->pos += tsize;
+  if ((0 > *h5type) || svp_col_get(cur, &opt.precision, sizeof(int)) ||
+      svp_col_get(cur, &out->filt, sizeof(struct svp_filter_t)) ||
+      svp_col_get(cur, &clen, sizeof(clen)) ||
+      svp_col_get(cur, &count, sizeof(count)) ||
+      svp_col_get(cur, &nsample, sizeof(nsample)) ||
+      svp_col_get(cur, &out->chunk_bytes, sizeof(out->chunk_bytes)) ||
+      svp_col_get(cur, &time_res, sizeof(double)) ||
+      svp_col_get(cur, &layout, sizeof(int)) ||
+      svp_hdf5_set_time_res(out, time_res) ||
+      svp_hdf5_set_layout(out, layout) ||
+      svp_col_get(cur, &nattr, sizeof(int))) {
+    return 1;
+  }
+  // Create the data store as the simulation did
+  for (int ii = 0; rank > ii; ++ii) {
+    idims[ii] = dims[ii];
+  }
+  opt.chunk = clen;
+  struct svp_dstore_t *dat = svp_dstore_create_opt(out, name, store_type,
+                                                   rank, idims, *h5type, &opt);
+  if (svp_hdf5_addsig(out, dat)) {
+    return 1;
+  }
+  // Compound types now belong to the data store
+  if (H5T_COMPOUND == H5Tget_class(*h5type)) {
+    *h5type = -1;
+  }
+  for (int ii = 0; nattr > ii; ++ii) {
+    const char *aname = svp_col_get_str(cur);
+    const char *avalue = svp_col_get_str(cur);
+    if (!aname || !avalue) {
+      return 1;
+    }
+    svp_dstore_svattr(dat, (char *)aname, (char *)avalue);
+  }
+  svp_dstore_expect(dat, count);
+  // Replay the records
+  const double *times = NULL;
+  if (SVP_STORE_SYNC_DATA != store_type) {
+    times = svp_col_map_read(dir, index, "time", count * sizeof(double));
+  }
+  const char *data = svp_col_map_read(dir, index, "data",
+                                      count * dat->cstride);
+  int err = (0 < count) && (!data || (!times && (SVP_STORE_SYNC_DATA !=
+                                                 store_type)));
+  if (err) {
+    fprintf(stderr, "ERROR %s: No samples for %s\n", __func__, name);
+  } else if (SVP_STORE_CHANGE_DATA == store_type) {
+    // Each change repeats until the index of the next one
+    const unsigned long long *idx = (const unsigned long long *)times;
+    for (unsigned long ii = 0; count > ii; ++ii) {
+      unsigned long long stop = (count > ii + 1) ? idx[ii + 1] : nsample;
+      for (unsigned long long jj = idx[ii]; stop > jj; ++jj) {
+        svp_dstore_write_data(dat, 0, data + ii * dat->cstride);
+      }
+    }
+  } else if (dat->tick) {
+    // The time column already holds ticks, which are passed through
+    svp_dstore_write_block_stamps(dat, count, (const long long *)times,
+                                  dat->tick, data);
+  } else {
+    svp_dstore_write_block(dat, count, times, data);
+  }
+  if (times) {
+    munmap((void *)times, count * sizeof(double));
+  }
+  if (data) {
+    munmap((void *)data, count * dat->cstride);
+  }
+  return err;
+}  // svp_col_convert_signal
+
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+int svp_colfile_convert(const char *dir, const char *h5name) {
+  // Read the whole manifest
+  char path[COL_PATH_MAX];
+  snprintf(path, sizeof(path), "%s/manifest", dir);
+  FILE *fp = fopen(path, "rb");
+  if (!fp) {
+    fprintf(stderr, "ERROR %s: Could not open %s\n", __func__, path);
+    return 1;
+  }
+  fseek(fp, 0, SEEK_END);
+  long nbytes = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  char *buf = malloc(nbytes + 1);
+  if (nbytes != (long)fread(buf, 1, nbytes, fp)) {
+    nbytes = 0;
+  }
+  fclose(fp);
+  size_t mlen = strlen(COL_MAGIC);
+  if (((size_t)nbytes < mlen) || memcmp(buf, COL_MAGIC, mlen)) {
+    fprintf(stderr, "ERROR %s: Not a column manifest: %s\n", __func__, path);
+    free(buf);
+    return 1;
+  }
+  struct svp_col_cursor_t cur = {buf + mlen, buf + nbytes};
+  // Written through the HDF5 backend, whatever SVP_BACKEND says
+  struct svp_hdf5_data *out = svp_hdf5_fopen_backend(h5name, "hdf5");
+  if (!out) {
+    free(buf);
+    return 1;
+  }
+  // Decoded atomic types are closed once the file is
+  int ntypes = 0;
+  hid_t *types = malloc(sizeof(hid_t));
+  int err = 0;
+  int done = 0;
+  while (!err && !done && (cur.pos < cur.end)) {
+    char tag = *cur.pos++;
+    switch (tag) {
+      case ('A') : {
+        const char *name = svp_col_get_str(&cur);
+        const char *value = svp_col_get_str(&cur);
+        err = !name || !value;
+        if (!err) {
+          svp_hdf5_add_attribute(out, (char *)name, (char *)value);
+        }
+        break;
+      }
+      case ('S') :
+        types = realloc(types, (ntypes + 1) * sizeof(hid_t));
+        err = svp_col_convert_signal(dir, &cur, out, &types[ntypes]);
+        ntypes += 1;
+        break;
+      case ('E') :
+        done = 1;
+        break;
+      default :
+        err = 1;
+    }
+  }
+  if (err) {
+    fprintf(stderr, "ERROR %s: Corrupt manifest: %s\n", __func__, path);
+  } else if (!done) {
+    fprintf(stderr, "WARNING %s: Manifest was not closed, the simulation may "
+            "not have finished: %s\n", __func__, path);
+  }
+  svp_hdf5_fclose(out);
+  for (int ii = 0; ntypes > ii; ++ii) {
+    if (0 <= types[ii]) {
+      H5Tclose(types[ii]);
+    }
+  }
+  free(types);
+  free(buf);
+  return err;
+}  // svp_colfile_convert
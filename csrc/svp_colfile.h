@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Column storage backend. Each data store appends its caches to raw column
+// files through shared memory mappings, with no HDF5 calls while the
+// simulation runs, and the directory is converted to HDF5 afterwards.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SVP__COLFILE__H__
+#define __SVP__COLFILE__H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hdf5.h"
+#include "svp_hdf5_defs.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief The column backend, selected with the name "column".
+ *
+ * The file name is a directory, which holds a manifest and for data store N
+ * the files N.data (records, as laid out in the data cache) and N.time
+ * (timestamps, or the sample index of each value change). The manifest
+ * describes each data store once it is closed, with its attributes.
+ */
+extern const struct svp_backend_t svp_backend_column;
+
+
+/**
+ * @brief Convert a directory written by the column backend to HDF5.
+ *
+ * @param dir Directory given to svp_hdf5_fopen_backend.
+ * @param h5name HDF5 file to be created, an existing file is overwritten.
+ * @return int Returns 0 if successful.
+ *
+ * The samples are written again through the HDF5 backend, with the settings
+ * of the original file, so the datasets are the same as if the simulation
+ * had written HDF5 directly.
+ */
+int svp_colfile_convert(const char *dir, const char *h5name);
+
+#endif
@@ -0,0 +1,35 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Command line converter of a directory written by the column backend to an
+// HDF5 file, with the same layout as a direct HDF5 dump.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+
+#include "svp_colfile.h"
+
+/**
+ * Usage: svp_convert <dir> <out.h5>
+ *
+ * dir: Directory given as the file name with SVP_BACKEND=column.
+ * out.h5: HDF5 file to be created.
+ */
+int main(int argc, char **argv) {
+  if (3 != argc) {
+    fprintf(stderr, "Usage: %s <dir> <out.h5>\n", argv[0]);
+    return 2;
+  }
+  return svp_colfile_convert(argv[1], argv[2]);
+}
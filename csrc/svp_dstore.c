@@ -13,10 +13,44 @@
 // ---------------
 // 12-Nov-22: Initial version.
 // 13-Nov-22: Added caching and hierarchical group paths.
+// 16-Oct-26: Full caches can be handed off to the background writer.
+// 16-Oct-26: Added expected size hint, persistent memory dataspace.
+// 16-Oct-26: Record the on-disk record layout for direct chunk writes.
+// 16-Oct-26: Added compression filters and creation options.
+// 16-Oct-26: Chunk and cache length chosen per data store.
+// 16-Oct-26: Caches are sized within the file memory budget.
+// 16-Oct-26: State and caches are allocated from the file arena.
+// 16-Oct-26: Keep a copy of the name, reject names already registered.
+// 16-Oct-26: Parent groups are looked up in the file group trie.
+// 16-Oct-26: Datasets can be created lazily, with the first sample.
+// 16-Oct-26: Added block writes of many samples.
+// 16-Oct-26: Added scalar writers taking the value directly.
+// 16-Oct-26: Added packed bit vector writers.
+// 16-Oct-26: Narrow integers can be stored as a packed bit stream.
+// 16-Oct-26: Added value-change storage of synchronous data.
+// 16-Oct-26: Rank 0 records (e.g. compound rows) are stored plain.
+// 16-Oct-26: Timestamps can be stored as integer ticks.
+// 16-Oct-26: Timestamps can be stored as a dataset of their own.
+// 16-Oct-26: Records larger than a chunk are split across chunks.
+// 16-Oct-26: Sample copies are timed, profiles kept at close.
+// 16-Oct-26: Storage is created, written and closed by the file backend.
+// 16-Oct-26: Signals of a sharded file are created in one of its shards.
+// 16-Oct-26: Data stores carry on in the next segment of a rolled over file.
+// 16-Oct-26: Ticks are cached as integers, added integer timestamp writers.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "svp_dstore.h"
+#include "svp_file.h"
+#include "svp_io.h"
+#include "svp_cache.h"
+#include "svp_zpool.h"
+#include "svp_arena.h"
+#include "svp_group.h"
+#include "svp_bits.h"
+#include "svp_prof.h"
+#include "svp_shard.h"
+#include "svp_roll.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // Internal functions
@@ -29,163 +63,902 @@
  * @param dat Data structure to be flushed.
  *
  * This method is used either before closing an HD5 file or each time the cache
- * is full, with CHUNK_SIZE entries. Writing the HD5 file in contiguous chunks
- * rather than element-by-element gains almost 100x speedup.
+ * is full, with clen entries. Writing the HD5 file in contiguous chunks
+ * rather than element-by-element gains almost 100x speedup. When the file has
+ * a background writer, full caches are queued rather than written in place.
  */
 void svp_dstore_flush(struct svp_dstore_t *dat) {
-  // Define the memory view of the cache source data
-  hsize_t mdims[1] = {};
-  mdims[0] = dat->cptr;
-  hid_t mspc = H5Screate_simple(1, mdims, NULL);
-  // Get the subspace from dataset
-  hid_t sspc = H5Dget_space(dat->dset);
-  // Define the hyperslab where data will be written
-  hsize_t cnt[1] = {0};
-  hsize_t ofst[1] = {0};
-  cnt[0] = dat->cptr;
-  ofst[0] = dat->wptr;
-  H5Sselect_hyperslab(sspc, H5S_SELECT_SET, ofst, NULL, cnt, NULL);
-  // Write data
-  if (dat->t_mid) {
-    H5Dwrite(dat->dset, dat->t_mid, mspc, sspc, dat->xfer_id, dat->tcache);
+  if (dat->file->async_io && (dat->clen == dat->cptr)) {
+    // Hand the cache off (this will update wptr/cptr)
+    svp_io_submit(dat);
+    return;
   }
-  // Write data (including svp_sim_time_t data)
-  H5Dwrite(dat->dset, dat->d_mid, mspc, sspc, dat->xfer_id, dat->dcache);
+  dat->file->backend->commit(dat, dat->tcache, dat->dcache, dat->wptr,
+                             dat->cptr);
   // Now update the write and cache pointers
   dat->wptr += dat->cptr;
   dat->cptr = 0;
-  // Close views
-  H5Sclose(sspc);
-  H5Sclose(mspc);
 }  // svp_dstore_flush
 
 
+/**
+ * @brief Release an attribute which was waiting for its dataset.
+ *
+ * @param dat Data store owning the attribute.
+ * @param attr Attribute to be released.
+ */
+static void svp_dstore_attr_free(struct svp_dstore_t *dat,
+                                 struct svp_attr_t *attr) {
+  struct svp_arena_t *arena = &dat->file->arena;
+  svp_arena_free(arena, (void *)attr->name, strlen(attr->name) + 1);
+  svp_arena_free(arena, (void *)attr->value, strlen(attr->value) + 1);
+  svp_arena_free(arena, attr, sizeof(struct svp_attr_t));
+}  // svp_dstore_attr_free
+
+
+/**
+ * @brief Release the record datatype, if it belongs to the data store.
+ *
+ * @param dat Data store object.
+ *
+ * Native atomic types are predefined by HDF5, compound types (e.g. the rows
+ * of svp_rows) are handed over to the data store when it is created.
+ */
+static void svp_dstore_type_free(struct svp_dstore_t *dat) {
+  if (H5T_COMPOUND == H5Tget_class(dat->h5type)) {
+    H5Tclose(dat->h5type);
+  }
+}  // svp_dstore_type_free
+
+
+/**
+ * @brief Build the datatype of the data of one record.
+ *
+ * @param dat Data store object.
+ * @param base Element datatype.
+ * @return hid_t Array of the record dimensions, or a copy of the element
+ * datatype for rank 0 records.
+ */
+static hid_t svp_dstore_array(const struct svp_dstore_t *dat, hid_t base) {
+  if (0 == dat->rank) {
+    return H5Tcopy(base);
+  }
+  return H5Tarray_create2(base, dat->rank, dat->dims);
+}  // svp_dstore_array
+
+
+/**
+ * @brief Choose the chunk dimensions of records larger than a chunk.
+ *
+ * @param dat Data store object, with its record dimensions.
+ * @param nbytes Target chunk size (bytes).
+ *
+ * Each chunk holds part of a single record. The innermost dimensions are
+ * kept whole while they fit, the next one is cut to fit and the outer ones
+ * are 1, so every chunk is a contiguous run of the record.
+ */
+static void svp_dstore_split(struct svp_dstore_t *dat, size_t nbytes) {
+  dat->cdims = svp_arena_alloc(&dat->file->arena,
+                               dat->rank * sizeof(hsize_t));
+  size_t inner = H5Tget_size(dat->h5type);
+  int ii = dat->rank - 1;
+  while ((0 <= ii) && (nbytes >= inner * dat->dims[ii])) {
+    dat->cdims[ii] = dat->dims[ii];
+    inner *= dat->dims[ii];
+    --ii;
+  }
+  if (0 <= ii) {
+    dat->cdims[ii] = (nbytes > inner) ? nbytes / inner : 1;
+    --ii;
+  }
+  while (0 <= ii) {
+    dat->cdims[ii] = 1;
+    --ii;
+  }
+}  // svp_dstore_split
+
+
+/**
+ * @brief Create the caches and the storage of a data store.
+ *
+ * @param dat Data store object, registered but not yet opened.
+ *
+ * This is done by svp_dstore_create, unless the file creates its datasets
+ * lazily, in which case it is deferred to the first write (or the close).
+ */
+static void svp_dstore_open(struct svp_dstore_t *dat) {
+  // Allocate the cache space, there is a time cache unless the data is
+  // synchronous
+  svp_cache_init(dat);
+  // Value changes are detected against the last sample
+  if (SVP_STORE_CHANGE_DATA == dat->store_type) {
+    dat->prev = svp_arena_alloc(&dat->file->arena, dat->cstride);
+  }
+  // The writer thread may be using the HDF5 library
+  svp_io_lock(dat->file);
+  dat->file->backend->open(dat);
+  svp_io_unlock(dat->file);
+}  // svp_dstore_open
+
+
 ///////////////////////////////////////////////////////////////////////////////
-// API
+// HDF5 backend
 ///////////////////////////////////////////////////////////////////////////////
 
-struct svp_dstore_t *svp_dstore_create(struct svp_hdf5_data *clsdat,
-                                       const char *name,
-                                       enum svp_storage_e store_type, int rank,
-                                       const int *dims, hid_t raw_type) {
-  // Allocate a new data structure and 0-initialize
-  struct svp_dstore_t *dat = malloc(sizeof(struct svp_dstore_t));
-  memset(dat, 0, sizeof(struct svp_dstore_t));
-  // First set any parameters that are simple
-  dat->name = name;
-  dat->store_type = store_type;
-  // Create a resizable dataspace
-  hsize_t cpd_dims[1] = {CHUNK_SIZE};
-  hsize_t cpd_maxdims[1] = {H5S_UNLIMITED};
-  hsize_t cpd_chunk_dims[1] = {CHUNK_SIZE};
-  dat->dspc = H5Screate_simple(1, cpd_dims, cpd_maxdims);
-
+void svp_dstore_h5open(struct svp_dstore_t *dat) {
+  struct svp_hdf5_data *clsdat = dat->file;
   // Create the transfer ID to allow non-contiguous writing of data
   dat->xfer_id = H5Pcreate(H5P_DATASET_XFER);
   H5Pset_preserve(dat->xfer_id, 1);
 
   // Determine what to do based on the storage enum
-  switch (store_type) {
+  switch (dat->store_type) {
     case (SVP_STORE_SIM_TIME) :
       // Handle svp_sim_time_t first, since it is the most different in terms
-      // of the dataset structure
-      dat->h5type = H5T_NATIVE_LONG;
-      dat->dims = malloc(sizeof(hsize_t));
-      dat->dims[0] = 1;
-      dat->rank = 1;
-      // Create the time memoryview, which is the remainder
+      // of the dataset structure. Create the time memoryview, which is the
+      // remainder
       dat->t_mid = H5Tcreate(H5T_COMPOUND, H5Tget_size(H5T_NATIVE_DOUBLE));
       H5Tinsert(dat->t_mid, "rem", 0, H5T_NATIVE_DOUBLE);
       // Create the data memoryview, which is the integer number of nanoseconds
       dat->d_mid = H5Tcreate(H5T_COMPOUND, H5Tget_size(H5T_NATIVE_LONG));
       H5Tinsert(dat->d_mid, "ns", 0, H5T_NATIVE_LONG);
-      // Create the compound datatype, which has the layout of svp_sim_time_t
-      dat->dtyp = H5Tcreate(H5T_COMPOUND, sizeof(struct svp_sim_time_t));
-      // Insert elements
-      H5Tinsert(dat->dtyp, "ns", HOFFSET(struct svp_sim_time_t, ns),
-                H5T_NATIVE_LONG);
-      H5Tinsert(dat->dtyp, "rem", HOFFSET(struct svp_sim_time_t, rem),
-                H5T_NATIVE_DOUBLE);
-      // Allocate both time and data caches
-      dat->cstride = H5Tget_size(H5T_NATIVE_LONG);
-      dat->tcache = (double *)malloc(CHUNK_SIZE * sizeof(double));
-      dat->dcache = malloc(CHUNK_SIZE * H5Tget_size(H5T_NATIVE_LONG));
+      if (dat->tick) {
+        // With an integer time base, ns and rem become a single tick count
+        dat->dtyp = H5Tcreate(H5T_COMPOUND, H5Tget_size(H5T_NATIVE_LLONG));
+        H5Tinsert(dat->dtyp, "time", 0, H5T_NATIVE_LLONG);
+      } else {
+        // Create the compound datatype, which has the layout of
+        // svp_sim_time_t
+        dat->dtyp = H5Tcreate(H5T_COMPOUND, sizeof(struct svp_sim_time_t));
+        // Insert elements
+        H5Tinsert(dat->dtyp, "ns", HOFFSET(struct svp_sim_time_t, ns),
+                  H5T_NATIVE_LONG);
+        H5Tinsert(dat->dtyp, "rem", HOFFSET(struct svp_sim_time_t, rem),
+                  H5T_NATIVE_DOUBLE);
+      }
+      // Records are interleaved in memory exactly as they are on disk
+      dat->r_mid = H5Tcopy(dat->dtyp);
       break;
+    case (SVP_STORE_CHANGE_DATA) :
     case (SVP_STORE_ASYNC_DATA) :
       // Do special setup particular to asynchronous data, then fall through to
       // the regular synchronous data setup. First create the memoryview of
-      // the double timestamps
-      dat->t_mid = H5Tcreate(H5T_COMPOUND, H5Tget_size(H5T_NATIVE_DOUBLE));
-      H5Tinsert(dat->t_mid, "time", 0, H5T_NATIVE_DOUBLE);
-      // Allocate cache space
-      dat->tcache = (double *)malloc(CHUNK_SIZE * sizeof(double));
-    case (SVP_STORE_SYNC_DATA) :
-      // Main data storage setup, for both synchronous and asynchronous types
-      dat->h5type = raw_type;
-      // Allocate dimension array, and check the data size
-      dat->dims = malloc(rank * sizeof(hsize_t));
-      dat->rank = rank;
-      hsize_t dim_prod = 1;
-      for (int ii = 0; rank > ii; ++ii) {
-        dat->dims[ii] = dims[ii];
-        dim_prod *= dims[ii];
+      // the double timestamps, or of the sample index of each value change
+      if (SVP_STORE_CHANGE_DATA == dat->store_type) {
+        dat->t_mid = H5Tcreate(H5T_COMPOUND, H5Tget_size(H5T_NATIVE_ULLONG));
+        H5Tinsert(dat->t_mid, "index", 0, H5T_NATIVE_ULLONG);
+      } else {
+        dat->t_mid = H5Tcreate(H5T_COMPOUND, H5Tget_size(H5T_NATIVE_DOUBLE));
+        H5Tinsert(dat->t_mid, "time", 0, H5T_NATIVE_DOUBLE);
       }
-      if (MAX_FLAT_SIZE < dim_prod) {
-        fprintf(stderr, "Data record size %ld exceeds maximum: %ld\n", dim_prod,
-                MAX_FLAT_SIZE);
-        return NULL;
+    case (SVP_STORE_SYNC_DATA) : {
+      // Main data storage setup, for both synchronous and asynchronous types.
+      // The stored element type, N-bit packing needs its precision reduced
+      hid_t e_tid = H5Tcopy(dat->h5type);
+      if (dat->filt.nbit && (H5T_INTEGER == H5Tget_class(dat->h5type)) &&
+          (0 < dat->precision) &&
+          (8 * H5Tget_size(dat->h5type) > (size_t)dat->precision)) {
+        H5Tset_precision(e_tid, dat->precision);
       }
       // Create the data memoryview
-      hid_t d_tid = H5Tarray_create2(raw_type, rank, dat->dims);
-      dat->d_mid = H5Tcreate(H5T_COMPOUND, H5Tget_size(d_tid));
-      H5Tinsert(dat->d_mid, "data", 0, d_tid);
-      // Create the compound datatype, check if this is async
-      hsize_t dofst = 0;
-      if (dat->t_mid) {
-        // We need to insert time in here
-        dat->dtyp = H5Tcreate(
-            H5T_COMPOUND, H5Tget_size(H5T_NATIVE_DOUBLE) + H5Tget_size(d_tid));
-        H5Tinsert(dat->dtyp, "time", 0, H5T_NATIVE_DOUBLE);
-        dofst = H5Tget_size(H5T_NATIVE_DOUBLE);
+      if (dat->pwidth) {
+        // Bit stream packed by svp_io_commit, written as plain bytes
+        dat->d_mid = H5Tcopy(H5T_NATIVE_UCHAR);
+        dat->dtyp = H5Tcopy(H5T_NATIVE_UCHAR);
+      } else if (dat->flat) {
+        // Plain array of elements, no compound wrapper
+        dat->d_mid = H5Tcopy(dat->h5type);
+        dat->dtyp = H5Tcopy(e_tid);
       } else {
-        dat->dtyp = H5Tcreate(H5T_COMPOUND, H5Tget_size(d_tid));
+        hid_t d_tid = svp_dstore_array(dat, dat->h5type);
+        dat->d_mid = H5Tcreate(H5T_COMPOUND, H5Tget_size(d_tid));
+        H5Tinsert(dat->d_mid, "data", 0, d_tid);
+        // Create the compound datatype, check if this is async
+        hid_t f_tid = svp_dstore_array(dat, e_tid);
+        if (dat->t_mid) {
+          // We need to insert time (or the change index) in here, integer
+          // ticks replace the double timestamps
+          hid_t t_tid = (dat->tick) ? H5Tcopy(H5T_NATIVE_LLONG)
+                                    : H5Tget_member_type(dat->t_mid, 0);
+          char *t_name = H5Tget_member_name(dat->t_mid, 0);
+          dat->dtyp = H5Tcreate(H5T_COMPOUND, dat->rstride);
+          H5Tinsert(dat->dtyp, t_name, dat->toffset, t_tid);
+          // Whole records are written from memory in the same layout
+          dat->r_mid = H5Tcreate(H5T_COMPOUND, dat->rstride);
+          H5Tinsert(dat->r_mid, t_name, dat->toffset, t_tid);
+          H5Tinsert(dat->r_mid, "data", dat->doffset, d_tid);
+          H5free_memory(t_name);
+          H5Tclose(t_tid);
+        } else {
+          dat->dtyp = H5Tcreate(H5T_COMPOUND, H5Tget_size(f_tid));
+        }
+        // Finally, insert the data
+        H5Tinsert(dat->dtyp, "data", dat->doffset, f_tid);
+        H5Tclose(f_tid);
+        H5Tclose(d_tid);
       }
-      // Finally, insert the data
-      H5Tinsert(dat->dtyp, "data", dofst, d_tid);
-      // Allocate the cache space
-      dat->cstride = H5Tget_size(d_tid);
-      dat->dcache = malloc(CHUNK_SIZE * H5Tget_size(d_tid));
+      H5Tclose(e_tid);
+    }
   }  // switch (svp_storage_e)
 
+  // Create a resizable dataspace, plain arrays carry the record dimensions
+  // and a packed bit stream is counted in bytes
+  dat->frank = (dat->flat && !dat->pwidth) ? 1 + dat->rank : 1;
+  hsize_t cpd_dims[H5S_MAX_RANK];
+  hsize_t cpd_maxdims[H5S_MAX_RANK];
+  cpd_dims[0] = svp_io_extent(dat, dat->clen);
+  cpd_maxdims[0] = H5S_UNLIMITED;
+  for (int ii = 1; dat->frank > ii; ++ii) {
+    cpd_dims[ii] = dat->dims[ii - 1];
+    cpd_maxdims[ii] = dat->dims[ii - 1];
+  }
+  dat->dspc = H5Screate_simple(dat->frank, cpd_dims, cpd_maxdims);
+  dat->mspc = H5Screate_simple(dat->frank, cpd_dims, NULL);
+  dat->size = dat->clen;
+  // Chunks hold a full cache, or part of a single record
+  hsize_t chk_dims[H5S_MAX_RANK];
+  memcpy(chk_dims, cpd_dims, dat->frank * sizeof(hsize_t));
+  if (dat->cdims) {
+    chk_dims[0] = 1;
+    memcpy(chk_dims + 1, dat->cdims, dat->rank * sizeof(hsize_t));
+  }
+
   // Create the hierarchical name
   hid_t prop = H5Pcreate(H5P_DATASET_CREATE);
-  H5Pset_chunk(prop, 1, cpd_chunk_dims);
-  hid_t gid;
-  char *sig_name;
-  svp_group_hierarchy_split(clsdat->fptr, name, &gid, &sig_name);
-  dat->dset = H5Dcreate2(gid, sig_name, dat->dtyp, dat->dspc, H5P_DEFAULT, prop,
-                         H5P_DEFAULT);
+  H5Pset_chunk(prop, dat->frank, chk_dims);
+  if (svp_filter_apply(prop, &dat->filt) < 0) {
+    fprintf(stderr, "WARNING %s: Could not apply filters to %s\n", __func__,
+            dat->name);
+  }
+  dat->nfilt = H5Pget_nfilters(prop);
+  const char *sig_name;
+  hid_t gid = svp_group_open(clsdat, dat->name, &sig_name);
+  if (dat->columns) {
+    // The signal is a group, with the time column named like the member of
+    // the time view, and the data
+    dat->tgrp = H5Gcreate2(gid, sig_name, H5P_DEFAULT, H5P_DEFAULT,
+                           H5P_DEFAULT);
+    dat->t_tid = (dat->tick) ? H5Tcopy(H5T_NATIVE_LLONG)
+                             : H5Tget_member_type(dat->t_mid, 0);
+    char *t_name = H5Tget_member_name(dat->t_mid, 0);
+    dat->tspc = H5Screate_simple(1, cpd_dims, cpd_maxdims);
+    dat->tmspc = H5Screate_simple(1, cpd_dims, NULL);
+    // The time column of split records is chunked to the byte target
+    hsize_t tchunk = (dat->cdims) ? clsdat->chunk_bytes / sizeof(double)
+                                  : dat->clen;
+    hid_t tprop = H5Pcopy(prop);
+    H5Pset_chunk(tprop, 1, &tchunk);
+    dat->tset = H5Dcreate2(dat->tgrp, t_name, dat->t_tid, dat->tspc,
+                           H5P_DEFAULT, tprop, H5P_DEFAULT);
+    H5Pclose(tprop);
+    H5free_memory(t_name);
+    dat->dset = H5Dcreate2(dat->tgrp, "data", dat->dtyp, dat->dspc,
+                           H5P_DEFAULT, prop, H5P_DEFAULT);
+    dat->aobj = dat->tgrp;
+  } else {
+    dat->dset = H5Dcreate2(gid, sig_name, dat->dtyp, dat->dspc, H5P_DEFAULT,
+                           prop, H5P_DEFAULT);
+    dat->aobj = dat->dset;
+  }
   H5Pclose(prop);
-  // Add attributes to the dataset
-  switch (store_type) {
+  // Add attributes to the dataset (or group)
+  switch (dat->store_type) {
     case (SVP_STORE_SIM_TIME) :
-      svp_add_attr(dat->dset, "storage", "time");
+      svp_add_attr(dat->aobj, "storage", "time");
       break;
     case (SVP_STORE_ASYNC_DATA) :
-      svp_add_attr(dat->dset, "storage", "async");
+      svp_add_attr(dat->aobj, "storage", "async");
       break;
     case (SVP_STORE_SYNC_DATA) :
-      svp_add_attr(dat->dset, "storage", "sync");
+      svp_add_attr(dat->aobj, "storage", "sync");
+      break;
+    case (SVP_STORE_CHANGE_DATA) :
+      svp_add_attr(dat->aobj, "storage", "change");
       break;
   }
+  // What a reader needs to decode integer ticks
+  if (dat->tick) {
+    char str[32];
+    snprintf(str, sizeof(str), "%.17g", clsdat->time_res);
+    svp_add_attr(dat->aobj, "time_res", str);
+    svp_add_attr(dat->aobj, "time_encoding", "delta");
+    snprintf(str, sizeof(str), "%lu", dat->clen);
+    svp_add_attr(dat->aobj, "time_chunk", str);
+  }
+  // What a reader needs to unpack the bit stream, the number of records is
+  // added when the data store is closed
+  if (dat->pwidth) {
+    char str[32];
+    snprintf(str, sizeof(str), "%d", dat->pwidth);
+    svp_add_attr(dat->aobj, "packed_width", str);
+    snprintf(str, sizeof(str), "%d", (H5T_SGN_2 == H5Tget_sign(dat->h5type)));
+    svp_add_attr(dat->aobj, "packed_signed", str);
+    char dstr[16 * H5S_MAX_RANK] = "";
+    for (int ii = 0; dat->rank > ii; ++ii) {
+      snprintf(str, sizeof(str), (ii) ? ",%llu" : "%llu",
+               (unsigned long long)dat->dims[ii]);
+      strcat(dstr, str);
+    }
+    svp_add_attr(dat->aobj, "packed_dims", dstr);
+  }
+  // Along with any that were added before the dataset existed, which a
+  // rolled over file adds again to every segment
+  struct svp_attr_t *attr;
+  for (attr = dat->attrs; attr; attr = attr->next) {
+    svp_add_attr(dat->aobj, (char *)attr->name, (char *)attr->value);
+  }
+  while (!clsdat->roll && (attr = dat->attrs)) {
+    dat->attrs = attr->next;
+    svp_dstore_attr_free(dat, attr);
+  }
+  // Pre-size the dataset, if a size was given before it existed
+  svp_io_reserve(dat, dat->expect);
+}  // svp_dstore_h5open
+
+
+void svp_dstore_h5close(struct svp_dstore_t *dat) {
+  // Shrink down to the number of data points written
+  hsize_t cdims[H5S_MAX_RANK];
+  cdims[0] = svp_io_extent(dat, dat->wptr);
+  for (int ii = 1; dat->frank > ii; ++ii) {
+    cdims[ii] = dat->dims[ii - 1];
+  }
+  unsigned long long start = svp_prof_start(dat);
+  H5Dset_extent(dat->dset, cdims);
+  if (dat->tset) {
+    H5Dset_extent(dat->tset, cdims);
+  }
+  svp_prof_stop(&dat->prof.t_extent, start);
+  // The last byte of a packed stream may hold padding
+  if (dat->pwidth) {
+    char str[32];
+    snprintf(str, sizeof(str), "%lu", dat->wptr);
+    svp_add_attr(dat->aobj, "packed_count", str);
+  }
+  // Samples after the last change repeat it
+  if (SVP_STORE_CHANGE_DATA == dat->store_type) {
+    char str[32];
+    snprintf(str, sizeof(str), "%lu", dat->nsample);
+    svp_add_attr(dat->aobj, "change_count", str);
+  }
+  // Close everything that was open
+  if (dat->d_mid) {
+    H5Tclose(dat->d_mid);
+  }
+  if (dat->t_mid) {
+    H5Tclose(dat->t_mid);
+  }
+  if (dat->r_mid) {
+    H5Tclose(dat->r_mid);
+  }
+  H5Pclose(dat->xfer_id);
+  H5Dclose(dat->dset);
+  H5Tclose(dat->dtyp);
+  H5Sclose(dat->mspc);
+  H5Sclose(dat->dspc);
+  if (dat->tset) {
+    H5Dclose(dat->tset);
+    H5Tclose(dat->t_tid);
+    H5Sclose(dat->tmspc);
+    H5Sclose(dat->tspc);
+    H5Gclose(dat->tgrp);
+  }
+}  // svp_dstore_h5close
+
+
+void svp_dstore_h5attr(struct svp_dstore_t *dat, const char *name,
+                       const char *value) {
+  svp_add_attr(dat->aobj, (char *)name, (char *)value);
+}  // svp_dstore_h5attr
+
+
+/**
+ * @brief Make room in a full cache.
+ *
+ * @param dat Data store whose cache is full (cptr equals ccap).
+ */
+static void svp_dstore_full(struct svp_dstore_t *dat) {
+  if (dat->clen == dat->cptr) {
+    // Flush the cache (this will update wptr/cptr and grow the dataset)
+    svp_dstore_flush(dat);
+  } else {
+    // Grow the cache, or flush early if over the memory budget
+    svp_cache_full(dat);
+  }
+  // A rolled over file moves on to its next segment at its limits
+  if (dat->file->roll) {
+    svp_roll_count(dat);
+  }
+}  // svp_dstore_full
+
+
+/**
+ * @brief Convert an integer timestamp to ticks of the time base.
+ *
+ * @param dat Data store with an integer time base.
+ * @param stamp Timestamp, in units of 1 / per_ns ns.
+ * @param per_ns Timestamp units per ns (FS_PER_NS for fs).
+ * @return long long Nearest tick.
+ *
+ * Whole ns and the units left over are scaled apart, so the product neither
+ * overflows nor goes through a double.
+ */
+static inline long long svp_dstore_tick_of(const struct svp_dstore_t *dat,
+                                           long long stamp, long long per_ns) {
+  long long ns = stamp / per_ns;
+  long long rem = stamp % per_ns;
+  return ns * dat->tick + (rem * dat->tick + per_ns / 2) / per_ns;
+}  // svp_dstore_tick_of
+
+
+/**
+ * @brief Get the cache slot of the next sample, storing its timestamp.
+ *
+ * @param dat Data store object.
+ * @param simtime Timestamp (ns), stored if the data store keeps timestamps
+ * as doubles.
+ * @param tick Timestamp in ticks, stored instead if it has a time base.
+ * @return unsigned long Index of the sample within the data cache.
+ */
+static inline unsigned long svp_dstore_slot_at(struct svp_dstore_t *dat,
+                                               double simtime,
+                                               long long tick) {
+  // The dataset is created with the first sample
+  if (!dat->dcache) {
+    svp_dstore_open(dat);
+  }
+  // Which may be the first of the next segment (time stores only pass the
+  // remainder, and are left to the other signals)
+  if ((dat->file->roll_at <= simtime) &&
+      (SVP_STORE_SIM_TIME != dat->store_type)) {
+    svp_roll_time(dat->file, simtime);
+  }
+  if (dat->tcache && dat->tick) {
+    dat->tcache[dat->cptr].tick = tick;
+  } else if (dat->tcache) {
+    dat->tcache[dat->cptr].time = simtime;
+  }
+  return dat->cptr;
+}  // svp_dstore_slot_at
+
+
+/**
+ * @brief Get the cache slot of the next sample, with a double timestamp.
+ *
+ * @param dat Data store object.
+ * @param simtime Timestamp (ns), rounded to the nearest tick if the data
+ * store has a time base.
+ * @return unsigned long Index of the sample within the data cache.
+ */
+static inline unsigned long svp_dstore_slot(struct svp_dstore_t *dat,
+                                            double simtime) {
+  long long tick = (dat->tick) ? llround(simtime * dat->tick) : 0;
+  return svp_dstore_slot_at(dat, simtime, tick);
+}  // svp_dstore_slot
+
+
+/**
+ * @brief Get the cache slot of the next sample, with an integer timestamp.
+ *
+ * @param dat Data store object.
+ * @param stamp Timestamp, in units of 1 / per_ns ns.
+ * @param per_ns Timestamp units per ns.
+ * @return unsigned long Index of the sample within the data cache.
+ */
+static inline unsigned long svp_dstore_slot_stamp(struct svp_dstore_t *dat,
+                                                  long long stamp,
+                                                  long long per_ns) {
+  long long tick = (dat->tick) ? svp_dstore_tick_of(dat, stamp, per_ns) : 0;
+  return svp_dstore_slot_at(dat, stamp / (double)per_ns, tick);
+}  // svp_dstore_slot_stamp
+
+
+/**
+ * @brief Store the timestamps of a block of samples in the time cache.
+ *
+ * @param dat Data store object, with room in its cache for num samples.
+ * @param num Number of samples.
+ * @param times Timestamps (ns), or NULL to use stamps.
+ * @param stamps Integer timestamps, in units of 1 / per_ns ns.
+ * @param per_ns Integer timestamp units per ns.
+ */
+static void svp_dstore_stamps(struct svp_dstore_t *dat, unsigned long num,
+                              const double *times, const long long *stamps,
+                              long long per_ns) {
+  union svp_tstamp_u *tptr = dat->tcache + dat->cptr;
+  for (unsigned long ii = 0; (num > ii) && dat->tick; ++ii) {
+    tptr[ii].tick = (times) ? llround(times[ii] * dat->tick)
+                            : svp_dstore_tick_of(dat, stamps[ii], per_ns);
+  }
+  for (unsigned long ii = 0; (num > ii) && !dat->tick; ++ii) {
+    tptr[ii].time = (times) ? times[ii] : stamps[ii] / (double)per_ns;
+  }
+}  // svp_dstore_stamps
+
+
+/**
+ * @brief Check whether a cached sample differs from the last one.
+ *
+ * @param dat Value-change data store.
+ * @return int Non-zero if the sample is a change, which is then recorded
+ * with its index. The first sample is always a change.
+ */
+static int svp_dstore_changed(struct svp_dstore_t *dat) {
+  const char *rec = (const char *)dat->dcache + dat->cptr * dat->cstride;
+  unsigned long long idx = dat->nsample;
+  dat->nsample += 1;
+  if (idx && (0 == memcmp(rec, dat->prev, dat->cstride))) {
+    return 0;
+  }
+  memcpy(dat->prev, rec, dat->cstride);
+  // The time cache holds the sample index instead of a timestamp
+  dat->tcache[dat->cptr].index = idx;
+  return 1;
+}  // svp_dstore_changed
+
+
+/**
+ * @brief Complete a sample stored by svp_dstore_slot.
+ *
+ * @param dat Data store object.
+ *
+ * Samples of a value-change data store which repeat the last one are
+ * dropped here, their cache slot is reused by the next sample.
+ */
+static inline void svp_dstore_push(struct svp_dstore_t *dat) {
+  if (dat->prev && !svp_dstore_changed(dat)) {
+    return;
+  }
+  dat->cptr += 1;
+  if (dat->ccap == dat->cptr) {
+    svp_dstore_full(dat);
+  }
+}  // svp_dstore_push
+
+
+/**
+ * @brief Copy a sample into its cache slot, and complete it.
+ *
+ * @param dat Data store object.
+ * @param slot Cache slot of the sample, from svp_dstore_slot.
+ * @param buf Sample to be copied.
+ */
+static inline void svp_dstore_copy(struct svp_dstore_t *dat,
+                                   unsigned long slot, const void *buf) {
+  unsigned long long start = svp_prof_start(dat);
+  memcpy((char *)dat->dcache + slot * dat->cstride, buf, dat->cstride);
+  svp_prof_stop(&dat->prof.t_copy, start);
+  // Increment cache pointer, and check if the cache is full
+  svp_dstore_push(dat);
+}  // svp_dstore_copy
+
+
+/**
+ * @brief Write many samples, with timestamps of either kind.
+ *
+ * @param dat Data store object.
+ * @param num Number of samples.
+ * @param times Timestamps (ns), or NULL to use stamps.
+ * @param stamps Integer timestamps, in units of 1 / per_ns ns, or NULL.
+ * @param per_ns Integer timestamp units per ns.
+ * @param buf Samples to be written, one record after another.
+ * @return int 0 if successful.
+ */
+static int svp_dstore_block(struct svp_dstore_t *dat, long num,
+                            const double *times, const long long *stamps,
+                            long long per_ns, const void *buf) {
+  // Value changes are found one sample at a time
+  if (SVP_STORE_CHANGE_DATA == dat->store_type) {
+    for (long ii = 0; num > ii; ++ii) {
+      svp_dstore_write_data(dat, 0, (const char *)buf + ii * dat->cstride);
+    }
+    return 0;
+  }
+  // The dataset is created with the first sample
+  if ((0 < num) && !dat->dcache) {
+    svp_dstore_open(dat);
+  }
+  // A block is kept in the segment of its first timestamp
+  if ((times || stamps) && (0 < num)) {
+    double first = (times) ? times[0] : stamps[0] / (double)per_ns;
+    if (dat->file->roll_at <= first) {
+      svp_roll_time(dat->file, first);
+    }
+  }
+  if (dat->tcache && !times && !stamps && (0 < num)) {
+    fprintf(stderr, "ERROR %s: Timestamps are needed for %s\n", __func__,
+            dat->name);
+    return 1;
+  }
+  const char *dsrc = (const char *)buf;
+  while (0 < num) {
+    // Copy as much as fits in the cache
+    unsigned long ncpy = dat->ccap - dat->cptr;
+    if (ncpy > (unsigned long)num) {
+      ncpy = num;
+    }
+    unsigned long long start = svp_prof_start(dat);
+    if (dat->tcache) {
+      svp_dstore_stamps(dat, ncpy, times, stamps, per_ns);
+      if (times) {
+        times += ncpy;
+      } else {
+        stamps += ncpy;
+      }
+    }
+    memcpy((char *)dat->dcache + dat->cptr * dat->cstride, dsrc,
+           ncpy * dat->cstride);
+    svp_prof_stop(&dat->prof.t_copy, start);
+    dsrc += ncpy * dat->cstride;
+    dat->cptr += ncpy;
+    num -= ncpy;
+    // Check if the cache is full
+    if (dat->ccap == dat->cptr) {
+      svp_dstore_full(dat);
+    }
+  }
+  return 0;
+}  // svp_dstore_block
+
+
+/**
+ * @brief Check that packed lanes fill the records of a data store.
+ *
+ * @param dat Data store object.
+ * @param width Bits per lane.
+ * @param size Number of lanes.
+ * @return int 0 if they match.
+ */
+static int svp_dstore_lanes(const struct svp_dstore_t *dat, int width,
+                            int size) {
+  if (svp_bits_esize(width) * size != dat->cstride) {
+    fprintf(stderr, "ERROR %s: %d x %d bits does not match %s\n", __func__,
+            size, width, dat->name);
+    return 1;
+  }
+  return 0;
+}  // svp_dstore_lanes
+
+
+/**
+ * @brief Unpack a bit vector into its cache slot, and complete the sample.
+ *
+ * @param dat Data store object, whose records match the lanes.
+ * @param slot Cache slot of the sample, from svp_dstore_slot.
+ * @param vec Packed vector (see svp_dstore_write_packed).
+ * @param width Bits per lane.
+ * @param size Number of lanes.
+ * @param is_signed Sign-extend each lane, else zero-extend.
+ */
+static void svp_dstore_unpack(struct svp_dstore_t *dat, unsigned long slot,
+                              const svBitVecVal *vec, int width, int size,
+                              int is_signed) {
+  unsigned long long start = svp_prof_start(dat);
+  svp_bits_unpack((char *)dat->dcache + slot * dat->cstride, vec, width, size,
+                  is_signed);
+  svp_prof_stop(&dat->prof.t_copy, start);
+  svp_dstore_push(dat);
+}  // svp_dstore_unpack
+
+
+/**
+ * @brief Narrow integers into their cache slot, and complete the sample.
+ *
+ * @param dat Data store object, whose records hold num integers.
+ * @param slot Cache slot of the sample, from svp_dstore_slot_stamp.
+ * @param vals Integers to be stored, truncated to the element size.
+ * @param num Number of integers.
+ */
+static void svp_dstore_narrow(struct svp_dstore_t *dat, unsigned long slot,
+                              const long long *vals, long num) {
+  unsigned long long start = svp_prof_start(dat);
+  char *dst = (char *)dat->dcache + slot * dat->cstride;
+  for (long ii = 0; num > ii; ++ii) {
+    switch (dat->cstride / num) {
+      case 1: ((signed char *)dst)[ii] = (signed char)vals[ii]; break;
+      case 2: ((short *)dst)[ii] = (short)vals[ii]; break;
+      case 4: ((int *)dst)[ii] = (int)vals[ii]; break;
+      default: ((long long *)dst)[ii] = vals[ii]; break;
+    }
+  }
+  svp_prof_stop(&dat->prof.t_copy, start);
+  svp_dstore_push(dat);
+}  // svp_dstore_narrow
+
+
+/**
+ * @brief Check that records hold num integers of a supported size.
+ *
+ * @param dat Data store object.
+ * @param num Number of integers per record.
+ * @return int 0 if they match.
+ */
+static int svp_dstore_ints(const struct svp_dstore_t *dat, long num) {
+  long esize = (0 < num) ? dat->cstride / num : 0;
+  if ((SVP_STORE_SIM_TIME == dat->store_type) || (0 >= num) ||
+      ((size_t)(esize * num) != dat->cstride) ||
+      ((1 != esize) && (2 != esize) && (4 != esize) && (8 != esize))) {
+    fprintf(stderr, "ERROR %s: %ld integers do not match %s\n", __func__, num,
+            dat->name);
+    return 1;
+  }
+  return 0;
+}  // svp_dstore_ints
+
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+struct svp_dstore_t *svp_dstore_create(struct svp_hdf5_data *clsdat,
+                                       const char *name,
+                                       enum svp_storage_e store_type, int rank,
+                                       const int *dims, hid_t raw_type) {
+  return svp_dstore_create_opt(clsdat, name, store_type, rank, dims, raw_type,
+                               NULL);
+}  // svp_dstore_create
+
+
+struct svp_dstore_t *svp_dstore_create_opt(struct svp_hdf5_data *clsdat,
+                                           const char *name,
+                                           enum svp_storage_e store_type,
+                                           int rank, const int *dims,
+                                           hid_t raw_type,
+                                           const struct svp_dstore_opt_t *opt) {
+  // Names must be unique within the file
+  if (svp_hdf5_getsig(clsdat, name)) {
+    fprintf(stderr, "ERROR %s: Signal already exists: %s\n", __func__, name);
+    return NULL;
+  }
+  // A sharded file hands each signal to one of its shards
+  if (clsdat->nshards) {
+    clsdat = svp_shard_pick(clsdat);
+  }
+  // Time is stored as a single long (and a remainder), whatever was asked
+  static const int time_dims[1] = {1};
+  if (SVP_STORE_SIM_TIME == store_type) {
+    raw_type = H5T_NATIVE_LONG;
+    rank = 1;
+    dims = time_dims;
+  }
+  // Check the data size
+  long dim_prod = 1;
+  for (int ii = 0; rank > ii; ++ii) {
+    dim_prod *= dims[ii];
+  }
+  if (1 > dim_prod) {
+    fprintf(stderr, "ERROR %s: Invalid record size %ld: %s\n", __func__,
+            dim_prod, name);
+    return NULL;
+  }
+  // Allocate a new data structure and 0-initialize
+  struct svp_dstore_t *dat = svp_arena_alloc(&clsdat->arena,
+                                             sizeof(struct svp_dstore_t));
+  memset(dat, 0, sizeof(struct svp_dstore_t));
+  // First set any parameters that are simple, the name may be a temporary
+  // string from the simulator so keep a copy
+  char *name_cpy = svp_arena_alloc(&clsdat->arena, strlen(name) + 1);
+  strcpy(name_cpy, name);
+  dat->name = name_cpy;
+  dat->file = clsdat;
+  dat->store_type = store_type;
+  // Resolve the compression filters
+  dat->filt = clsdat->filt;
+  if (opt && opt->filt && opt->filt[0]) {
+    if (svp_filter_parse(opt->filt, &dat->filt)) {
+      svp_arena_free(&clsdat->arena, name_cpy, strlen(name_cpy) + 1);
+      svp_arena_free(&clsdat->arena, dat, sizeof(struct svp_dstore_t));
+      return NULL;
+    }
+  }
+  dat->precision = (opt) ? opt->precision : 0;
+  // Scale-offset can only be applied to plain integer datasets, this is only
+  // worth a warning if it was explicitly requested for this signal
+  if (dat->filt.scaleoffset && ((SVP_STORE_SYNC_DATA != store_type) ||
+                                (H5T_INTEGER != H5Tget_class(raw_type)))) {
+    if (opt && opt->filt && opt->filt[0]) {
+      fprintf(stderr, "WARNING %s: scaleoffset needs sync integer data: %s\n",
+              __func__, name);
+    }
+    dat->filt.scaleoffset = 0;
+  }
+  // Bit packing only pays off for synchronous single-byte integers narrower
+  // than their byte, which is how the SV bit dumps store WIDTH < 8
+  if (dat->filt.bitpack) {
+    if ((SVP_STORE_SYNC_DATA == store_type) &&
+        (H5T_INTEGER == H5Tget_class(raw_type)) &&
+        (1 == H5Tget_size(raw_type)) && (0 < dat->precision) &&
+        (8 > dat->precision)) {
+      dat->pwidth = dat->precision;
+    } else if (opt && opt->filt && opt->filt[0]) {
+      fprintf(stderr, "WARNING %s: bitpack needs sync integers < 8 bits: %s\n",
+              __func__, name);
+    }
+  }
+  // Records larger than a chunk are split across several chunks, which
+  // needs a plain array (bit streams are chunked in bytes anyway)
+  size_t rsize = dim_prod * H5Tget_size(raw_type);
+  int large = (rsize > clsdat->chunk_bytes) && !dat->pwidth &&
+              (SVP_STORE_SIM_TIME != store_type);
+  // Timestamps may be kept apart from the data, which is then a plain array
+  dat->columns = ((SVP_LAYOUT_COLUMN == clsdat->layout) || large) &&
+                 ((SVP_STORE_ASYNC_DATA == store_type) ||
+                  (SVP_STORE_CHANGE_DATA == store_type));
+  // Records without dimensions are single elements, stored as they are
+  // unless they need a timestamp
+  dat->flat = dat->filt.scaleoffset || dat->pwidth || dat->columns || large ||
+              ((0 == rank) && (SVP_STORE_SYNC_DATA == store_type));
+  // Timestamps are stored as integer ticks if the file has a time base
+  if ((0 < clsdat->time_res) && ((SVP_STORE_SIM_TIME == store_type) ||
+                                 (SVP_STORE_ASYNC_DATA == store_type))) {
+    dat->tick = lround(1e-9 / clsdat->time_res);
+  }
+  // Description of the records
+  dat->h5type = raw_type;
+  dat->rank = rank;
+  dat->dims = svp_arena_alloc(&clsdat->arena, rank * sizeof(hsize_t));
+  for (int ii = 0; rank > ii; ++ii) {
+    dat->dims[ii] = dims[ii];
+  }
+  if (large) {
+    svp_dstore_split(dat, clsdat->chunk_bytes);
+  }
+  // Describe where the caches land in each on-disk record, these match the
+  // HDF5 types built when the dataset is created
+  dat->cstride = rsize;
+  if ((SVP_STORE_SIM_TIME == store_type) && dat->tick) {
+    // A single tick count replaces ns and rem
+    dat->rstride = sizeof(long long);
+  } else if (SVP_STORE_SIM_TIME == store_type) {
+    dat->rstride = sizeof(struct svp_sim_time_t);
+    dat->doffset = HOFFSET(struct svp_sim_time_t, ns);
+    dat->toffset = HOFFSET(struct svp_sim_time_t, rem);
+  } else if (((SVP_STORE_ASYNC_DATA == store_type) ||
+              (SVP_STORE_CHANGE_DATA == store_type)) && !dat->columns) {
+    dat->rstride = sizeof(double) + dat->cstride;
+    dat->toffset = 0;
+    dat->doffset = sizeof(double);
+  } else {
+    dat->rstride = dat->cstride;
+  }
+  // Size the chunks from the on-disk record size, unless overridden. When
+  // records are split across chunks this only sets the cache length, which
+  // is at least one record
+  if (opt && opt->chunk) {
+    dat->clen = opt->chunk;
+  } else {
+    // A separate time column still takes cache memory
+    size_t rbytes = dat->rstride + ((dat->columns) ? sizeof(double) : 0);
+    dat->clen = clsdat->chunk_bytes / rbytes;
+  }
+  if (1 > dat->clen) {
+    dat->clen = 1;
+  }
+  // Packed chunks must end on a byte boundary
+  dat->palign = 1;
+  if (dat->pwidth) {
+    while ((dat->palign * dat->pwidth * dat->cstride) % 8) {
+      dat->palign += 1;
+    }
+    dat->clen = dat->palign * ((dat->clen + dat->palign - 1) / dat->palign);
+  }
+  // The dataset is created now, or when the first sample arrives
+  if (SVP_LAZY_OFF == clsdat->lazy) {
+    svp_dstore_open(dat);
+  }
   // Return the data structure handle
   return dat;
-}  // svp_dstore_create
+}  // svp_dstore_create_opt
 
 
 struct svp_dstore_t *svp_dstore_svcreate(struct svp_hdf5_data *clsdat,
                                          const char *name, int is_async,
-                                         int width, const char *dtype) {
+                                         int width, const char *dtype,
+                                         int precision, const char *filt) {
+  // Creation options
+  struct svp_dstore_opt_t opt = {};
+  opt.filt = filt;
+  opt.precision = precision;
   // Single dimensional array
   int dims[1] = {0};
   dims[0] = width;
@@ -194,118 +967,171 @@ struct svp_dstore_t *svp_dstore_svcreate(struct svp_hdf5_data *clsdat,
   if (strcmp(dtype, "time") == 0) {
     // If we store time, ignore other parameters
     store_type = SVP_STORE_SIM_TIME;
+  } else if (2 == is_async) {
+    // Only samples which differ from the previous one are stored
+    store_type = SVP_STORE_CHANGE_DATA;
   } else {
     // Check if we store sync or async data
     store_type = (is_async) ? SVP_STORE_ASYNC_DATA : SVP_STORE_SYNC_DATA;
   }
-  // Switch based on data type
-  if (strcmp(dtype, "char") == 0) {
-    return svp_dstore_create(clsdat, name, store_type, 1, dims,
-                             H5T_NATIVE_CHAR);
-  } else if (strcmp(dtype, "uchar") == 0) {
-    return svp_dstore_create(clsdat, name, store_type, 1, dims,
-                             H5T_NATIVE_UCHAR);
-  } else if (strcmp(dtype, "sint") == 0) {
-    return svp_dstore_create(clsdat, name, store_type, 1, dims,
-                             H5T_NATIVE_SHORT);
-  } else if (strcmp(dtype, "usint") == 0) {
-    return svp_dstore_create(clsdat, name, store_type, 1, dims,
-                             H5T_NATIVE_USHORT);
-  } else if (strcmp(dtype, "int") == 0) {
-    return svp_dstore_create(clsdat, name, store_type, 1, dims,
-                             H5T_NATIVE_INT);
-  } else if (strcmp(dtype, "uint") == 0) {
-    return svp_dstore_create(clsdat, name, store_type, 1, dims,
-                             H5T_NATIVE_UINT);
-  } else if (strcmp(dtype, "long") == 0) {
-    return svp_dstore_create(clsdat, name, store_type, 1, dims,
-                             H5T_NATIVE_LONG);
-  } else if (strcmp(dtype, "ulong") == 0) {
-    return svp_dstore_create(clsdat, name, store_type, 1, dims,
-                             H5T_NATIVE_ULONG);
-  } else if (strcmp(dtype, "double") == 0) {
-    return svp_dstore_create(clsdat, name, store_type, 1, dims,
-                             H5T_NATIVE_DOUBLE);
-  } else if (strcmp(dtype, "time") == 0) {
-    return svp_dstore_create(clsdat, name, store_type, 1, dims,
-                             H5T_NATIVE_DOUBLE);
-  } else {
+  // Look up the data type, time is stored as a double
+  hid_t raw_type = (SVP_STORE_SIM_TIME == store_type) ? H5T_NATIVE_DOUBLE
+                                                      : svp_dtype_lookup(dtype);
+  if (0 > raw_type) {
     fprintf(stderr, "ERROR %s: Unknown dtype: %s\n", __func__, dtype);
+    return NULL;
   }
-  // IF we reach here, something is wrong
-  return NULL;
+  return svp_dstore_create_opt(clsdat, name, store_type, 1, dims, raw_type,
+                               &opt);
 }  // svp_dstore_svcreate
 
 
 void svp_dstore_close(struct svp_dstore_t *dat) {
-  // Flush any outstanding data
+  struct svp_arena_t *arena = &dat->file->arena;
+  // Signals which were never written are created empty, or left out
+  if (!dat->dcache) {
+    if (SVP_LAZY_SKIP == dat->file->lazy) {
+      struct svp_attr_t *attr;
+      while ((attr = dat->attrs)) {
+        dat->attrs = attr->next;
+        svp_dstore_attr_free(dat, attr);
+      }
+      svp_dstore_type_free(dat);
+      svp_arena_free(arena, dat->cdims, dat->rank * sizeof(hsize_t));
+      svp_arena_free(arena, dat->dims, dat->rank * sizeof(hsize_t));
+      svp_arena_free(arena, (void *)dat->name, strlen(dat->name) + 1);
+      svp_arena_free(arena, dat, sizeof(struct svp_dstore_t));
+      return;
+    }
+    svp_dstore_open(dat);
+  }
+  // Wait for any queued write, then flush outstanding data
+  svp_io_wait(dat);
+  svp_io_lock(dat->file);
   svp_dstore_flush(dat);
-  // Resize the dataspace to only contain the number of elements written
-  hid_t sspc = H5Dget_space(dat->dset);
-  hsize_t cdims[1];
-  H5Sget_simple_extent_dims(sspc, cdims, NULL);
-  // Shrink down to the number of data points written
-  cdims[0] = dat->wptr;
-  H5Dset_extent(dat->dset, cdims);
-  H5Sclose(sspc);
-  // Close everything that was open
-  if (dat->d_mid) {
-    H5Tclose(dat->d_mid);
+  // Finish the dataset (or whatever the backend stores)
+  dat->file->backend->close(dat);
+  svp_dstore_type_free(dat);
+  svp_io_unlock(dat->file);
+  // The file reports the profiles once all signals are closed
+  if (dat->file->profile) {
+    svp_prof_keep(dat);
   }
-  if (dat->t_mid) {
-    H5Tclose(dat->t_mid);
+  // Attributes the backend kept until now
+  struct svp_attr_t *attr;
+  while ((attr = dat->attrs)) {
+    dat->attrs = attr->next;
+    svp_dstore_attr_free(dat, attr);
   }
-  H5Pclose(dat->xfer_id);
-  H5Dclose(dat->dset);
-  H5Tclose(dat->dtyp);
-  H5Sclose(dat->dspc);
-  // Free the cache data
-  if (dat->dims) {
-    free(dat->dims);
+  // Return the cache data to the arena for reuse, the file releases it all
+  svp_arena_free(arena, dat->cdims, dat->rank * sizeof(hsize_t));
+  svp_arena_free(arena, dat->dims, dat->rank * sizeof(hsize_t));
+  svp_cache_free(dat);
+  svp_arena_free(arena, dat->prev, dat->cstride);
+  svp_arena_free(arena, dat->ccache, dat->clen * dat->rstride);
+  svp_zpool_free(dat);
+  // Free the data
+  svp_arena_free(arena, (void *)dat->name, strlen(dat->name) + 1);
+  svp_arena_free(arena, dat, sizeof(struct svp_dstore_t));
+}  // svp_dstore_close
+
+
+void svp_dstore_finish(struct svp_dstore_t *dat) {
+  if (!dat->dcache) {
+    return;
+  }
+  // Write out what is cached in place, then finish the dataset
+  svp_io_wait(dat);
+  svp_io_lock(dat->file);
+  dat->file->backend->commit(dat, dat->tcache, dat->dcache, dat->wptr,
+                             dat->cptr);
+  dat->wptr += dat->cptr;
+  dat->cptr = 0;
+  dat->file->backend->close(dat);
+  svp_io_unlock(dat->file);
+  // The next dataset starts from scratch, its first sample is a change
+  dat->wptr = 0;
+  dat->rcount = 0;
+  dat->nsample = 0;
+}  // svp_dstore_finish
+
+
+void svp_dstore_reopen(struct svp_dstore_t *dat) {
+  if (!dat->dcache) {
+    return;
   }
-  if (dat->tcache) {
-    free(dat->tcache);
+  svp_io_lock(dat->file);
+  dat->file->backend->open(dat);
+  svp_io_unlock(dat->file);
+}  // svp_dstore_reopen
+
+
+void svp_dstore_expect(struct svp_dstore_t *dat, long num) {
+  dat->expect = num;
+  // Without a dataset yet, this is applied when it is created
+  if (!dat->dcache) {
+    return;
   }
-  if (dat->dcache) {
-    free(dat->dcache);
+  // Pre-size the storage now if it is smaller than the expectation
+  if (!dat->file->backend->reserve) {
+    return;
   }
-  // Free the data
-  free(dat);
-}  // svp_dstore_close
+  svp_io_wait(dat);
+  svp_io_lock(dat->file);
+  dat->file->backend->reserve(dat, dat->expect);
+  svp_io_unlock(dat->file);
+}  // svp_dstore_expect
 
 
 void svp_dstore_svattr(struct svp_dstore_t *dat, char *name, char *value) {
-  svp_add_attr(dat->dset, name, value);
+  int apply = dat->dcache && dat->file->backend->attr;
+  // Without a dataset yet, keep a copy until it is created (or until the
+  // close, if the backend keeps them). Rolled over files add them again to
+  // every segment
+  if (!apply || dat->file->roll) {
+    struct svp_arena_t *arena = &dat->file->arena;
+    struct svp_attr_t *attr = svp_arena_alloc(arena,
+                                              sizeof(struct svp_attr_t));
+    char *name_cpy = svp_arena_alloc(arena, strlen(name) + 1);
+    char *value_cpy = svp_arena_alloc(arena, strlen(value) + 1);
+    strcpy(name_cpy, name);
+    strcpy(value_cpy, value);
+    attr->name = name_cpy;
+    attr->value = value_cpy;
+    attr->next = NULL;
+    // Keep them in order
+    struct svp_attr_t **tail = &dat->attrs;
+    while (*tail) {
+      tail = &(*tail)->next;
+    }
+    *tail = attr;
+  }
+  if (!apply) {
+    return;
+  }
+  svp_io_lock(dat->file);
+  dat->file->backend->attr(dat, name, value);
+  svp_io_unlock(dat->file);
 }  // svp_dstore_svattr
 
 
 int svp_dstore_write_data(struct svp_dstore_t *dat, double simtime,
                           const void *buf) {
-  // Write timestamp to the time cache if this is async signal
-  if (dat->t_mid) {
-    dat->tcache[dat->cptr] = simtime;
-  }
-  // Compute the memory address for next data sample
-  void *dptr = (void *)((char *)dat->dcache + (dat->cptr * dat->cstride));
-  // Copy chunk of bytes
-  memcpy(dptr, buf, dat->cstride);
-  // Increment cache pointer
-  dat->cptr += 1;
+  // Store the timestamp (if this is async signal), then the data sample
+  svp_dstore_copy(dat, svp_dstore_slot(dat, simtime), buf);
+  return 0;
+}  // svp_dstore_write_data
 
-  // Check if the cache is full
-  if (CHUNK_SIZE == dat->cptr) {
-    // First flush the cache (this will update wptr/cptr)
-    svp_dstore_flush(dat);
-    // Increase size of dataset
-    hid_t sspc = H5Dget_space(dat->dset);
-    hsize_t cdims[1];
-    H5Sget_simple_extent_dims(sspc, cdims, NULL);
-    cdims[0] += CHUNK_SIZE;
-    H5Dset_extent(dat->dset, cdims);
-    H5Sclose(sspc);
+
+int svp_dstore_write_stamp(struct svp_dstore_t *dat, long long stamp,
+                           long long per_ns, const void *buf) {
+  if (SVP_STORE_SIM_TIME == dat->store_type) {
+    fprintf(stderr, "This signal: %s has the wrong storage type!\n", dat->name);
+    return 1;
   }
+  svp_dstore_copy(dat, svp_dstore_slot_stamp(dat, stamp, per_ns), buf);
   return 0;
-}  // svp_dstore_write_data
+}  // svp_dstore_write_stamp
 
 
 int svp_dstore_write_time(struct svp_dstore_t *dat,
@@ -315,30 +1141,27 @@ int svp_dstore_write_time(struct svp_dstore_t *dat,
     fprintf(stderr, "This signal: %s has the wrong storage type!\n", dat->name);
     return 1;
   }
-
-  // Compute the memory address for the next svp_sim_time_t
-  dat->tcache[dat->cptr] = simtime.rem;
-  long *dptr = (long *)((char *)dat->dcache + (dat->cptr * dat->cstride));
-  *dptr = simtime.ns;
-  // Increment cache pointer
-  dat->cptr += 1;
-
-  // Check if the cache is full
-  if (CHUNK_SIZE == dat->cptr) {
-    // First flush the cache (this will update wptr/cptr)
-    svp_dstore_flush(dat);
-    // Increase size of dataset
-    hid_t sspc = H5Dget_space(dat->dset);
-    hsize_t cdims[1];
-    H5Sget_simple_extent_dims(sspc, cdims, NULL);
-    cdims[0] += CHUNK_SIZE;
-    H5Dset_extent(dat->dset, cdims);
-    H5Sclose(sspc);
-  }
+  // The remainder goes to the time cache
+  unsigned long slot = svp_dstore_slot(dat, simtime.rem);
+  ((long *)dat->dcache)[slot] = simtime.ns;
+  svp_dstore_push(dat);
   return 0;
 }  // svp_dstore_write_time
 
 
+int svp_dstore_write_block(struct svp_dstore_t *dat, long num,
+                           const double *times, const void *buf) {
+  return svp_dstore_block(dat, num, times, NULL, 1, buf);
+}  // svp_dstore_write_block
+
+
+int svp_dstore_write_block_stamps(struct svp_dstore_t *dat, long num,
+                                  const long long *stamps, long long per_ns,
+                                  const void *buf) {
+  return svp_dstore_block(dat, num, NULL, stamps, per_ns, buf);
+}  // svp_dstore_write_block_stamps
+
+
 inline int svp_dstore_write_int8(struct svp_dstore_t *dat, double simtime,
                                   const svOpenArrayHandle dbuf) {
   void *dptr = svGetArrayPtr(dbuf);
@@ -372,3 +1195,181 @@ inline int svp_dstore_write_float64(struct svp_dstore_t *dat, double simtime,
   void *dptr = svGetArrayPtr(dbuf);
   return svp_dstore_write_data(dat, simtime, dptr);
 }  // svp_dstore_write_float64
+
+
+inline int svp_dstore_write_block_int8(struct svp_dstore_t *dat, int num,
+                                       const svOpenArrayHandle tbuf,
+                                       const svOpenArrayHandle dbuf) {
+  return svp_dstore_write_block(dat, num, svGetArrayPtr(tbuf),
+                                svGetArrayPtr(dbuf));
+}  // svp_dstore_write_block_int8
+
+
+inline int svp_dstore_write_block_int16(struct svp_dstore_t *dat, int num,
+                                        const svOpenArrayHandle tbuf,
+                                        const svOpenArrayHandle dbuf) {
+  return svp_dstore_write_block(dat, num, svGetArrayPtr(tbuf),
+                                svGetArrayPtr(dbuf));
+}  // svp_dstore_write_block_int16
+
+
+inline int svp_dstore_write_block_int32(struct svp_dstore_t *dat, int num,
+                                        const svOpenArrayHandle tbuf,
+                                        const svOpenArrayHandle dbuf) {
+  return svp_dstore_write_block(dat, num, svGetArrayPtr(tbuf),
+                                svGetArrayPtr(dbuf));
+}  // svp_dstore_write_block_int32
+
+
+inline int svp_dstore_write_block_int64(struct svp_dstore_t *dat, int num,
+                                        const svOpenArrayHandle tbuf,
+                                        const svOpenArrayHandle dbuf) {
+  return svp_dstore_write_block(dat, num, svGetArrayPtr(tbuf),
+                                svGetArrayPtr(dbuf));
+}  // svp_dstore_write_block_int64
+
+
+inline int svp_dstore_write_block_float64(struct svp_dstore_t *dat, int num,
+                                          const svOpenArrayHandle tbuf,
+                                          const svOpenArrayHandle dbuf) {
+  return svp_dstore_write_block(dat, num, svGetArrayPtr(tbuf),
+                                svGetArrayPtr(dbuf));
+}  // svp_dstore_write_block_float64
+
+
+int svp_dstore_write_scalar_int8(struct svp_dstore_t *dat, double simtime,
+                                 char val) {
+  unsigned long slot = svp_dstore_slot(dat, simtime);
+  ((char *)dat->dcache)[slot] = val;
+  svp_dstore_push(dat);
+  return 0;
+}  // svp_dstore_write_scalar_int8
+
+
+int svp_dstore_write_scalar_int16(struct svp_dstore_t *dat, double simtime,
+                                  short val) {
+  unsigned long slot = svp_dstore_slot(dat, simtime);
+  ((short *)dat->dcache)[slot] = val;
+  svp_dstore_push(dat);
+  return 0;
+}  // svp_dstore_write_scalar_int16
+
+
+int svp_dstore_write_scalar_int32(struct svp_dstore_t *dat, double simtime,
+                                  int val) {
+  unsigned long slot = svp_dstore_slot(dat, simtime);
+  ((int *)dat->dcache)[slot] = val;
+  svp_dstore_push(dat);
+  return 0;
+}  // svp_dstore_write_scalar_int32
+
+
+int svp_dstore_write_scalar_int64(struct svp_dstore_t *dat, double simtime,
+                                  long long val) {
+  unsigned long slot = svp_dstore_slot(dat, simtime);
+  ((long long *)dat->dcache)[slot] = val;
+  svp_dstore_push(dat);
+  return 0;
+}  // svp_dstore_write_scalar_int64
+
+
+int svp_dstore_write_scalar_float64(struct svp_dstore_t *dat, double simtime,
+                                    double val) {
+  unsigned long slot = svp_dstore_slot(dat, simtime);
+  ((double *)dat->dcache)[slot] = val;
+  svp_dstore_push(dat);
+  return 0;
+}  // svp_dstore_write_scalar_float64
+
+
+int svp_dstore_write_packed(struct svp_dstore_t *dat, double simtime,
+                            const svBitVecVal *vec, int width, int size,
+                            int is_signed) {
+  if (svp_dstore_lanes(dat, width, size)) {
+    return 1;
+  }
+  svp_dstore_unpack(dat, svp_dstore_slot(dat, simtime), vec, width, size,
+                    is_signed);
+  return 0;
+}  // svp_dstore_write_packed
+
+
+int svp_dstore_write_bitvec(struct svp_dstore_t *dat, double simtime,
+                            const svOpenArrayHandle dbuf, int width, int size,
+                            int is_signed) {
+  return svp_dstore_write_packed(dat, simtime, svGetArrayPtr(dbuf), width,
+                                 size, is_signed);
+}  // svp_dstore_write_bitvec
+
+
+int svp_dstore_write_bitvec_block(struct svp_dstore_t *dat, int num,
+                                  const svOpenArrayHandle tbuf,
+                                  const svOpenArrayHandle dbuf, int width,
+                                  int size, int is_signed) {
+  const double *times = svGetArrayPtr(tbuf);
+  const svBitVecVal *vec = svGetArrayPtr(dbuf);
+  // Only async stores keep timestamps, value changes keep sample indices
+  // (the caches may not exist before the first sample)
+  if ((SVP_STORE_ASYNC_DATA == dat->store_type) && !times && (0 < num)) {
+    fprintf(stderr, "ERROR %s: Timestamps are needed for %s\n", __func__,
+            dat->name);
+    return 1;
+  }
+  // Each element of the array starts on a new word
+  long nwords = svp_bits_nwords(width, size);
+  for (int ii = 0; num > ii; ++ii) {
+    if (svp_dstore_write_packed(dat, (times) ? times[ii] : 0,
+                                vec + ii * nwords, width, size, is_signed)) {
+      return 1;
+    }
+  }
+  return 0;
+}  // svp_dstore_write_bitvec_block
+
+
+int svp_dstore_write_stamp_int(struct svp_dstore_t *dat, long long stamp,
+                               long long per_ns, long long val) {
+  if (svp_dstore_ints(dat, 1)) {
+    return 1;
+  }
+  svp_dstore_narrow(dat, svp_dstore_slot_stamp(dat, stamp, per_ns), &val, 1);
+  return 0;
+}  // svp_dstore_write_stamp_int
+
+
+int svp_dstore_write_stamp_real(struct svp_dstore_t *dat, long long stamp,
+                                long long per_ns, double val) {
+  return svp_dstore_write_stamp(dat, stamp, per_ns, &val);
+}  // svp_dstore_write_stamp_real
+
+
+int svp_dstore_write_stamp_ints(struct svp_dstore_t *dat, long long stamp,
+                                long long per_ns,
+                                const svOpenArrayHandle dbuf, int size) {
+  if (svp_dstore_ints(dat, size)) {
+    return 1;
+  }
+  svp_dstore_narrow(dat, svp_dstore_slot_stamp(dat, stamp, per_ns),
+                    svGetArrayPtr(dbuf), size);
+  return 0;
+}  // svp_dstore_write_stamp_ints
+
+
+int svp_dstore_write_stamp_reals(struct svp_dstore_t *dat, long long stamp,
+                                 long long per_ns,
+                                 const svOpenArrayHandle dbuf) {
+  return svp_dstore_write_stamp(dat, stamp, per_ns, svGetArrayPtr(dbuf));
+}  // svp_dstore_write_stamp_reals
+
+
+int svp_dstore_write_stamp_bitvec(struct svp_dstore_t *dat, long long stamp,
+                                  long long per_ns,
+                                  const svOpenArrayHandle dbuf, int width,
+                                  int size, int is_signed) {
+  if (svp_dstore_lanes(dat, width, size)) {
+    return 1;
+  }
+  svp_dstore_unpack(dat, svp_dstore_slot_stamp(dat, stamp, per_ns),
+                    svGetArrayPtr(dbuf), width, size, is_signed);
+  return 0;
+}  // svp_dstore_write_stamp_bitvec
@@ -13,6 +13,20 @@
 // ---------------
 // 12-Nov-22: Initial version
 // 13-Nov-22: Added time datatype, removed max dimensions limit.
+// 16-Oct-26: Added expected size hint.
+// 16-Oct-26: Added creation options (compression filters).
+// 16-Oct-26: Added chunk length option.
+// 16-Oct-26: Datasets may be created on the first write.
+// 16-Oct-26: Added block writes of many samples.
+// 16-Oct-26: Added scalar writers taking the value directly.
+// 16-Oct-26: Added packed bit vector writers.
+// 16-Oct-26: Added value-change storage.
+// 16-Oct-26: Added rank 0 (e.g. compound) records.
+// 16-Oct-26: Records larger than a chunk, without a size limit.
+// 16-Oct-26: Added the HDF5 backend functions.
+// 16-Oct-26: Data stores can be finished and reopened in a new segment.
+// 16-Oct-26: Added writers taking integer timestamps.
+// 16-Oct-26: Options moved to svp_dstore_create_opt, keeping the old call.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -41,6 +55,36 @@
  * @param dims Size of each dimension.
  * @param raw_type Underlying HD5 atomic datatype.
  * @return struct svp_dstore_t* Data store object for future writing.
+ *
+ * SVP_STORE_CHANGE_DATA takes synchronous samples, but compares each one to
+ * the previous sample and only stores changes, as (index, data) records where
+ * index counts all samples written. The total number of samples is stored in
+ * the change_count attribute when the data store is closed, so a reader can
+ * expand the changes back into one record per sample.
+ *
+ * With rank 0 each record is a single element of raw_type, and the dataset
+ * is a plain array of them. This is how svp_rows stores a compound row per
+ * sample. A compound raw_type is owned by the data store from here on, and
+ * closed with it.
+ *
+ * Synchronous integer data compressed with scale-offset is stored as a plain
+ * (N, dims...) array rather than a compound dataset, since HDF5 cannot apply
+ * that filter to compound types.
+ *
+ * Each HDF5 chunk, and the memory cache which fills it, holds as many records
+ * as fit in the file chunk target (see svp_hdf5_set_chunk_bytes), but at least
+ * one. The option chunk sets the number of records directly.
+ *
+ * Records larger than the chunk target are stored as a plain (N, dims...)
+ * array, chunked across the record dimensions so that each chunk holds a
+ * contiguous part of one record of about the target size. Timestamps of
+ * such records are stored as a separate column (see svp_hdf5_set_layout).
+ * The cache then holds the option chunk records, or as many as fit in the
+ * chunk target but at least one, and is written out whenever it is full.
+ *
+ * If the file creates datasets lazily (see svp_hdf5_set_lazy), only the
+ * description of the data is recorded here, and the dataset and caches are
+ * created with the first write.
  */
 struct svp_dstore_t *svp_dstore_create(struct svp_hdf5_data *clsdat,
                                        const char *name,
@@ -48,14 +92,38 @@ struct svp_dstore_t *svp_dstore_create(struct svp_hdf5_data *clsdat,
                                        const int *dims, hid_t raw_type);
 
 
+/**
+ * @brief Create a new data storage, with optional settings.
+ *
+ * @param clsdat Data structure containing HDF5 file pointer.
+ * @param name Fully-qualified signal name.
+ * @param store_type Specify the type of signal to be stored.
+ * @param rank Number of dimensions.
+ * @param dims Size of each dimension.
+ * @param raw_type Underlying HD5 atomic datatype.
+ * @param opt Optional settings, NULL to use the file defaults (the same as
+ * svp_dstore_create).
+ * @return struct svp_dstore_t* Data store object for future writing.
+ */
+struct svp_dstore_t *svp_dstore_create_opt(struct svp_hdf5_data *clsdat,
+                                           const char *name,
+                                           enum svp_storage_e store_type,
+                                           int rank, const int *dims,
+                                           hid_t raw_type,
+                                           const struct svp_dstore_opt_t *opt);
+
+
 /**
  * @brief Wrapper for easier calling via DPI.
  *
  * @param clsdat Data structure containing HDF5 file pointer.
  * @param name Fully-qualified signal name.
- * @param is_async Stores timestamp along with data.
+ * @param is_async 1 stores a timestamp along with the data, 2 stores only
+ * the samples which differ from the previous one (SVP_STORE_CHANGE_DATA).
  * @param width Assumes single-dimensional arrays.
  * @param dtype String version of type.
+ * @param precision Significant bits of integer data (for N-bit), 0 for all.
+ * @param filt Compression filter spec, "" for the file default.
  * @return struct svp_dstore_t* Data store object for future writing.
  *
  * Current datatypes supported: char, uchar, sint, usint, int, uint, long,
@@ -63,7 +131,8 @@ struct svp_dstore_t *svp_dstore_create(struct svp_hdf5_data *clsdat,
  */
 struct svp_dstore_t *svp_dstore_svcreate(struct svp_hdf5_data *clsdat,
                                          const char *name, int is_async,
-                                         int width, const char *dtype);
+                                         int width, const char *dtype,
+                                         int precision, const char *filt);
 
 
 /**
@@ -77,6 +146,42 @@ struct svp_dstore_t *svp_dstore_svcreate(struct svp_hdf5_data *clsdat,
 void svp_dstore_close(struct svp_dstore_t *dat);
 
 
+/**
+ * @brief Write out a data store and finish its storage, keeping the data
+ * store itself, so that its file can be closed.
+ *
+ * @param dat Data store object, left alone if it has no storage yet.
+ *
+ * The storage is finished as svp_dstore_close would, and the data store then
+ * counts its samples from 0 again.
+ */
+void svp_dstore_finish(struct svp_dstore_t *dat);
+
+
+/**
+ * @brief Create the storage of a finished data store again, in the file it
+ * now refers to.
+ *
+ * @param dat Data store finished by svp_dstore_finish.
+ *
+ * Attributes are added again from the copies kept by the data store.
+ */
+void svp_dstore_reopen(struct svp_dstore_t *dat);
+
+
+/**
+ * @brief Provide the expected total number of elements to be written.
+ *
+ * @param dat Data store object.
+ * @param num Expected number of elements.
+ *
+ * The dataset is grown to this size up front, instead of geometrically as
+ * data arrives. Writing more or fewer elements than expected is allowed, the
+ * dataset is trimmed to the actual size when the data store is closed.
+ */
+void svp_dstore_expect(struct svp_dstore_t *dat, long num);
+
+
 /**
  * @brief Add a string attribute to HDF5 dataset.
  *
@@ -102,6 +207,61 @@ int svp_dstore_write_data(struct svp_dstore_t *dat, double simtime,
                           const void *buf);
 
 
+/**
+ * @brief Write a data point, with an integer timestamp.
+ *
+ * @param dat Data store object, not SVP_STORE_SIM_TIME.
+ * @param stamp Timestamp, in units of 1 / per_ns ns.
+ * @param per_ns Timestamp units per ns, e.g. FS_PER_NS for $time in a 1fs
+ * scope.
+ * @param buf Data to be written (see svp_dstore_write_data).
+ * @return int 0 if successful.
+ *
+ * With a time base the tick is worked out from stamp in integers, so it is
+ * exact at any simulation time, where a double ns timestamp only holds every
+ * fs up to 2^53 fs (about 9 s). Without one, stamp is converted to ns.
+ */
+int svp_dstore_write_stamp(struct svp_dstore_t *dat, long long stamp,
+                           long long per_ns, const void *buf);
+
+
+/**
+ * @brief Write many data points to the data storage at once.
+ *
+ * @param dat Data store object for the matching data type to be written.
+ * @param num Number of samples.
+ * @param times Timestamp of each sample, needed if the data store keeps
+ * timestamps (the remainders, for SVP_STORE_SIM_TIME), else ignored and may
+ * be NULL.
+ * @param buf Samples to be written, one record after another. No type or
+ * dimension checking is done on this data.
+ * @return int 0 if successful.
+ *
+ * This is equivalent to num calls of svp_dstore_write_data (or
+ * svp_dstore_write_time), but the samples are copied into the cache with one
+ * memcpy per cache fill.
+ */
+int svp_dstore_write_block(struct svp_dstore_t *dat, long num,
+                           const double *times, const void *buf);
+
+
+/**
+ * @brief Write many data points, with exact integer timestamps.
+ *
+ * @param dat Data store object for the matching data type to be written.
+ * @param num Number of samples.
+ * @param stamps Timestamp of each sample, in units of 1 / per_ns ns (see
+ * svp_dstore_write_block).
+ * @param per_ns Timestamp units per ns: FS_PER_NS for fs, or the ticks per
+ * ns of the data store to pass its ticks through unchanged.
+ * @param buf Samples to be written, one record after another.
+ * @return int 0 if successful.
+ */
+int svp_dstore_write_block_stamps(struct svp_dstore_t *dat, long num,
+                                  const long long *stamps, long long per_ns,
+                                  const void *buf);
+
+
 /**
  * @brief Write specifically the high resolution time data.
  *
@@ -177,4 +337,329 @@ int svp_dstore_write_int64(struct svp_dstore_t *dat, double simtime,
 int svp_dstore_write_float64(struct svp_dstore_t *dat, double simtime,
                              const svOpenArrayHandle dbuf);
 
+
+/**
+ * @brief Explicit typed block write for DPI interface.
+ *
+ * @param dat Data store object for the matching data type to be written.
+ * @param num Number of samples.
+ * @param tbuf Alias of double*, the timestamp of each sample (see
+ * svp_dstore_write_block).
+ * @param dbuf Alias of void*, num records one after another.
+ * @return int 0 if successful.
+ */
+int svp_dstore_write_block_int8(struct svp_dstore_t *dat, int num,
+                                const svOpenArrayHandle tbuf,
+                                const svOpenArrayHandle dbuf);
+
+
+/**
+ * @brief Explicit typed block write for DPI interface.
+ *
+ * @param dat Data store object for the matching data type to be written.
+ * @param num Number of samples.
+ * @param tbuf Alias of double*, the timestamp of each sample (see
+ * svp_dstore_write_block).
+ * @param dbuf Alias of void*, num records one after another.
+ * @return int 0 if successful.
+ */
+int svp_dstore_write_block_int16(struct svp_dstore_t *dat, int num,
+                                 const svOpenArrayHandle tbuf,
+                                 const svOpenArrayHandle dbuf);
+
+
+/**
+ * @brief Explicit typed block write for DPI interface.
+ *
+ * @param dat Data store object for the matching data type to be written.
+ * @param num Number of samples.
+ * @param tbuf Alias of double*, the timestamp of each sample (see
+ * svp_dstore_write_block).
+ * @param dbuf Alias of void*, num records one after another.
+ * @return int 0 if successful.
+ */
+int svp_dstore_write_block_int32(struct svp_dstore_t *dat, int num,
+                                 const svOpenArrayHandle tbuf,
+                                 const svOpenArrayHandle dbuf);
+
+
+/**
+ * @brief Explicit typed block write for DPI interface.
+ *
+ * @param dat Data store object for the matching data type to be written.
+ * @param num Number of samples.
+ * @param tbuf Alias of double*, the timestamp of each sample (see
+ * svp_dstore_write_block).
+ * @param dbuf Alias of void*, num records one after another.
+ * @return int 0 if successful.
+ */
+int svp_dstore_write_block_int64(struct svp_dstore_t *dat, int num,
+                                 const svOpenArrayHandle tbuf,
+                                 const svOpenArrayHandle dbuf);
+
+
+/**
+ * @brief Explicit typed block write for DPI interface.
+ *
+ * @param dat Data store object for the matching data type to be written.
+ * @param num Number of samples.
+ * @param tbuf Alias of double*, the timestamp of each sample (see
+ * svp_dstore_write_block).
+ * @param dbuf Alias of void*, num records one after another.
+ * @return int 0 if successful.
+ */
+int svp_dstore_write_block_float64(struct svp_dstore_t *dat, int num,
+                                   const svOpenArrayHandle tbuf,
+                                   const svOpenArrayHandle dbuf);
+
+
+/**
+ * @brief Write a single char value, passed by value from DPI.
+ *
+ * @param dat Data store object holding scalar records of this type.
+ * @param simtime (optional) For asynchronous data storage, the simtime must
+ * also be provided that is written alongside the data. For SVP_STORE_SIM_TIME
+ * this is the remainder.
+ * @param val Data to be written.
+ * @return int 0 if successful.
+ *
+ * The value is stored directly into its cache slot, without the open array
+ * handle and memcpy of svp_dstore_write_int8 and friends.
+ */
+int svp_dstore_write_scalar_int8(struct svp_dstore_t *dat, double simtime,
+                                 char val);
+
+
+/**
+ * @brief Write a single short value, passed by value from DPI.
+ *
+ * @param dat Data store object holding scalar records of this type.
+ * @param simtime (optional) For asynchronous data storage, the simtime must
+ * also be provided that is written alongside the data. For SVP_STORE_SIM_TIME
+ * this is the remainder.
+ * @param val Data to be written.
+ * @return int 0 if successful.
+ *
+ * The value is stored directly into its cache slot, without the open array
+ * handle and memcpy of svp_dstore_write_int8 and friends.
+ */
+int svp_dstore_write_scalar_int16(struct svp_dstore_t *dat, double simtime,
+                                  short val);
+
+
+/**
+ * @brief Write a single int value, passed by value from DPI.
+ *
+ * @param dat Data store object holding scalar records of this type.
+ * @param simtime (optional) For asynchronous data storage, the simtime must
+ * also be provided that is written alongside the data. For SVP_STORE_SIM_TIME
+ * this is the remainder.
+ * @param val Data to be written.
+ * @return int 0 if successful.
+ *
+ * The value is stored directly into its cache slot, without the open array
+ * handle and memcpy of svp_dstore_write_int8 and friends.
+ */
+int svp_dstore_write_scalar_int32(struct svp_dstore_t *dat, double simtime,
+                                  int val);
+
+
+/**
+ * @brief Write a single long long value, passed by value from DPI.
+ *
+ * @param dat Data store object holding scalar records of this type.
+ * @param simtime (optional) For asynchronous data storage, the simtime must
+ * also be provided that is written alongside the data. For SVP_STORE_SIM_TIME
+ * this is the remainder.
+ * @param val Data to be written.
+ * @return int 0 if successful.
+ *
+ * The value is stored directly into its cache slot, without the open array
+ * handle and memcpy of svp_dstore_write_int8 and friends.
+ */
+int svp_dstore_write_scalar_int64(struct svp_dstore_t *dat, double simtime,
+                                  long long val);
+
+
+/**
+ * @brief Write a single double value, passed by value from DPI.
+ *
+ * @param dat Data store object holding scalar records of this type.
+ * @param simtime (optional) For asynchronous data storage, the simtime must
+ * also be provided that is written alongside the data. For SVP_STORE_SIM_TIME
+ * this is the remainder.
+ * @param val Data to be written.
+ * @return int 0 if successful.
+ *
+ * The value is stored directly into its cache slot, without the open array
+ * handle and memcpy of svp_dstore_write_int8 and friends.
+ */
+int svp_dstore_write_scalar_float64(struct svp_dstore_t *dat, double simtime,
+                                    double val);
+
+
+/**
+ * @brief Write a packed bit vector, unpacked into an array of integers.
+ *
+ * @param dat Data store object holding size integers per record, each the
+ * smallest integer type which fits width bits.
+ * @param simtime (optional) For asynchronous data storage, the simtime must
+ * also be provided that is written alongside the data.
+ * @param vec Packed vector bit [size-1:0][width-1:0], in the canonical DPI
+ * layout.
+ * @param width Bits per lane.
+ * @param size Number of lanes.
+ * @param is_signed Sign-extend each lane, else zero-extend.
+ * @return int 0 if successful.
+ *
+ * The lanes are unpacked directly into the cache (see svp_bits_unpack).
+ */
+int svp_dstore_write_packed(struct svp_dstore_t *dat, double simtime,
+                            const svBitVecVal *vec, int width, int size,
+                            int is_signed);
+
+
+/**
+ * @brief Explicit packed bit vector call for DPI interface.
+ *
+ * @param dat Data store object (see svp_dstore_write_packed).
+ * @param simtime (optional) For asynchronous data storage, the simtime must
+ * also be provided that is written alongside the data.
+ * @param dbuf Open packed array (bit []), dereferenced with svGetArrayPtr.
+ * @param width Bits per lane.
+ * @param size Number of lanes.
+ * @param is_signed Sign-extend each lane, else zero-extend.
+ * @return int 0 if successful.
+ */
+int svp_dstore_write_bitvec(struct svp_dstore_t *dat, double simtime,
+                            const svOpenArrayHandle dbuf, int width, int size,
+                            int is_signed);
+
+
+/**
+ * @brief Explicit packed bit vector block write for DPI interface.
+ *
+ * @param dat Data store object (see svp_dstore_write_packed).
+ * @param num Number of samples.
+ * @param tbuf Alias of double*, the timestamp of each sample (see
+ * svp_dstore_write_block).
+ * @param dbuf Open array of packed vectors (bit [] x []), each element
+ * starting on a new 32-bit word.
+ * @param width Bits per lane.
+ * @param size Number of lanes.
+ * @param is_signed Sign-extend each lane, else zero-extend.
+ * @return int 0 if successful.
+ */
+int svp_dstore_write_bitvec_block(struct svp_dstore_t *dat, int num,
+                                  const svOpenArrayHandle tbuf,
+                                  const svOpenArrayHandle dbuf, int width,
+                                  int size, int is_signed);
+
+
+/**
+ * @brief Write a single integer, with an integer timestamp, from DPI.
+ *
+ * @param dat Data store object holding scalar integer records.
+ * @param stamp Timestamp (see svp_dstore_write_stamp).
+ * @param per_ns Timestamp units per ns.
+ * @param val Data to be written, truncated to the record size.
+ * @return int 0 if successful.
+ */
+int svp_dstore_write_stamp_int(struct svp_dstore_t *dat, long long stamp,
+                               long long per_ns, long long val);
+
+
+/**
+ * @brief Write a single double, with an integer timestamp, from DPI.
+ *
+ * @param dat Data store object holding scalar double records.
+ * @param stamp Timestamp (see svp_dstore_write_stamp).
+ * @param per_ns Timestamp units per ns.
+ * @param val Data to be written.
+ * @return int 0 if successful.
+ */
+int svp_dstore_write_stamp_real(struct svp_dstore_t *dat, long long stamp,
+                                long long per_ns, double val);
+
+
+/**
+ * @brief Write an array of integers, with an integer timestamp, from DPI.
+ *
+ * @param dat Data store object holding arrays of size integers.
+ * @param stamp Timestamp (see svp_dstore_write_stamp).
+ * @param per_ns Timestamp units per ns.
+ * @param dbuf Alias of long long*, each element truncated to the element
+ * size of the records.
+ * @param size Number of elements.
+ * @return int 0 if successful.
+ */
+int svp_dstore_write_stamp_ints(struct svp_dstore_t *dat, long long stamp,
+                                long long per_ns,
+                                const svOpenArrayHandle dbuf, int size);
+
+
+/**
+ * @brief Write an array of doubles, with an integer timestamp, from DPI.
+ *
+ * @param dat Data store object holding arrays of doubles.
+ * @param stamp Timestamp (see svp_dstore_write_stamp).
+ * @param per_ns Timestamp units per ns.
+ * @param dbuf Alias of double*, dereferenced with svGetArrayPtr.
+ * @return int 0 if successful.
+ */
+int svp_dstore_write_stamp_reals(struct svp_dstore_t *dat, long long stamp,
+                                 long long per_ns,
+                                 const svOpenArrayHandle dbuf);
+
+
+/**
+ * @brief Write a packed bit vector, with an integer timestamp, from DPI.
+ *
+ * @param dat Data store object (see svp_dstore_write_packed).
+ * @param stamp Timestamp (see svp_dstore_write_stamp).
+ * @param per_ns Timestamp units per ns.
+ * @param dbuf Open packed array (bit []), dereferenced with svGetArrayPtr.
+ * @param width Bits per lane.
+ * @param size Number of lanes.
+ * @param is_signed Sign-extend each lane, else zero-extend.
+ * @return int 0 if successful.
+ */
+int svp_dstore_write_stamp_bitvec(struct svp_dstore_t *dat, long long stamp,
+                                  long long per_ns,
+                                  const svOpenArrayHandle dbuf, int width,
+                                  int size, int is_signed);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HDF5 backend
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Create the datasets of a data store, and their attributes.
+ *
+ * @param dat Data store, with its caches.
+ *
+ * Attributes added before the dataset existed are written here.
+ */
+void svp_dstore_h5open(struct svp_dstore_t *dat);
+
+
+/**
+ * @brief Trim the datasets of a data store and close them.
+ *
+ * @param dat Data store, with all of its data written.
+ */
+void svp_dstore_h5close(struct svp_dstore_t *dat);
+
+
+/**
+ * @brief Add a string attribute to the dataset (or group) of a data store.
+ *
+ * @param dat Data store, with its dataset.
+ * @param name Attribute name.
+ * @param value Attribute value.
+ */
+void svp_dstore_h5attr(struct svp_dstore_t *dat, const char *name,
+                       const char *value);
+
 #endif
@@ -12,54 +12,458 @@
 // Version History
 // ---------------
 // 12-Nov-22: Initial version
+// 16-Oct-26: Added the background writer option.
+// 16-Oct-26: Added the default compression setting.
+// 16-Oct-26: Added the compression worker pool option.
+// 16-Oct-26: Added the chunk size target.
+// 16-Oct-26: Added the cache memory budget and usage report.
+// 16-Oct-26: Data stores are allocated from a per-file arena.
+// 16-Oct-26: Growable signal registry with a name index.
+// 16-Oct-26: Close the groups of the hierarchy trie.
+// 16-Oct-26: Added the lazy dataset creation option.
+// 16-Oct-26: Added the integer time base option.
+// 16-Oct-26: Added the timestamped data layout option.
+// 16-Oct-26: Added the write profiling option and report.
+// 16-Oct-26: Files are created and closed by a selectable storage backend.
+// 16-Oct-26: Added the sharding option.
+// 16-Oct-26: Added the rollover option.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "svp_file.h"
 #include "svp_dstore.h"
+#include "svp_io.h"
+#include "svp_zpool.h"
+#include "svp_cache.h"
+#include "svp_arena.h"
+#include "svp_group.h"
+#include "svp_prof.h"
+#include "svp_colfile.h"
+#include "svp_shard.h"
+#include "svp_roll.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Hash a signal name (64-bit FNV-1a).
+ *
+ * @param name Fully-qualified signal name.
+ * @return unsigned long Hash value.
+ */
+static unsigned long svp_hdf5_hash(const char *name) {
+  unsigned long hash = 14695981039346656037UL;
+  for (const unsigned char *cptr = (const unsigned char *)name; *cptr;
+       ++cptr) {
+    hash ^= *cptr;
+    hash *= 1099511628211UL;
+  }
+  return hash;
+}  // svp_hdf5_hash
+
+
+/**
+ * @brief Find the slot of a name in the signal index.
+ *
+ * @param clsdat File handle.
+ * @param name Fully-qualified signal name.
+ * @return unsigned long Slot holding the signal, or the empty slot where it
+ * would be inserted.
+ *
+ * The index is open-addressed with linear probing, and never more than half
+ * full, so a lookup touches only a few slots.
+ */
+static unsigned long svp_hdf5_slot(const struct svp_hdf5_data *clsdat,
+                                   const char *name) {
+  unsigned long mask = clsdat->hcap - 1;
+  unsigned long slot = svp_hdf5_hash(name) & mask;
+  while (clsdat->htab[slot] && strcmp(clsdat->htab[slot]->name, name)) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}  // svp_hdf5_slot
+
+
+/**
+ * @brief Double the size of the signal index, and re-insert all signals.
+ *
+ * @param clsdat File handle.
+ */
+static void svp_hdf5_rehash(struct svp_hdf5_data *clsdat) {
+  struct svp_dstore_t **htab = clsdat->htab;
+  unsigned long hcap = clsdat->hcap;
+  clsdat->hcap = 2 * hcap;
+  clsdat->htab = (struct svp_dstore_t **)svp_arena_alloc(
+      &clsdat->arena, clsdat->hcap * sizeof(struct svp_dstore_t *));
+  memset(clsdat->htab, 0, clsdat->hcap * sizeof(struct svp_dstore_t *));
+  for (unsigned long ii = 0; hcap > ii; ++ii) {
+    if (htab[ii]) {
+      clsdat->htab[svp_hdf5_slot(clsdat, htab[ii]->name)] = htab[ii];
+    }
+  }
+  svp_arena_free(&clsdat->arena, htab, hcap * sizeof(struct svp_dstore_t *));
+}  // svp_hdf5_rehash
+
+
+/**
+ * @brief Create the HDF5 file of the HDF5 backend.
+ *
+ * @param clsdat File handle.
+ * @param fname File name, an existing file is overwritten.
+ * @return int Returns 0 if successful.
+ */
+static int svp_hdf5_h5open(struct svp_hdf5_data *clsdat, const char *fname) {
+  clsdat->fptr = H5Fcreate(fname, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  return (0 > clsdat->fptr);
+}  // svp_hdf5_h5open
+
+
+/**
+ * @brief Close the groups and the HDF5 file of the HDF5 backend.
+ *
+ * @param clsdat File handle, with all of its data stores closed.
+ */
+static void svp_hdf5_h5close(struct svp_hdf5_data *clsdat) {
+  svp_group_close(clsdat);
+  H5Fclose(clsdat->fptr);
+}  // svp_hdf5_h5close
+
+
+/**
+ * @brief Add a string attribute to the root of the HDF5 file.
+ *
+ * @param clsdat File handle.
+ * @param name Attribute name.
+ * @param value Attribute value.
+ *
+ * The attributes of a rolled over file go to its index, not to a segment.
+ */
+static void svp_hdf5_h5attr(struct svp_hdf5_data *clsdat, const char *name,
+                            const char *value) {
+  if (clsdat->roll) {
+    svp_roll_attr(clsdat, name, value);
+    return;
+  }
+  svp_add_attr(clsdat->fptr, (char *)name, (char *)value);
+}  // svp_hdf5_h5attr
+
+
+/// Data stores are datasets of an HDF5 file
+static const struct svp_backend_t svp_backend_hdf5 = {
+  .name = "hdf5",
+  .fopen = svp_hdf5_h5open,
+  .fclose = svp_hdf5_h5close,
+  .fattr = svp_hdf5_h5attr,
+  .open = svp_dstore_h5open,
+  .commit = svp_io_commit,
+  .reserve = svp_io_reserve,
+  .attr = svp_dstore_h5attr,
+  .close = svp_dstore_h5close,
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
 
 struct svp_hdf5_data *svp_hdf5_fopen(const char *fname) {
+  return svp_hdf5_fopen_backend(fname, getenv("SVP_BACKEND"));
+}  // svp_hdf5_fopen
+
+
+struct svp_hdf5_data *svp_hdf5_fopen_backend(const char *fname,
+                                             const char *backend) {
+  const struct svp_backend_t *bptr = &svp_backend_hdf5;
+  if (backend && backend[0] && strcmp(backend, svp_backend_hdf5.name)) {
+    if (0 == strcmp(backend, svp_backend_column.name)) {
+      bptr = &svp_backend_column;
+    } else {
+      fprintf(stderr, "ERROR %s: Unknown backend: %s\n", __func__, backend);
+      return NULL;
+    }
+  }
   // Allocate class data
   struct svp_hdf5_data *clsdat = malloc(sizeof(struct svp_hdf5_data));
+  memset(clsdat, 0, sizeof(struct svp_hdf5_data));
+  svp_arena_init(&clsdat->arena);
   // Open the file
-  clsdat->fptr = H5Fcreate(fname, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
-  // Save file name
-  clsdat->name = fname;
+  clsdat->backend = bptr;
+  if (bptr->fopen(clsdat, fname)) {
+    fprintf(stderr, "ERROR %s: Could not create %s\n", __func__, fname);
+    svp_arena_destroy(&clsdat->arena);
+    free(clsdat);
+    return NULL;
+  }
+  // Save file name (the caller's string may not outlive this call)
+  char *name = svp_arena_alloc(&clsdat->arena, strlen(fname) + 1);
+  strcpy(name, fname);
+  clsdat->name = name;
+  // Default chunk size target
+  clsdat->chunk_bytes = CHUNK_BYTES;
+  // No sample ends a segment
+  clsdat->roll_at = HUGE_VAL;
   // Clear the data counter
   clsdat->num_signals = 0;
-  // Allocate space for the data store
-  clsdat->dptr = (struct svp_dstore_t **)malloc(MAX_SIGNALS *
-                                                sizeof(struct svp_dstore_t *));
-  for (int ii = 0; MAX_SIGNALS > ii; ++ii) {
-    clsdat->dptr[ii] = NULL;
-  }
+  // Allocate space for the data store, and its (power of two) name index
+  clsdat->max_signals = INIT_SIGNALS;
+  clsdat->dptr = (struct svp_dstore_t **)svp_arena_alloc(
+      &clsdat->arena, clsdat->max_signals * sizeof(struct svp_dstore_t *));
+  clsdat->hcap = 2 * INIT_SIGNALS;
+  clsdat->htab = (struct svp_dstore_t **)svp_arena_alloc(
+      &clsdat->arena, clsdat->hcap * sizeof(struct svp_dstore_t *));
+  memset(clsdat->htab, 0, clsdat->hcap * sizeof(struct svp_dstore_t *));
   // Return new data store
   return clsdat;
-}  // svp_hdf5_fopen
+}  // svp_hdf5_fopen_backend
 
 
 int svp_hdf5_addsig(struct svp_hdf5_data *clsdat, struct svp_dstore_t *dat) {
-  // Check if maximum number of files has been reached
-  if (MAX_SIGNALS == clsdat->num_signals) {
-    fprintf(stderr, "Maximum number of signals has been reached: %d\n",
-            MAX_SIGNALS);
+  if (!dat) {
+    fprintf(stderr, "ERROR %s: No data store to add\n", __func__);
+    return 1;
+  }
+  // Each name can only be registered once
+  unsigned long slot = svp_hdf5_slot(clsdat, dat->name);
+  if (clsdat->htab[slot]) {
+    fprintf(stderr, "ERROR %s: Signal is already registered: %s\n", __func__,
+            dat->name);
     return 1;
   }
+  // Grow the list geometrically when it is full
+  if (clsdat->max_signals == clsdat->num_signals) {
+    size_t nbytes = clsdat->max_signals * sizeof(struct svp_dstore_t *);
+    clsdat->dptr = (struct svp_dstore_t **)svp_arena_realloc(
+        &clsdat->arena, clsdat->dptr, nbytes, 2 * nbytes);
+    clsdat->max_signals *= 2;
+  }
   // Otherwise add the signal to the list, increment count
   clsdat->dptr[clsdat->num_signals] = dat;
   clsdat->num_signals += 1;
+  // Index the name, keeping the index at most half full
+  clsdat->htab[slot] = dat;
+  if (2 * (unsigned long)clsdat->num_signals > clsdat->hcap) {
+    svp_hdf5_rehash(clsdat);
+  }
+  // The shard holding the signal closes it
+  if (clsdat->nshards && (clsdat != dat->file)) {
+    return svp_hdf5_addsig(dat->file, dat);
+  }
   return 0;
 }  // svp_hdf5_addsig
 
 
+struct svp_dstore_t *svp_hdf5_getsig(const struct svp_hdf5_data *clsdat,
+                                     const char *name) {
+  return clsdat->htab[svp_hdf5_slot(clsdat, name)];
+}  // svp_hdf5_getsig
+
+
+int svp_hdf5_set_async_io(struct svp_hdf5_data *clsdat, int enable) {
+  // Each shard has a writer of its own
+  if (clsdat->nshards) {
+    int err = 0;
+    for (int ii = 0; clsdat->nshards > ii; ++ii) {
+      err |= svp_hdf5_set_async_io(clsdat->shards[ii], enable);
+    }
+    return err;
+  }
+  if (enable) {
+    return svp_io_start(clsdat);
+  }
+  // Any queued writes are completed before the thread exits
+  svp_io_stop(clsdat);
+  return 0;
+}  // svp_hdf5_set_async_io
+
+
+int svp_hdf5_set_filter(struct svp_hdf5_data *clsdat, const char *spec) {
+  struct svp_filter_t filt;
+  if (svp_filter_parse(spec, &filt)) {
+    return 1;
+  }
+  clsdat->filt = filt;
+  return 0;
+}  // svp_hdf5_set_filter
+
+
+int svp_hdf5_set_chunk_bytes(struct svp_hdf5_data *clsdat, long nbytes) {
+  if (0 >= nbytes) {
+    fprintf(stderr, "ERROR %s: Invalid chunk size: %ld\n", __func__, nbytes);
+    return 1;
+  }
+  clsdat->chunk_bytes = nbytes;
+  return 0;
+}  // svp_hdf5_set_chunk_bytes
+
+
+int svp_hdf5_set_cache_budget(struct svp_hdf5_data *clsdat, long nbytes) {
+  if (0 > nbytes) {
+    fprintf(stderr, "ERROR %s: Invalid cache budget: %ld\n", __func__, nbytes);
+    return 1;
+  }
+  clsdat->cache_budget = nbytes;
+  return 0;
+}  // svp_hdf5_set_cache_budget
+
+
+void svp_hdf5_set_huge_pages(struct svp_hdf5_data *clsdat, int enable) {
+  clsdat->arena.hugetlb = enable;
+}  // svp_hdf5_set_huge_pages
+
+
+int svp_hdf5_set_lazy(struct svp_hdf5_data *clsdat, int mode) {
+  if ((SVP_LAZY_OFF > mode) || (SVP_LAZY_SKIP < mode)) {
+    fprintf(stderr, "ERROR %s: Invalid lazy mode: %d\n", __func__, mode);
+    return 1;
+  }
+  clsdat->lazy = mode;
+  return 0;
+}  // svp_hdf5_set_lazy
+
+
+int svp_hdf5_set_time_res(struct svp_hdf5_data *clsdat, double res) {
+  // A whole number of ticks per ns, so time stores convert exactly
+  double tpn = (0 < res) ? 1e-9 / res : 0;
+  if ((0 > res) || ((0 < res) && ((0.5 > tpn) ||
+                                  (1e-6 < fabs(tpn - round(tpn)) / tpn)))) {
+    fprintf(stderr, "ERROR %s: Invalid time resolution: %g\n", __func__, res);
+    return 1;
+  }
+  clsdat->time_res = res;
+  return 0;
+}  // svp_hdf5_set_time_res
+
+
+int svp_hdf5_set_layout(struct svp_hdf5_data *clsdat, int mode) {
+  if ((SVP_LAYOUT_RECORD > mode) || (SVP_LAYOUT_COLUMN < mode)) {
+    fprintf(stderr, "ERROR %s: Invalid layout: %d\n", __func__, mode);
+    return 1;
+  }
+  clsdat->layout = mode;
+  return 0;
+}  // svp_hdf5_set_layout
+
+
+int svp_hdf5_set_profile(struct svp_hdf5_data *clsdat, int topn) {
+  if (0 > topn) {
+    fprintf(stderr, "ERROR %s: Invalid signal count: %d\n", __func__, topn);
+    return 1;
+  }
+  svp_prof_enable(clsdat, topn);
+  return 0;
+}  // svp_hdf5_set_profile
+
+
+int svp_hdf5_set_compress_threads(struct svp_hdf5_data *clsdat, int nthreads) {
+  // Each shard has a pool of its own
+  if (clsdat->nshards) {
+    int err = 0;
+    for (int ii = 0; clsdat->nshards > ii; ++ii) {
+      err |= svp_hdf5_set_compress_threads(clsdat->shards[ii], nthreads);
+    }
+    return err;
+  }
+  if (0 < nthreads) {
+    // Compressed chunks are committed by the background writer
+    if (svp_io_start(clsdat)) {
+      return 1;
+    }
+    return svp_zpool_start(clsdat, nthreads);
+  }
+  // Any queued chunks are compressed before the workers exit
+  svp_zpool_stop(clsdat);
+  return 0;
+}  // svp_hdf5_set_compress_threads
+
+
+int svp_hdf5_set_shards(struct svp_hdf5_data *clsdat, int nshards) {
+  if (0 >= nshards) {
+    fprintf(stderr, "ERROR %s: Invalid shard count: %d\n", __func__,
+            nshards);
+    return 1;
+  }
+  if (clsdat->nshards || clsdat->num_signals) {
+    fprintf(stderr, "ERROR %s: Shards must be set before any signal: %s\n",
+            __func__, clsdat->name);
+    return 1;
+  }
+  if (&svp_backend_hdf5 != clsdat->backend) {
+    fprintf(stderr, "ERROR %s: Only HDF5 files can be sharded: %s\n",
+            __func__, clsdat->name);
+    return 1;
+  }
+  if (clsdat->roll) {
+    fprintf(stderr, "ERROR %s: A rolled over file can not be sharded: %s\n",
+            __func__, clsdat->name);
+    return 1;
+  }
+  return svp_shard_start(clsdat, nshards);
+}  // svp_hdf5_set_shards
+
+
+int svp_hdf5_set_rollover(struct svp_hdf5_data *clsdat, double period,
+                          long samples, long nbytes) {
+  if ((0 > period) || (0 > samples) || (0 > nbytes)) {
+    fprintf(stderr, "ERROR %s: Invalid rollover limits: %g, %ld, %ld\n",
+            __func__, period, samples, nbytes);
+    return 1;
+  }
+  if (clsdat->roll || clsdat->num_signals) {
+    fprintf(stderr, "ERROR %s: Rollover must be set before any signal: %s\n",
+            __func__, clsdat->name);
+    return 1;
+  }
+  if ((&svp_backend_hdf5 != clsdat->backend) || clsdat->nshards) {
+    fprintf(stderr, "ERROR %s: Only unsharded HDF5 files can roll over: %s\n",
+            __func__, clsdat->name);
+    return 1;
+  }
+  clsdat->roll_period = period;
+  clsdat->roll_max_samples = samples;
+  clsdat->roll_max_bytes = nbytes;
+  return svp_roll_start(clsdat);
+}  // svp_hdf5_set_rollover
+
+
+int svp_hdf5_rollover(struct svp_hdf5_data *clsdat) {
+  if (!clsdat->roll) {
+    fprintf(stderr, "ERROR %s: File does not roll over: %s\n", __func__,
+            clsdat->name);
+    return 1;
+  }
+  return svp_roll_next(clsdat);
+}  // svp_hdf5_rollover
+
+
 int svp_hdf5_fclose(struct svp_hdf5_data *clsdat) {
-  for (int ii = 0; clsdat->num_signals > ii; ++ii) {
-    svp_dstore_close(clsdat->dptr[ii]);
+  // Drain the write queue, everything below runs on this thread
+  svp_io_stop(clsdat);
+  svp_zpool_stop(clsdat);
+  // The shards close their own signals, and make their own reports
+  if (clsdat->nshards) {
+    svp_shard_close(clsdat);
+  } else {
+    // Report the cache memory use if it was limited
+    if (clsdat->cache_budget) {
+      svp_cache_report(clsdat);
+    }
+    // Signals which were never written are created (or dropped) here too
+    for (int ii = 0; clsdat->num_signals > ii; ++ii) {
+      svp_dstore_close(clsdat->dptr[ii]);
+    }
+    // Report the write profile, which includes the final flushes
+    if (clsdat->profile) {
+      svp_prof_report(clsdat);
+    }
   }
-  // Free the data store
-  free(clsdat->dptr);
-  // Close the file
-  H5Fclose(clsdat->fptr);
+  // Close the file, the last segment of a rolled over file is then linked
+  clsdat->backend->fclose(clsdat);
+  if (clsdat->roll) {
+    svp_roll_close(clsdat);
+  }
+  // Release the data stores and all their memory in one step
+  svp_arena_destroy(&clsdat->arena);
   // Delete the class data
   free(clsdat);
   return 0;
@@ -68,5 +472,7 @@ int svp_hdf5_fclose(struct svp_hdf5_data *clsdat) {
 
 void svp_hdf5_add_attribute(struct svp_hdf5_data *clsdat, char *name,
                             char *value) {
-  svp_add_attr(clsdat->fptr, name, value);
+  svp_io_lock(clsdat);
+  clsdat->backend->fattr(clsdat, name, value);
+  svp_io_unlock(clsdat);
 }  // svp_hdf5_add_attribute
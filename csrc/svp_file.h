@@ -12,6 +12,21 @@
 // Version History
 // ---------------
 // 12-Nov-22: Initial version
+// 16-Oct-26: Added the background writer option.
+// 16-Oct-26: Added the default compression setting.
+// 16-Oct-26: Added the compression worker pool option.
+// 16-Oct-26: Added the chunk size target.
+// 16-Oct-26: Added the cache memory budget.
+// 16-Oct-26: Added the huge page option.
+// 16-Oct-26: Signal lookup by name, no limit on the number of signals.
+// 16-Oct-26: Added the lazy dataset creation option.
+// 16-Oct-26: Added the integer time base option.
+// 16-Oct-26: Added the timestamped data layout option.
+// 16-Oct-26: Added the write profiling option.
+// 16-Oct-26: Added the storage backend selection.
+// 16-Oct-26: Added the sharding option.
+// 16-Oct-26: Added the rollover option.
+// 16-Oct-26: Documented the integer timestamp writers of the time base.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -36,21 +51,275 @@
  * @param fname Full path to file to be created.
  * @return struct svp_hdf5_data* File handle for adding signals to the dump.
  *
- * This will overwrite any existing file with the given name.
+ * This will overwrite any existing file with the given name. The storage
+ * backend is named by the SVP_BACKEND environment variable, see
+ * svp_hdf5_fopen_backend.
  *
  */
 struct svp_hdf5_data *svp_hdf5_fopen(const char *fname);
 
 
+/**
+ * @brief Open a new file for dumping simulation data, with a given backend.
+ *
+ * @param fname Full path to file (or directory) to be created.
+ * @param backend "hdf5" (the default, also for NULL or ""), or "column" to
+ * append raw column files to the directory fname, which svp_convert turns
+ * into HDF5 after the simulation.
+ * @return struct svp_hdf5_data* File handle, NULL if the backend is unknown
+ * or the file could not be created.
+ */
+struct svp_hdf5_data *svp_hdf5_fopen_backend(const char *fname,
+                                             const char *backend);
+
+
 /**
  * @brief Add a signal to the file to be dumped.
  *
  * @param clsdat File handle to contain signals.
  * @param dat Data store object that will be added to the file.
- * @return int Returns 0 if successful.
+ * @return int Returns 0 if successful, 1 if dat is NULL or a signal with the
+ * same name was already added.
+ *
+ * There is no limit on the number of signals, the registry grows as needed.
  */
 int svp_hdf5_addsig(struct svp_hdf5_data *clsdat, struct svp_dstore_t *dat);
 
+
+/**
+ * @brief Find a signal which was added to the file.
+ *
+ * @param clsdat File handle.
+ * @param name Fully-qualified signal name, as given at creation.
+ * @return struct svp_dstore_t* Data store object, NULL if there is none.
+ *
+ * This is a hash lookup, so its cost does not depend on the number of
+ * signals.
+ */
+struct svp_dstore_t *svp_hdf5_getsig(const struct svp_hdf5_data *clsdat,
+                                     const char *name);
+
+/**
+ * @brief Enable or disable the background writer thread.
+ *
+ * @param clsdat File handle.
+ * @param enable If non-zero, full caches are written by a dedicated thread.
+ * @return int Returns 0 if successful.
+ *
+ * In asynchronous mode each data store keeps a second cache, so that the
+ * simulator can continue filling one while the other is being written. This
+ * may be called at any time, disabling waits for all queued writes.
+ */
+int svp_hdf5_set_async_io(struct svp_hdf5_data *clsdat, int enable);
+
+
+/**
+ * @brief Set the default compression of data stores created in this file.
+ *
+ * @param clsdat File handle.
+ * @param spec Filter spec, e.g. "shuffle+deflate:4" (see svp_filter_parse).
+ * @return int Returns 0 if successful.
+ *
+ * Only affects data stores created after this call, and only those which do
+ * not request their own filters.
+ */
+int svp_hdf5_set_filter(struct svp_hdf5_data *clsdat, const char *spec);
+
+
+/**
+ * @brief Set the target chunk size of data stores created in this file.
+ *
+ * @param clsdat File handle.
+ * @param nbytes Target size of each chunk and its cache (bytes).
+ * @return int Returns 0 if successful.
+ *
+ * The number of records per chunk is chosen per data store, from the size of
+ * its records. Narrow signals get long chunks and wide signals short ones, so
+ * I/O stays efficient without the caches of wide signals growing large. The
+ * default is CHUNK_BYTES. Only affects data stores created after this call.
+ */
+int svp_hdf5_set_chunk_bytes(struct svp_hdf5_data *clsdat, long nbytes);
+
+
+/**
+ * @brief Limit the total memory used by the caches of all data stores.
+ *
+ * @param clsdat File handle.
+ * @param nbytes Cache memory budget (bytes), 0 for no limit.
+ * @return int Returns 0 if successful.
+ *
+ * With a budget, data stores created afterwards start with a short cache
+ * (CACHE_MIN_LEN records) which doubles up to a full chunk as it fills. When
+ * the budget is exhausted, the largest caches of other signals are flushed
+ * and shrunk, and if that is not enough the filling cache is written out
+ * early. Short writes are slower, but no data is lost. The minimum caches
+ * are always allocated, so the budget can be exceeded if it is smaller than
+ * their total. The memory used by each signal is printed when the file is
+ * closed.
+ */
+int svp_hdf5_set_cache_budget(struct svp_hdf5_data *clsdat, long nbytes);
+
+
+/**
+ * @brief Back the file memory arena with explicit huge pages.
+ *
+ * @param clsdat File handle.
+ * @param enable If non-zero, new arena regions are mapped with MAP_HUGETLB.
+ *
+ * Data stores and their caches are allocated from 2 MiB-aligned regions,
+ * which are already marked for transparent huge pages. Explicit huge pages
+ * must be reserved by the system (vm.nr_hugepages), if none are available
+ * a warning is printed and regular pages are used. Only regions mapped after
+ * this call are affected.
+ */
+void svp_hdf5_set_huge_pages(struct svp_hdf5_data *clsdat, int enable);
+
+
+/**
+ * @brief Defer creating the datasets of data stores until they are written.
+ *
+ * @param clsdat File handle.
+ * @param mode One of enum svp_lazy_e.
+ * @return int Returns 0 if successful.
+ *
+ * Registering a lazy data store only records its description. The groups,
+ * dataset, datatypes and caches are created with its first sample, and
+ * attributes or an expected size given before then are applied at that
+ * point. Signals which are never written cost no HDF5 objects and no cache
+ * memory. When the file is closed they are created as empty datasets with
+ * SVP_LAZY_EMPTY, or left out of the file with SVP_LAZY_SKIP. Only affects
+ * data stores created after this call.
+ */
+int svp_hdf5_set_lazy(struct svp_hdf5_data *clsdat, int mode);
+
+
+/**
+ * @brief Store the timestamps of new data stores as integer ticks.
+ *
+ * @param clsdat File handle.
+ * @param res Seconds per tick (the simulator time precision, e.g. 1e-15),
+ * 0 for double timestamps (the default).
+ * @return int Returns 0 if successful.
+ *
+ * Asynchronous data stores then store a 64-bit integer time column instead
+ * of double nanoseconds, and time stores a single tick count instead of ns
+ * and rem. Each record holds the difference from the previous tick, with
+ * the absolute tick at the start of every chunk, which compresses well and
+ * keeps chunks independent. The resolution must divide 1 ns. Timestamps are
+ * rounded to the nearest tick when they are written, and whole records are
+ * written in one pass. Double timestamps only resolve 1 fs up to 2^53 fs
+ * (about 9 s), svp_dstore_write_stamp and friends take an integer count
+ * which stays exact. Only affects data stores created after this call.
+ */
+int svp_hdf5_set_time_res(struct svp_hdf5_data *clsdat, double res);
+
+
+/**
+ * @brief Choose how asynchronous data stores lay out their timestamps.
+ *
+ * @param clsdat File handle.
+ * @param mode One of enum svp_layout_e.
+ * @return int Returns 0 if successful.
+ *
+ * With SVP_LAYOUT_COLUMN, each asynchronous (or value-change) signal is a
+ * group holding a 1-D dataset of its timestamps (or change indices) and a
+ * plain dataset of its data, both chunked alike. Each is written
+ * contiguously, and readers can load the time column without the data.
+ * The attributes of the signal are on the group. Only affects data stores
+ * created after this call.
+ */
+int svp_hdf5_set_layout(struct svp_hdf5_data *clsdat, int mode);
+
+
+/**
+ * @brief Time the write path of every signal of the file.
+ *
+ * @param clsdat File handle.
+ * @param topn Signals listed in each table of the report, 0 for the totals
+ * only.
+ * @return int Returns 0 if successful.
+ *
+ * Flushes and bytes are always counted, this also times the sample copies,
+ * the caches laid out for writing, and the H5Dwrite and H5Dset_extent calls,
+ * from now on. At close, the totals are stored as prof_* attributes of the
+ * file root, and printed with the signals which wrote the most bytes and
+ * which spent the most time in HDF5 calls. The counters can be read during
+ * the simulation with svp_prof_signal and svp_prof_file.
+ */
+int svp_hdf5_set_profile(struct svp_hdf5_data *clsdat, int topn);
+
+
+/**
+ * @brief Compress full chunks on a pool of worker threads.
+ *
+ * @param clsdat File handle.
+ * @param nthreads Number of workers, 0 to stop the pool.
+ * @return int Returns 0 if successful.
+ *
+ * Starting the pool also starts the background writer. Full caches of data
+ * stores filtered only by shuffle and/or deflate are then compressed by the
+ * workers, and the writer commits the compressed chunks in order with
+ * H5Dwrite_chunk. The chunks are byte-identical to what the HDF5 filter
+ * pipeline would produce. Other caches are written as before. A sharded
+ * file starts a pool of nthreads workers for each shard. Calling this again
+ * resizes (or stops) the pool, once the chunks it has taken are written.
+ */
+int svp_hdf5_set_compress_threads(struct svp_hdf5_data *clsdat, int nthreads);
+
+
+/**
+ * @brief Spread the signals over several HDF5 files.
+ *
+ * @param clsdat File handle, of the HDF5 backend, with no signals yet.
+ * @param nshards Number of shard files.
+ * @return int Returns 0 if successful.
+ *
+ * Shard K of file.h5 is file_shardK.h5. Signals are given to the shards in
+ * turn as they are created, with the settings of the file at that time, and
+ * each shard has its own background writer (and compression pool, if the
+ * file has one). At close, file.h5 is written with an external link for
+ * each signal, in the group it would otherwise be in, so it is read as
+ * before as long as the shards stay next to it.
+ */
+int svp_hdf5_set_shards(struct svp_hdf5_data *clsdat, int nshards);
+
+
+/**
+ * @brief Write the signals to a series of segment files.
+ *
+ * @param clsdat File handle, of the HDF5 backend, unsharded, with no signals
+ * yet.
+ * @param period Sim time per segment (ns), 0 for no limit.
+ * @param samples Records written to a segment, over all of its signals,
+ * before it is closed, 0 for no limit.
+ * @param nbytes Bytes written to a segment before it is closed, 0 for no
+ * limit.
+ * @return int Returns 0 if successful.
+ *
+ * Segment K of file.h5 is file_segK.h5 (K with at least 4 digits), and
+ * file.h5 becomes an index, with an external link segK to each finished
+ * segment and the number of them in its segments attribute. Segments are
+ * closed and trimmed like a whole file, so they can be read while the
+ * simulation goes on, and the next segment has the same signals. Samples
+ * and bytes are counted each time a cache is full, and the period is
+ * checked against the timestamps of the samples, so segments end near
+ * (not exactly at) the limits. svp_hdf5_rollover starts a new segment at
+ * any time.
+ */
+int svp_hdf5_set_rollover(struct svp_hdf5_data *clsdat, double period,
+                          long samples, long nbytes);
+
+
+/**
+ * @brief Close the current segment of a rolled over file, and start the
+ * next.
+ *
+ * @param clsdat File handle, set up with svp_hdf5_set_rollover.
+ * @return int Returns 0 if successful.
+ */
+int svp_hdf5_rollover(struct svp_hdf5_data *clsdat);
+
+
 /**
  * @brief Close the file and any registered data stores.
  *
@@ -0,0 +1,205 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Per-file trie of the open HDF5 groups which mirror the signal hierarchy, so
+// that each group is opened (or created) only once.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: Skip empty levels of the hierarchy.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "svp_group.h"
+#include "svp_arena.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Hash a trie edge, the parent node and one level of the name.
+ *
+ * @param parent Parent node.
+ * @param name Group name (not terminated).
+ * @param nlen Length of the name.
+ * @return unsigned long Hash value (64-bit FNV-1a).
+ */
+static unsigned long svp_group_hash(const struct svp_group_t *parent,
+                                    const char *name, size_t nlen) {
+  unsigned long hash = 14695981039346656037UL ^ (unsigned long)parent;
+  for (size_t ii = 0; nlen > ii; ++ii) {
+    hash ^= (unsigned char)name[ii];
+    hash *= 1099511628211UL;
+  }
+  return hash;
+}  // svp_group_hash
+
+
+/**
+ * @brief Find the slot of a child node in the trie index.
+ *
+ * @param clsdat File handle.
+ * @param parent Parent node.
+ * @param name Group name (not terminated).
+ * @param nlen Length of the name.
+ * @return unsigned long Slot holding the node, or the empty slot where it
+ * would be inserted.
+ */
+static unsigned long svp_group_slot(const struct svp_hdf5_data *clsdat,
+                                    const struct svp_group_t *parent,
+                                    const char *name, size_t nlen) {
+  unsigned long mask = clsdat->gcap - 1;
+  unsigned long slot = svp_group_hash(parent, name, nlen) & mask;
+  struct svp_group_t *node;
+  while ((node = clsdat->gtab[slot])) {
+    if ((parent == node->parent) && (nlen == node->nlen) &&
+        (0 == memcmp(name, node->name, nlen))) {
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}  // svp_group_slot
+
+
+/**
+ * @brief Double the size of the trie index, and re-insert all nodes.
+ *
+ * @param clsdat File handle.
+ */
+static void svp_group_rehash(struct svp_hdf5_data *clsdat) {
+  struct svp_group_t **gtab = clsdat->gtab;
+  unsigned long gcap = clsdat->gcap;
+  clsdat->gcap = (gcap) ? 2 * gcap : 64;
+  clsdat->gtab = (struct svp_group_t **)svp_arena_alloc(
+      &clsdat->arena, clsdat->gcap * sizeof(struct svp_group_t *));
+  memset(clsdat->gtab, 0, clsdat->gcap * sizeof(struct svp_group_t *));
+  for (unsigned long ii = 0; gcap > ii; ++ii) {
+    struct svp_group_t *node = gtab[ii];
+    if (node) {
+      clsdat->gtab[svp_group_slot(clsdat, node->parent, node->name,
+                                  node->nlen)] = node;
+    }
+  }
+  svp_arena_free(&clsdat->arena, gtab, gcap * sizeof(struct svp_group_t *));
+}  // svp_group_rehash
+
+
+/**
+ * @brief Get the child group of a node, opening or creating it if needed.
+ *
+ * @param clsdat File handle.
+ * @param parent Parent node.
+ * @param name Group name (not terminated).
+ * @param nlen Length of the name.
+ * @return struct svp_group_t* Child node.
+ */
+static struct svp_group_t *svp_group_child(struct svp_hdf5_data *clsdat,
+                                           struct svp_group_t *parent,
+                                           const char *name, size_t nlen) {
+  unsigned long slot = svp_group_slot(clsdat, parent, name, nlen);
+  if (clsdat->gtab[slot]) {
+    return clsdat->gtab[slot];
+  }
+  // New node, with its own copy of the name
+  struct svp_group_t *node = svp_arena_alloc(&clsdat->arena,
+                                             sizeof(struct svp_group_t));
+  char *name_cpy = svp_arena_alloc(&clsdat->arena, nlen + 1);
+  memcpy(name_cpy, name, nlen);
+  name_cpy[nlen] = '\0';
+  node->parent = parent;
+  node->name = name_cpy;
+  node->nlen = nlen;
+  // The group may exist already if something else created it
+  if (0 == H5Lexists(parent->gid, name_cpy, H5P_DEFAULT)) {
+    node->gid = H5Gcreate(parent->gid, name_cpy, H5P_DEFAULT, H5P_DEFAULT,
+                          H5P_DEFAULT);
+  } else {
+    node->gid = H5Gopen(parent->gid, name_cpy, H5P_DEFAULT);
+  }
+  // Index the node, keeping the index at most half full
+  clsdat->gtab[slot] = node;
+  clsdat->ngroups += 1;
+  if (2 * clsdat->ngroups > clsdat->gcap) {
+    svp_group_rehash(clsdat);
+  }
+  return node;
+}  // svp_group_child
+
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+hid_t svp_group_open(struct svp_hdf5_data *clsdat, const char *full_name,
+                     const char **sig_name) {
+  // Starting point group is the root '/' within the file
+  if (!clsdat->groot) {
+    clsdat->groot = svp_arena_alloc(&clsdat->arena,
+                                    sizeof(struct svp_group_t));
+    memset(clsdat->groot, 0, sizeof(struct svp_group_t));
+    clsdat->groot->gid = H5Gopen(clsdat->fptr, "/", H5P_DEFAULT);
+    svp_group_rehash(clsdat);
+  }
+  const char *last = strrchr(full_name, '.');
+  *sig_name = (last) ? last + 1 : full_name;
+  if (!last) {
+    return clsdat->groot->gid;
+  }
+  // Sibling of the previous signal, its parent path is still cached
+  size_t plen = last - full_name;
+  if (clsdat->glast && (plen == clsdat->glen) &&
+      (0 == memcmp(full_name, clsdat->gpath, plen))) {
+    return clsdat->glast->gid;
+  }
+  // Descend into the hierarchy one level at a time
+  struct svp_group_t *node = clsdat->groot;
+  const char *token = full_name;
+  while (token < last) {
+    const char *delim = memchr(token, '.', last - token);
+    if (!delim) {
+      delim = last;
+    }
+    // Empty levels (".a.b", "a...b") are skipped, as strtok did
+    if (delim > token) {
+      node = svp_group_child(clsdat, node, token, delim - token);
+    }
+    token = delim + 1;
+  }
+  // Remember this parent for the next signal
+  if (plen >= clsdat->gpath_cap) {
+    svp_arena_free(&clsdat->arena, clsdat->gpath, clsdat->gpath_cap);
+    clsdat->gpath_cap = 2 * plen + 1;
+    clsdat->gpath = svp_arena_alloc(&clsdat->arena, clsdat->gpath_cap);
+  }
+  memcpy(clsdat->gpath, full_name, plen);
+  clsdat->glen = plen;
+  clsdat->glast = node;
+  return node->gid;
+}  // svp_group_open
+
+
+void svp_group_close(struct svp_hdf5_data *clsdat) {
+  for (unsigned long ii = 0; clsdat->gcap > ii; ++ii) {
+    if (clsdat->gtab[ii]) {
+      H5Gclose(clsdat->gtab[ii]->gid);
+    }
+  }
+  if (clsdat->groot) {
+    H5Gclose(clsdat->groot->gid);
+  }
+  // The nodes themselves are released with the arena
+  clsdat->groot = NULL;
+  clsdat->glast = NULL;
+  clsdat->gtab = NULL;
+  clsdat->gcap = 0;
+  clsdat->ngroups = 0;
+}  // svp_group_close
@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Per-file trie of the open HDF5 groups which mirror the signal hierarchy, so
+// that each group is opened (or created) only once.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SVP__GROUP__H__
+#define __SVP__GROUP__H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hdf5.h"
+#include "svp_hdf5_defs.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Find the group which holds a signal, creating it if needed.
+ *
+ * @param clsdat File handle.
+ * @param full_name The full path to the signal, e.g. u_top.u_sub.sig.
+ * @param sig_name Set to the signal name within full_name (after the last
+ * hierarchy separator).
+ * @return hid_t Group handle, owned by the file (do not close it).
+ *
+ * This performs a similar function to the python os.mkdirs() function, in
+ * that any intermediate hierarchy is constructed as HDF5 groups if it does
+ * not already exist. Groups stay open in the trie, so signals which share a
+ * parent cost no HDF5 calls at all, and the parent of the previous signal is
+ * found without walking the hierarchy.
+ */
+hid_t svp_group_open(struct svp_hdf5_data *clsdat, const char *full_name,
+                     const char **sig_name);
+
+
+/**
+ * @brief Close all groups of the trie.
+ *
+ * @param clsdat File handle.
+ */
+void svp_group_close(struct svp_hdf5_data *clsdat);
+
+#endif
@@ -12,52 +12,15 @@
 // Version History
 // ---------------
 // 12-Nov-22: Initial version
+// 16-Oct-26: Added compression filter parsing.
+// 16-Oct-26: Moved the group hierarchy walk to svp_group.
+// 16-Oct-26: Added the bitpack storage option.
+// 16-Oct-26: Added the datatype name lookup.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "svp_hdf5_defs.h"
 
-void svp_group_hierarchy_split(hid_t fid, const char *full_name, hid_t *gid,
-                               char **sig_name) {
-  // Copy the string to a new location
-  char *name_cpy = (char *)malloc(strlen(full_name) + 1);
-  strcpy(name_cpy, full_name);
-  // Token-ize the name by the '.' hierarchy separators
-  const char *delim = ".";
-  // This contains the offset within the full_name of the first character of
-  // the signal name
-  int name_start = 0;
-  // Starting point group is the root '/' within the file
-  *gid = H5Gopen(fid, "/", H5P_DEFAULT);
-  hid_t next_gid;
-  // Apply first tokenization, to load string into strtok
-  char *token = strtok(name_cpy, delim);
-  // Split token by delimiter
-  char *next_token = strtok(NULL, delim);
-  while (next_token) {
-    // If next_token is found, it means we just removed one hierarchy separator
-    // Increment the name starting point offset (plus delimiter)
-    name_start += next_token - token;
-    // Descend into the hierarchy by trying to open the next group
-    if (0 == H5Lexists(*gid, token, H5P_DEFAULT)) {
-      // This group does not exist yet, so create it
-      next_gid = H5Gcreate(*gid, token, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-    } else {
-      next_gid = H5Gopen(*gid, token, H5P_DEFAULT);
-    }
-    H5Gclose(*gid);
-    // Assign gid to the next and continue
-    *gid = next_gid;
-    // Continue tokenization
-    token = next_token;
-    next_token = strtok(NULL, delim);
-  }
-  // When next_token is null, it means that token contains the final name, and
-  // name_start is the correct offset from the original full_name
-  *sig_name = (char *)((unsigned long)full_name + name_start);
-}  // svp_group_hierarchy_split
-
-
 herr_t svp_add_attr(hid_t obj_id, char *name, char *value) {
   // Create string type of correct size for the attribute
   hid_t attr_type = H5Tcopy(H5T_C_S1);
@@ -81,3 +44,97 @@ herr_t svp_add_attr(hid_t obj_id, char *name, char *value) {
   H5Tclose(attr_type);
   return 0;
 }  // svp_add_attr
+
+
+int svp_filter_parse(const char *spec, struct svp_filter_t *filt) {
+  memset(filt, 0, sizeof(struct svp_filter_t));
+  // Copy the string so it can be tokenized
+  char *spec_cpy = (char *)malloc(strlen(spec) + 1);
+  strcpy(spec_cpy, spec);
+  int status = 0;
+  char *token = strtok(spec_cpy, "+");
+  while (token && !status) {
+    // Split off the optional argument
+    char *arg = strchr(token, ':');
+    if (arg) {
+      *arg = '\0';
+      arg += 1;
+    }
+    if (0 == strcmp(token, "none")) {
+      // Nothing to add
+    } else if (0 == strcmp(token, "shuffle")) {
+      filt->shuffle = 1;
+    } else if (0 == strcmp(token, "deflate")) {
+      filt->deflate = (arg) ? atoi(arg) : 4;
+      if ((1 > filt->deflate) || (9 < filt->deflate)) {
+        fprintf(stderr, "ERROR %s: Deflate level must be 1-9: %s\n", __func__,
+                spec);
+        status = 1;
+      }
+    } else if (0 == strcmp(token, "nbit")) {
+      filt->nbit = 1;
+    } else if (0 == strcmp(token, "scaleoffset")) {
+      filt->scaleoffset = 1;
+    } else if (0 == strcmp(token, "bitpack")) {
+      filt->bitpack = 1;
+    } else {
+      fprintf(stderr, "ERROR %s: Unknown filter: %s\n", __func__, token);
+      status = 1;
+    }
+    token = strtok(NULL, "+");
+  }
+  if (1 < filt->nbit + filt->scaleoffset + filt->bitpack) {
+    fprintf(stderr,
+            "ERROR %s: nbit, scaleoffset and bitpack are exclusive: %s\n",
+            __func__, spec);
+    status = 1;
+  }
+  free(spec_cpy);
+  return status;
+}  // svp_filter_parse
+
+
+herr_t svp_filter_apply(hid_t prop, const struct svp_filter_t *filt) {
+  herr_t status = 0;
+  if (filt->nbit) {
+    status = H5Pset_nbit(prop);
+    if (status < 0) return status;
+  }
+  if (filt->scaleoffset) {
+    status = H5Pset_scaleoffset(prop, H5Z_SO_INT, H5Z_SO_INT_MINBITS_DEFAULT);
+    if (status < 0) return status;
+  }
+  if (filt->shuffle) {
+    status = H5Pset_shuffle(prop);
+    if (status < 0) return status;
+  }
+  if (filt->deflate) {
+    status = H5Pset_deflate(prop, filt->deflate);
+    if (status < 0) return status;
+  }
+  return 0;
+}  // svp_filter_apply
+
+
+hid_t svp_dtype_lookup(const char *dtype) {
+  if (0 == strcmp(dtype, "char")) {
+    return H5T_NATIVE_CHAR;
+  } else if (0 == strcmp(dtype, "uchar")) {
+    return H5T_NATIVE_UCHAR;
+  } else if (0 == strcmp(dtype, "sint")) {
+    return H5T_NATIVE_SHORT;
+  } else if (0 == strcmp(dtype, "usint")) {
+    return H5T_NATIVE_USHORT;
+  } else if (0 == strcmp(dtype, "int")) {
+    return H5T_NATIVE_INT;
+  } else if (0 == strcmp(dtype, "uint")) {
+    return H5T_NATIVE_UINT;
+  } else if (0 == strcmp(dtype, "long")) {
+    return H5T_NATIVE_LONG;
+  } else if (0 == strcmp(dtype, "ulong")) {
+    return H5T_NATIVE_ULONG;
+  } else if (0 == strcmp(dtype, "double")) {
+    return H5T_NATIVE_DOUBLE;
+  }
+  return H5I_INVALID_HID;
+}  // svp_dtype_lookup
@@ -12,6 +12,28 @@
 // Version History
 // ---------------
 // 12-Nov-22: Initial version
+// 16-Oct-26: Added background writer state and back caches.
+// 16-Oct-26: Cached dataset extent with geometric growth.
+// 16-Oct-26: On-disk record layout for direct chunk writes.
+// 16-Oct-26: Added compression filter settings.
+// 16-Oct-26: Added compression worker pool state.
+// 16-Oct-26: Chunk length sized per data store from a byte target.
+// 16-Oct-26: Added the file cache memory budget.
+// 16-Oct-26: Added the per-file memory arena.
+// 16-Oct-26: Replaced MAX_SIGNALS with a growable, indexed registry.
+// 16-Oct-26: Groups of the signal hierarchy are kept open in a trie.
+// 16-Oct-26: Added lazy dataset creation and deferred attributes.
+// 16-Oct-26: Added bit-packed storage of narrow integers.
+// 16-Oct-26: Added value-change storage.
+// 16-Oct-26: Added clock-domain row groups.
+// 16-Oct-26: Added the integer time base.
+// 16-Oct-26: Added the column layout of timestamped data.
+// 16-Oct-26: Removed MAX_FLAT_SIZE, large records are split across chunks.
+// 16-Oct-26: Added write path profiling counters.
+// 16-Oct-26: Added storage backends, and the mmap column backend state.
+// 16-Oct-26: Added shard files, each with its own writer thread.
+// 16-Oct-26: Added file rollover into segments.
+// 16-Oct-26: Time caches hold a union of timestamps, ticks and indices.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -21,6 +43,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <pthread.h>
 
 #include "hdf5.h"
 
@@ -28,12 +52,29 @@
 // Constants
 ///////////////////////////////////////////////////////////////////////////////
 
-/// Maximum number of signals per file
-#define MAX_SIGNALS 1024
-/// Maximum flattened size of each data record (product of all dimensions)
-#define MAX_FLAT_SIZE 2048
-/// Size of each page in the HD5 file and corresponding cache
-#define CHUNK_SIZE 8192
+/// Initial capacity of the signal registry of a file (grows as needed)
+#define INIT_SIGNALS 1024
+/// Default target size of each chunk in the HD5 file and its cache (bytes)
+#define CHUNK_BYTES 1048576
+/// Initial (and minimum) cache length when the cache memory is budgeted
+#define CACHE_MIN_LEN 64
+
+/// Size and alignment of each arena region (one huge page)
+#define ARENA_REGION (2 << 20)
+/// Arena page size, blocks of at least this size are page-aligned
+#define ARENA_PAGE 4096
+/// Smallest arena block, and the alignment of small blocks (one cache line)
+#define ARENA_MIN_BLOCK 64
+/// Number of arena size classes (four per power of two)
+#define ARENA_CLASSES 256
+
+/// Femtoseconds per ns, the unit of exact integer timestamps
+#define FS_PER_NS 1000000LL
+
+/// Full caches bypass the HDF5 datatype conversion (needs HDF5 >= 1.10.3)
+#if H5_VERSION_GE(1, 10, 3)
+#define SVP_DIRECT_CHUNK
+#endif
 
 /**
  * @brief Enumeration of the different types of data that can be stored.
@@ -42,13 +83,62 @@
 enum svp_storage_e {
   SVP_STORE_SYNC_DATA,
   SVP_STORE_ASYNC_DATA,
-  SVP_STORE_SIM_TIME
+  SVP_STORE_SIM_TIME,
+  SVP_STORE_CHANGE_DATA     ///< Sync data, only samples which differ are kept
+};
+
+
+/**
+ * @brief When the datasets of a file are created.
+ *
+ */
+enum svp_lazy_e {
+  SVP_LAZY_OFF,             ///< When the data store is created
+  SVP_LAZY_EMPTY,           ///< On the first write, or empty at close
+  SVP_LAZY_SKIP             ///< On the first write, never if not written
+};
+
+
+/**
+ * @brief How the timestamps of asynchronous data are laid out in the file.
+ *
+ */
+enum svp_layout_e {
+  SVP_LAYOUT_RECORD,        ///< Time and data members of one compound dataset
+  SVP_LAYOUT_COLUMN         ///< Time and data datasets, in a group
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 // Data structures
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * @brief Compression filters applied to a dataset.
+ *
+ * Filters are applied in the order they are listed here. N-bit, scale-offset
+ * and bit packing are mutually exclusive. Bit packing is done by the library
+ * before the HDF5 filters see the data.
+ */
+struct svp_filter_t {
+  int bitpack;              ///< Store narrow integers as a packed bit stream
+  int nbit;                 ///< Pack integers to their significant bits
+  int scaleoffset;          ///< Integer scale-offset (lossless)
+  int shuffle;              ///< Byte shuffle, improves deflate ratio
+  int deflate;              ///< Deflate (gzip) level, 0 disables
+};
+
+
+/**
+ * @brief Optional settings when creating a data store.
+ *
+ */
+struct svp_dstore_opt_t {
+  const char *filt;         ///< Filter spec, NULL or "" for the file default
+  int precision;            ///< Significant bits per integer, 0 for all
+  unsigned long chunk;      ///< Records per chunk (or cache), 0 for the file
+};
+
+
 /**
  * @brief High-resolution timestamp.
  *
@@ -62,40 +152,349 @@ struct svp_sim_time_t {
 };
 
 
+/**
+ * @brief One entry of a timestamp cache.
+ *
+ * The member in use depends on the data store: tick with an integer time
+ * base, index for value changes, else time.
+ */
+union svp_tstamp_u {
+  double time;              ///< Timestamp (ns), the remainder for time stores
+  long long tick;           ///< Tick, of the remainder for time stores
+  unsigned long long index; ///< Sample index of a value change
+};
+
+
+/**
+ * @brief Memory arena of a file.
+ *
+ * Blocks are carved from ARENA_REGION-aligned mappings, and freed blocks are
+ * kept on a list per size class for reuse.
+ */
+struct svp_arena_t {
+  pthread_mutex_t mtx;      ///< Protects the arena (workers allocate too)
+  int hugetlb;              ///< Map new regions with explicit huge pages
+  struct svp_arena_region_t *regions; ///< Most recently mapped region
+  char *bptr;               ///< Next free byte of the current region
+  char *bend;               ///< End of the current region
+  void *free[ARENA_CLASSES]; ///< Freed blocks of each size class
+  size_t mapped;            ///< Total size of all regions (bytes)
+};
+
+
+/**
+ * @brief String attribute waiting for its dataset to be created.
+ *
+ */
+struct svp_attr_t {
+  const char *name;         ///< Attribute name
+  const char *value;        ///< Attribute value
+  struct svp_attr_t *next;  ///< Next attribute, in the order they were added
+};
+
+
+/**
+ * @brief A full cache queued for the background writer.
+ *
+ */
+struct svp_io_job_t {
+  struct svp_dstore_t *dat; ///< Data store owning the cache
+  union svp_tstamp_u *tcache; ///< Timestamp cache to be written
+  void *dcache;             ///< Data cache to be written
+  unsigned long wptr;       ///< Dataset offset of the first cached element
+  unsigned long cptr;       ///< Number of cached elements
+  struct svp_io_job_t *next; ///< Next job in the queue
+  // Compression by the worker pool
+  int zstate;               ///< 0: not pooled, 1: queued, 2: compressed
+  void *zbuf;               ///< Filtered chunk contents
+  size_t zsize;             ///< Size of the filtered chunk
+  struct svp_io_job_t *znext; ///< Next job in the compression queue
+};
+
+
+/**
+ * @brief Write path counters of a data store.
+ *
+ * Times are in cycles of svp_prof_cycles, and are only counted while the
+ * file is profiled. Copies are made on the simulator thread, the rest by
+ * whichever thread commits the caches.
+ */
+struct svp_prof_t {
+  unsigned long long flushes; ///< Number of caches committed
+  unsigned long long bytes; ///< Record bytes committed, before compression
+  unsigned long long t_write; ///< Cycles in H5Dwrite and H5Dwrite_chunk
+  unsigned long long t_extent; ///< Cycles in H5Dset_extent
+  unsigned long long t_copy; ///< Cycles copying samples into the caches
+  unsigned long long t_stage; ///< Cycles laying out caches for writing
+};
+
+
+/**
+ * @brief Profile of a closed data store, kept for the report at close.
+ *
+ */
+struct svp_prof_rec_t {
+  const char *name;         ///< Name of the signal
+  unsigned long samples;    ///< Number of samples written
+  struct svp_prof_t prof;   ///< Write path counters
+};
+
+
+/**
+ * @brief Storage backend of a file.
+ *
+ * The data stores fill their caches the same way whatever the backend, which
+ * only sees whole caches. Calls are made with the file locked, commits may
+ * be made by the background writer.
+ */
+struct svp_hdf5_data;
+struct svp_backend_t {
+  const char *name;         ///< Name used to select the backend
+  /// Create the file (or directory) fname, returns 0 if successful
+  int (*fopen)(struct svp_hdf5_data *clsdat, const char *fname);
+  /// Close the file, once all of its data stores are closed
+  void (*fclose)(struct svp_hdf5_data *clsdat);
+  /// Add a string attribute to the file
+  void (*fattr)(struct svp_hdf5_data *clsdat, const char *name,
+                const char *value);
+  /// Create the storage of a data store, whose caches exist
+  void (*open)(struct svp_dstore_t *dat);
+  /// Write cptr cached records to records [wptr, wptr + cptr)
+  void (*commit)(struct svp_dstore_t *dat, union svp_tstamp_u *tcache,
+                 void *dcache, unsigned long wptr, unsigned long cptr);
+  /// Make room for num records, NULL if there is nothing to prepare
+  void (*reserve)(struct svp_dstore_t *dat, unsigned long num);
+  /// Add a string attribute, NULL to keep them in attrs until close
+  void (*attr)(struct svp_dstore_t *dat, const char *name, const char *value);
+  /// Finish the storage of a data store, once all of its data is committed
+  void (*close)(struct svp_dstore_t *dat);
+};
+
+
+/**
+ * @brief Raw file of one column, appended through a shared mapping.
+ *
+ */
+struct svp_col_map_t {
+  int fd;                   ///< File descriptor, -1 if there is no file
+  char *base;               ///< Mapping of the file
+  size_t cap;               ///< Size of the file and its mapping (bytes)
+  size_t len;               ///< Bytes written
+};
+
+
+/**
+ * @brief Column backend state of a data store.
+ *
+ */
+struct svp_col_t {
+  unsigned long index;      ///< Number of the column files in the directory
+  struct svp_col_map_t tmap; ///< Timestamps (or change indices) as doubles
+  struct svp_col_map_t dmap; ///< Records, as laid out in the data cache
+};
+
+
+/**
+ * @brief Open group of the signal hierarchy, one node of the group trie.
+ *
+ */
+struct svp_group_t {
+  struct svp_group_t *parent; ///< Enclosing group, NULL for the root
+  const char *name;         ///< Group name within the parent
+  size_t nlen;              ///< Length of the name
+  hid_t gid;                ///< Group handle
+};
+
+
+/**
+ * @brief One field of a row group.
+ *
+ */
+struct svp_field_t {
+  const char *name;         ///< Field name, a member of the row compound
+  hid_t h5type;             ///< Native atomic datatype of each lane
+  int esize;                ///< Size of each lane in the record (bytes)
+  int size;                 ///< Number of lanes
+  int width;                ///< Bits per lane in the packed row
+  int is_signed;            ///< Lanes are sign-extended from width bits
+  size_t offset;            ///< Offset of the field in the record (bytes)
+  unsigned long bit;        ///< Offset of lane 0 in the packed row (bits)
+};
+
+
+/**
+ * @brief Signals of one clock domain, stored as one row per tick.
+ *
+ */
+struct svp_rows_t {
+  struct svp_hdf5_data *file; ///< File containing the row group
+  const char *name;         ///< Fully-qualified name of the dataset
+  double period;            ///< Clock period
+  double start;             ///< Time of the first row
+  int nfield;               ///< Number of fields
+  int fcap;                 ///< Capacity of fields
+  struct svp_field_t *fields; ///< Fields, in the order they were added
+  size_t rsize;             ///< Size of one record (bytes)
+  unsigned long nbits;      ///< Width of the packed row (bits)
+  void *row;                ///< Staging record of svp_rows_write_packed
+  struct svp_dstore_t *dat; ///< Data store of the rows, once registered
+};
+
+
 /**
  * @brief State information for a data destination in the HD5 file.
  *
  */
 struct svp_dstore_t {
   const char *name;         ///< Name of simulation variable being stored
+  struct svp_hdf5_data *file; ///< File containing this data store
   enum svp_storage_e store_type; ///< Storage type of dstore
-  hid_t dspc;               ///< Dataspace handle
+  hid_t dspc;               ///< Dataspace handle (tracks dataset extent)
+  hid_t mspc;               ///< Memory dataspace of a full cache
   hid_t dtyp;               ///< Datatype (compound) handle
   hid_t dset;               ///< Dataset handle
+  hid_t aobj;               ///< Object holding the attributes
+  // Time column, when timestamps are stored as a dataset of their own
+  int columns;              ///< Time and data are separate datasets
+  hid_t tgrp;               ///< Group holding the time and data datasets
+  hid_t tset;               ///< Time dataset handle
+  hid_t tspc;               ///< Time dataspace handle (tracks dataset extent)
+  hid_t tmspc;              ///< Memory dataspace of a full time cache
+  hid_t t_tid;              ///< Time datatype, the same in memory and on disk
   // Memory views for accessing time and data separately
   hid_t xfer_id;            ///< Transfer ID
   hid_t t_mid;              ///< Time memory view
   hid_t d_mid;              ///< Array data memory view
+  hid_t r_mid;              ///< Memory view of whole interleaved records
   // Write tracking
   unsigned long wptr;       ///< Total number of elements written
   unsigned long size;       ///< Current size of file buffer
+  unsigned long expect;     ///< Expected total number of elements
   // Description of the actual data being stored
   hid_t h5type;             ///< Raw atomic datatype
   int rank;                 ///< Number of dimensions of each data element
   hsize_t *dims;            ///< Rank-size list of individual array dimensions
+  int precision;            ///< Significant bits per integer, 0 for all
+  struct svp_attr_t *attrs; ///< Attributes added before the dataset existed
+  // Dataset storage
+  int flat;                 ///< Stored as a plain (non-compound) array
+  int pwidth;               ///< Bits per lane when bit-packed, 0 if not
+  unsigned long palign;     ///< Records which fill a whole number of bytes
+  int frank;                ///< Rank of the dataset
+  hsize_t *cdims;           ///< Chunk dims of split records, NULL if whole
+  int nfilt;                ///< Number of filters in the dataset pipeline
+  struct svp_filter_t filt; ///< Compression filters
+  // On-disk record layout
+  size_t rstride;           ///< Size of one dataset record (bytes)
+  size_t toffset;           ///< Offset of the timestamp within a record
+  size_t doffset;           ///< Offset of the data within a record
+  long tick;                ///< Integer time ticks per ns, 0 for doubles
+  long long tlast;          ///< Last tick written, base of the next delta
+  void *ccache;             ///< Staging area for one interleaved chunk
+  void *scache;             ///< Staging area for one shuffled chunk
+  void *zcache;             ///< Staging area for one compressed chunk
   // Cache data
+  unsigned long clen;       ///< Records per chunk (and per full cache)
+  unsigned long ccap;       ///< Records the cache can currently hold
   hssize_t cstride;         ///< Cache data stride (bytes)
   unsigned long cptr;       ///< Cache pointer
-  double *tcache;           ///< Timestamp cache
+  union svp_tstamp_u *tcache; ///< Timestamp cache
   void *dcache;             ///< Data cache
+  // Value changes
+  void *prev;               ///< Last sample written, NULL if not tracked
+  unsigned long nsample;    ///< Number of samples written
+  unsigned long rcount;     ///< Records counted towards the segment limits
+  // Cache memory accounting
+  size_t cache_bytes;       ///< Memory held by the caches (bytes)
+  size_t cache_peak;        ///< Largest value of cache_bytes
+  unsigned long ctick;      ///< File cache_tick when the cache last filled
+  unsigned long nspill;     ///< Number of caches written before being full
+  // Background writer data
+  union svp_tstamp_u *tcache_bk; ///< Timestamp cache being written
+  void *dcache_bk;          ///< Data cache being written
+  int io_busy;              ///< Back caches are owned by the writer thread
+  struct svp_io_job_t job;  ///< Queue entry for the back caches
+  // Profiling
+  struct svp_prof_t prof;   ///< Write path counters
+  // Backend
+  struct svp_col_t *col;    ///< Column backend state, NULL for HDF5
 };
 
 
 struct svp_hdf5_data {
   const char *name;
+  const struct svp_backend_t *backend; ///< Storage backend of the file
   hid_t fptr;
   int num_signals;
+  int max_signals;          ///< Capacity of dptr
   struct svp_dstore_t **dptr;
+  unsigned long hcap;       ///< Number of slots in htab (a power of two)
+  struct svp_dstore_t **htab; ///< Registered signals, indexed by name
+  struct svp_arena_t arena; ///< Memory of the data stores and their caches
+  // Group trie
+  struct svp_group_t *groot; ///< Root group, opened with the first signal
+  unsigned long gcap;       ///< Number of slots in gtab (a power of two)
+  unsigned long ngroups;    ///< Number of groups in gtab
+  struct svp_group_t **gtab; ///< Open groups, indexed by parent and name
+  struct svp_group_t *glast; ///< Parent group of the last signal
+  char *gpath;              ///< Hierarchy path of glast (not terminated)
+  size_t glen;              ///< Length of gpath
+  size_t gpath_cap;         ///< Capacity of gpath
+  struct svp_filter_t filt; ///< Default compression filters
+  size_t chunk_bytes;       ///< Target chunk size of new data stores (bytes)
+  enum svp_lazy_e lazy;     ///< When datasets of new data stores are created
+  double time_res;          ///< Seconds per integer time tick, 0 for doubles
+  enum svp_layout_e layout; ///< Layout of new timestamped data stores
+  // Cache memory budget
+  size_t cache_budget;      ///< Limit on the total cache memory, 0 for none
+  size_t cache_used;        ///< Total cache memory of all data stores
+  size_t cache_peak;        ///< Largest value of cache_used
+  unsigned long cache_tick; ///< Counts cache fills, for least-recent order
+  // Background writer
+  int async_io;             ///< Flushes are done by the writer thread
+  int io_stop;              ///< Writer should exit once the queue is empty
+  pthread_t io_thread;      ///< Writer thread
+  pthread_mutex_t io_mtx;   ///< Protects the queue and io_busy flags
+  pthread_mutex_t h5_mtx;   ///< Serializes calls into the HDF5 library
+  pthread_mutex_t *h5_lock; ///< Lock of HDF5 calls, NULL if none is needed
+  pthread_cond_t io_wake;   ///< Wakes the writer when a job is queued
+  pthread_cond_t io_done;   ///< Wakes the simulator when a job is written
+  struct svp_io_job_t *io_head; ///< Oldest queued job
+  struct svp_io_job_t *io_tail; ///< Newest queued job
+  // Compression worker pool
+  int zp_nthreads;          ///< Number of worker threads, 0 if disabled
+  int zp_stop;              ///< Workers should exit once the queue is empty
+  pthread_t *zp_threads;    ///< Worker threads
+  pthread_mutex_t zp_mtx;   ///< Protects the queue and job states
+  pthread_cond_t zp_wake;   ///< Wakes workers when a job is queued
+  pthread_cond_t zp_done;   ///< Wakes the writer when a job is compressed
+  struct svp_io_job_t *zp_head; ///< Oldest job waiting for compression
+  struct svp_io_job_t *zp_tail; ///< Newest job waiting for compression
+  // Write path profiling
+  int profile;              ///< Copies and HDF5 calls are timed
+  int prof_topn;            ///< Signals in each list of the report at close
+  unsigned long long prof_c0; ///< Cycle count when profiling started
+  double prof_t0;           ///< Monotonic time when profiling started (s)
+  struct svp_prof_rec_t *prof_log; ///< Profiles of the closed data stores
+  int prof_nlog;            ///< Number of entries in prof_log
+  // Column backend
+  FILE *col_fp;             ///< Manifest of the column files
+  unsigned long col_count;  ///< Number of data stores given column files
+  // Shards
+  int nshards;              ///< Number of shard files, 0 if not sharded
+  int shard_next;           ///< Shard given the next data store
+  struct svp_hdf5_data **shards; ///< Files which hold the data stores
+  pthread_mutex_t shard_mtx; ///< HDF5 lock of all shards, if not threadsafe
+  // Rollover
+  int roll;                 ///< Signals are written to a series of segments
+  double roll_period;       ///< Sim time per segment (ns), 0 for no limit
+  double roll_at;           ///< Timestamp which ends the segment (ns)
+  unsigned long roll_max_samples; ///< Records per segment, 0 for no limit
+  size_t roll_max_bytes;    ///< Bytes per segment, 0 for no limit
+  unsigned long roll_samples; ///< Records written to the current segment
+  size_t roll_bytes;        ///< Bytes written to the current segment
+  int roll_seg;             ///< Number of the current segment
+  int roll_linked;          ///< Number of segments linked from the index
 };  // svp_hdf5_data
 
 
@@ -104,29 +503,46 @@ struct svp_hdf5_data {
 ///////////////////////////////////////////////////////////////////////////////
 
 /**
- * @brief Reconstruct a signal absolute path hierarchy in HD5 groups.
+ * @brief Add string attribute to HDF5 object.
+ *
+ * @param obj_id Object receiving attribute.
+ * @param name Attribute name.
+ * @param value Attribute value.
+ * @return herr_t Error code, returns 0 if successful.
+ */
+herr_t svp_add_attr(hid_t obj_id, char *name, char *value);
+
+
+/**
+ * @brief Parse a compression filter specification.
  *
- * @param fid Starting object, usually file ID.
- * @param full_name The full path to the signal.
- * @param gid Final group ID containing the actual signal.
- * @param sig_name Actual signal name.
+ * @param spec Filters joined with '+', e.g. "shuffle+deflate:4".
+ * @param filt Parsed filter settings.
+ * @return int Returns 0 if successful.
  *
- * This performs a similar function to the python os.mkdirs() function, in that
- * any intermediate hierarchy (containing submodules) are constructed as HD5
- * groups if they do not already exist.
+ * Recognized filters are none, shuffle, deflate[:level], nbit, scaleoffset
+ * and bitpack. The deflate level defaults to 4.
  */
-void svp_group_hierarchy_split(hid_t fid, const char *full_name, hid_t *gid,
-                               char **sig_name);
+int svp_filter_parse(const char *spec, struct svp_filter_t *filt);
 
 
 /**
- * @brief Add string attribute to HDF5 object.
+ * @brief Add compression filters to a dataset creation property list.
  *
- * @param obj_id Object receiving attribute.
- * @param name Attribute name.
- * @param value Attribute value.
+ * @param prop Dataset creation property list (already chunked).
+ * @param filt Filter settings.
  * @return herr_t Error code, returns 0 if successful.
  */
-herr_t svp_add_attr(hid_t obj_id, char *name, char *value);
+herr_t svp_filter_apply(hid_t prop, const struct svp_filter_t *filt);
+
+
+/**
+ * @brief Look up the HDF5 datatype of an SV-facing type name.
+ *
+ * @param dtype One of char, uchar, sint, usint, int, uint, long, ulong,
+ * double.
+ * @return hid_t Native atomic datatype, H5I_INVALID_HID if unknown.
+ */
+hid_t svp_dtype_lookup(const char *dtype);
 
 #endif
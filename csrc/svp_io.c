@@ -0,0 +1,573 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Cache flushing to the HDF5 file, and the optional background writer thread
+// which performs those flushes off the simulator thread.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: Geometric dataset growth, persistent dataspaces.
+// 16-Oct-26: Direct chunk write of full, aligned caches.
+// 16-Oct-26: Support plain array datasets, skip direct writes when filtered.
+// 16-Oct-26: Commit chunks compressed by the worker pool.
+// 16-Oct-26: Chunk length taken from the data store.
+// 16-Oct-26: Back caches count towards the cache memory budget.
+// 16-Oct-26: Staging and back caches are allocated from the file arena.
+// 16-Oct-26: Bit-packed data stores are packed as they are committed.
+// 16-Oct-26: Timestamped records are written in one pass, integer ticks.
+// 16-Oct-26: Time columns are written as datasets of their own.
+// 16-Oct-26: No direct chunk writes of records split across chunks.
+// 16-Oct-26: Count flushes and bytes, time the HDF5 calls when profiled.
+// 16-Oct-26: The writer thread commits through the file backend.
+// 16-Oct-26: The HDF5 lock may be shared by the shards of a file.
+// 16-Oct-26: Ticks are cached as integers, in a typed time cache.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "svp_io.h"
+#include "svp_zpool.h"
+#include "svp_cache.h"
+#include "svp_arena.h"
+#include "svp_bits.h"
+#include "svp_prof.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Select a block of records in a dataspace.
+ *
+ * @param dat Data store owning the dataspace.
+ * @param spc Dataspace (file or memory) to select in.
+ * @param start First record.
+ * @param count Number of records.
+ *
+ * Plain array datasets carry the record dimensions, which are always fully
+ * selected.
+ */
+static void svp_io_select(struct svp_dstore_t *dat, hid_t spc,
+                          unsigned long start, unsigned long count) {
+  hsize_t ofst[H5S_MAX_RANK] = {0};
+  hsize_t cnt[H5S_MAX_RANK] = {0};
+  ofst[0] = start;
+  cnt[0] = count;
+  for (int ii = 1; dat->frank > ii; ++ii) {
+    cnt[ii] = dat->dims[ii - 1];
+  }
+  H5Sselect_hyperslab(spc, H5S_SELECT_SET, ofst, NULL, cnt, NULL);
+}  // svp_io_select
+
+
+#ifdef SVP_DIRECT_CHUNK
+/**
+ * @brief Write one chunk of a dataset without the HDF5 filter pipeline.
+ *
+ * @param dat Data store being written.
+ * @param dset Dataset of the data store (the data or the time column).
+ * @param wptr Dataset offset of the chunk (a multiple of clen).
+ * @param buf Chunk contents, already filtered if the dataset has filters.
+ * @param nbytes Size of the chunk contents.
+ */
+static void svp_io_write_chunk(struct svp_dstore_t *dat, hid_t dset,
+                               unsigned long wptr, const void *buf,
+                               size_t nbytes) {
+  hsize_t ofst[H5S_MAX_RANK] = {0};
+  ofst[0] = wptr;
+  unsigned long long start = svp_prof_start(dat);
+  H5Dwrite_chunk(dset, H5P_DEFAULT, 0, ofst, nbytes, buf);
+  svp_prof_stop(&dat->prof.t_write, start);
+}  // svp_io_write_chunk
+#endif
+
+
+/**
+ * @brief Read a cached tick.
+ *
+ * @param dat Data store with an integer time base.
+ * @param tick Cached tick, of the remainder for time stores.
+ * @param dptr Cached data of the record, whole ns for time stores.
+ * @return long long Tick of the record.
+ */
+static inline long long svp_io_tick(const struct svp_dstore_t *dat,
+                                    long long tick, const void *dptr) {
+  if (SVP_STORE_SIM_TIME == dat->store_type) {
+    long ns;
+    memcpy(&ns, dptr, sizeof(ns));
+    tick += (long long)ns * dat->tick;
+  }
+  return tick;
+}  // svp_io_tick
+
+
+/**
+ * @brief Delta-encode cached integer ticks.
+ *
+ * @param dat Data store with an integer time base.
+ * @param tcache Timestamp cache.
+ * @param dcache Data cache.
+ * @param wptr Dataset offset of the first record.
+ * @param num Number of records.
+ * @param out Where the first tick is stored, which may be tcache itself.
+ * @param stride Distance between consecutive ticks in out (bytes).
+ *
+ * Each tick is stored as the difference from the tick of the previous
+ * record, except for the first record of each chunk, which holds the
+ * absolute tick so that chunks decode on their own.
+ */
+static void svp_io_deltas(struct svp_dstore_t *dat,
+                          const union svp_tstamp_u *tcache,
+                          const void *dcache, unsigned long wptr,
+                          unsigned long num, char *out, size_t stride) {
+  unsigned long cpos = wptr % dat->clen;
+  long long prev = dat->tlast;
+  const char *dptr = (const char *)dcache;
+  for (unsigned long ii = 0; num > ii; ++ii) {
+    long long tick = svp_io_tick(dat, tcache[ii].tick, dptr);
+    long long delta = (cpos) ? tick - prev : tick;
+    memcpy(out, &delta, sizeof(delta));
+    prev = tick;
+    cpos = (dat->clen == cpos + 1) ? 0 : cpos + 1;
+    out += stride;
+    dptr += dat->cstride;
+  }
+  dat->tlast = prev;
+}  // svp_io_deltas
+
+
+/**
+ * @brief Interleave cached records into the on-disk layout.
+ *
+ * @param dat Data store with a time cache.
+ * @param tcache Timestamp cache.
+ * @param dcache Data cache.
+ * @param wptr Dataset offset of the first record.
+ * @param num Number of records, at most clen.
+ * @return void* The staging area, holding num records.
+ *
+ * Integer ticks are delta-encoded (see svp_io_deltas), and those of time
+ * stores replace their data.
+ */
+static void *svp_io_records(struct svp_dstore_t *dat,
+                            const union svp_tstamp_u *tcache,
+                            const void *dcache, unsigned long wptr,
+                            unsigned long num) {
+  if (!dat->ccache) {
+    dat->ccache = svp_arena_alloc(&dat->file->arena,
+                                  dat->clen * dat->rstride);
+  }
+  char *rptr = (char *)dat->ccache;
+  if (dat->tick) {
+    svp_io_deltas(dat, tcache, dcache, wptr, num, rptr + dat->toffset,
+                  dat->rstride);
+  }
+  int copy_data = !dat->tick || (SVP_STORE_SIM_TIME != dat->store_type);
+  const char *dptr = (const char *)dcache;
+  for (unsigned long ii = 0; num > ii; ++ii) {
+    if (!dat->tick) {
+      memcpy(rptr + dat->toffset, &tcache[ii], sizeof(*tcache));
+    }
+    if (copy_data) {
+      memcpy(rptr + dat->doffset, dptr, dat->cstride);
+    }
+    rptr += dat->rstride;
+    dptr += dat->cstride;
+  }
+  return dat->ccache;
+}  // svp_io_records
+
+
+/**
+ * @brief Write cached timestamps to the time column of a data store.
+ *
+ * @param dat Data store with its time stored as a dataset of its own.
+ * @param tcache Timestamp cache.
+ * @param dcache Data cache.
+ * @param wptr Dataset offset of the first record.
+ * @param cptr Number of records.
+ *
+ * Integer ticks are delta-encoded in place, the timestamps are not used
+ * again once they are committed.
+ */
+static void svp_io_commit_time(struct svp_dstore_t *dat,
+                               union svp_tstamp_u *tcache,
+                               const void *dcache, unsigned long wptr,
+                               unsigned long cptr) {
+  if (dat->tick) {
+    unsigned long long start = svp_prof_start(dat);
+    svp_io_deltas(dat, tcache, dcache, wptr, cptr, (char *)tcache,
+                  sizeof(*tcache));
+    svp_prof_stop(&dat->prof.t_stage, start);
+  }
+#ifdef SVP_DIRECT_CHUNK
+  if ((0 == dat->nfilt) && !dat->cdims && (dat->clen == cptr) &&
+      (0 == wptr % dat->clen)) {
+    svp_io_write_chunk(dat, dat->tset, wptr, tcache,
+                       dat->clen * sizeof(*tcache));
+    return;
+  }
+#endif
+  hsize_t start = wptr;
+  hsize_t count = cptr;
+  hsize_t mstart = 0;
+  H5Sselect_hyperslab(dat->tmspc, H5S_SELECT_SET, &mstart, NULL, &count,
+                      NULL);
+  H5Sselect_hyperslab(dat->tspc, H5S_SELECT_SET, &start, NULL, &count, NULL);
+  unsigned long long tstart = svp_prof_start(dat);
+  H5Dwrite(dat->tset, dat->t_tid, dat->tmspc, dat->tspc, H5P_DEFAULT, tcache);
+  svp_prof_stop(&dat->prof.t_write, tstart);
+}  // svp_io_commit_time
+
+
+/**
+ * @brief Pack cached records into a bit stream, and write it.
+ *
+ * @param dat Bit-packed data store.
+ * @param dcache Data cache.
+ * @param wptr Dataset offset of the first record (a multiple of palign).
+ * @param cptr Number of records.
+ *
+ * The stream is packed into the staging area, which is never larger than the
+ * cache. Records before wptr fill whole bytes, so the write starts on a byte
+ * of its own.
+ */
+static void svp_io_commit_packed(struct svp_dstore_t *dat, void *dcache,
+                                 unsigned long wptr, unsigned long cptr) {
+  if (!dat->ccache) {
+    dat->ccache = svp_arena_alloc(&dat->file->arena,
+                                  dat->clen * dat->rstride);
+  }
+  unsigned long long tstart = svp_prof_start(dat);
+  hsize_t count = svp_bits_pack(dat->ccache, dcache, cptr * dat->cstride,
+                                dat->pwidth);
+  svp_prof_stop(&dat->prof.t_stage, tstart);
+  hsize_t start = svp_io_extent(dat, wptr);
+#ifdef SVP_DIRECT_CHUNK
+  // A full, aligned cache packs into exactly one chunk
+  if ((0 == dat->nfilt) && (dat->clen == cptr) && (0 == wptr % dat->clen)) {
+    svp_io_write_chunk(dat, dat->dset, start, dat->ccache, count);
+    return;
+  }
+#endif
+  hsize_t mstart = 0;
+  H5Sselect_hyperslab(dat->mspc, H5S_SELECT_SET, &mstart, NULL, &count, NULL);
+  H5Sselect_hyperslab(dat->dspc, H5S_SELECT_SET, &start, NULL, &count, NULL);
+  tstart = svp_prof_start(dat);
+  H5Dwrite(dat->dset, dat->d_mid, dat->mspc, dat->dspc, dat->xfer_id,
+           dat->ccache);
+  svp_prof_stop(&dat->prof.t_write, tstart);
+}  // svp_io_commit_packed
+
+
+/**
+ * @brief Write a chunk that was compressed by the worker pool.
+ *
+ * @param job Completed compression job.
+ */
+static void svp_io_commit_filtered(struct svp_io_job_t *job) {
+  struct svp_dstore_t *dat = job->dat;
+  if (job->wptr + job->cptr > dat->size) {
+    svp_io_grow(dat, job->wptr + job->cptr);
+  }
+  dat->prof.flushes += 1;
+  dat->prof.bytes += job->cptr * dat->rstride;
+#ifdef SVP_DIRECT_CHUNK
+  svp_io_write_chunk(dat, dat->dset, job->wptr, job->zbuf, job->zsize);
+#endif
+}  // svp_io_commit_filtered
+
+
+/**
+ * @brief Main loop of the background writer thread.
+ *
+ * @param arg File handle (struct svp_hdf5_data *).
+ * @return void* Always NULL.
+ *
+ * Jobs are written in the order they were queued. The loop only exits once
+ * a stop has been requested AND the queue is empty, so no data is lost.
+ */
+static void *svp_io_main(void *arg) {
+  struct svp_hdf5_data *clsdat = (struct svp_hdf5_data *)arg;
+  struct svp_io_job_t *job;
+  pthread_mutex_lock(&clsdat->io_mtx);
+  while (1) {
+    // Sleep until there is something to do
+    while (!clsdat->io_head && !clsdat->io_stop) {
+      pthread_cond_wait(&clsdat->io_wake, &clsdat->io_mtx);
+    }
+    if (!clsdat->io_head) {
+      // Stop was requested and the queue is drained
+      break;
+    }
+    // Pop the oldest job
+    job = clsdat->io_head;
+    clsdat->io_head = job->next;
+    if (!clsdat->io_head) {
+      clsdat->io_tail = NULL;
+    }
+    pthread_mutex_unlock(&clsdat->io_mtx);
+    // Compressed chunks are committed in queue order, wait for this one
+    if (job->zstate) {
+      svp_zpool_wait(job);
+    }
+    // Write the data, holding the HDF5 library for the duration
+    pthread_mutex_lock(clsdat->h5_lock);
+    if (job->zstate) {
+      svp_io_commit_filtered(job);
+    } else {
+      clsdat->backend->commit(job->dat, job->tcache, job->dcache, job->wptr,
+                              job->cptr);
+    }
+    pthread_mutex_unlock(clsdat->h5_lock);
+    // Release the back cache to the simulator thread
+    pthread_mutex_lock(&clsdat->io_mtx);
+    job->dat->io_busy = 0;
+    pthread_cond_broadcast(&clsdat->io_done);
+  }
+  pthread_mutex_unlock(&clsdat->io_mtx);
+  return NULL;
+}  // svp_io_main
+
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+void *svp_io_layout(struct svp_dstore_t *dat, union svp_tstamp_u *tcache,
+                    void *dcache) {
+  if (!dat->t_mid) {
+    // Synchronous data is already in the on-disk layout
+    return dcache;
+  }
+  // Interleave time and data into the staging area
+  return svp_io_records(dat, tcache, dcache, 0, dat->clen);
+}  // svp_io_layout
+
+
+hsize_t svp_io_extent(const struct svp_dstore_t *dat, unsigned long num) {
+  if (dat->pwidth) {
+    return ((hsize_t)num * dat->pwidth * dat->cstride + 7) / 8;
+  }
+  return num;
+}  // svp_io_extent
+
+
+void svp_io_grow(struct svp_dstore_t *dat, unsigned long need) {
+  // Double the current size, unless the user told us what to expect
+  unsigned long size = 2 * dat->size;
+  if (dat->expect >= need) {
+    size = dat->expect;
+  }
+  if (need > size) {
+    size = need;
+  }
+  // Round up to a whole number of chunks
+  size = dat->clen * ((size + dat->clen - 1) / dat->clen);
+  hsize_t cdims[H5S_MAX_RANK] = {0};
+  hsize_t cmaxdims[H5S_MAX_RANK] = {0};
+  cdims[0] = svp_io_extent(dat, size);
+  cmaxdims[0] = H5S_UNLIMITED;
+  for (int ii = 1; dat->frank > ii; ++ii) {
+    cdims[ii] = dat->dims[ii - 1];
+    cmaxdims[ii] = dat->dims[ii - 1];
+  }
+  unsigned long long start = svp_prof_start(dat);
+  H5Dset_extent(dat->dset, cdims);
+  // Keep the cached file dataspace in step with the dataset
+  H5Sset_extent_simple(dat->dspc, dat->frank, cdims, cmaxdims);
+  // The time column has a record per data record
+  if (dat->tset) {
+    H5Dset_extent(dat->tset, cdims);
+    H5Sset_extent_simple(dat->tspc, 1, cdims, cmaxdims);
+  }
+  svp_prof_stop(&dat->prof.t_extent, start);
+  dat->size = size;
+}  // svp_io_grow
+
+
+void svp_io_reserve(struct svp_dstore_t *dat, unsigned long num) {
+  if (num > dat->size) {
+    svp_io_grow(dat, num);
+  }
+}  // svp_io_reserve
+
+
+void svp_io_commit(struct svp_dstore_t *dat, union svp_tstamp_u *tcache,
+                   void *dcache, unsigned long wptr, unsigned long cptr) {
+  if (0 == cptr) {
+    return;
+  }
+  // Make sure the dataset is large enough to receive the data
+  if (wptr + cptr > dat->size) {
+    svp_io_grow(dat, wptr + cptr);
+  }
+  dat->prof.flushes += 1;
+  dat->prof.bytes += dat->pwidth ? svp_io_extent(dat, cptr)
+                                 : cptr * dat->rstride;
+  if (dat->pwidth) {
+    svp_io_commit_packed(dat, dcache, wptr, cptr);
+    return;
+  }
+  // Records with a timestamp are interleaved, so they are written in one
+  // pass (including svp_sim_time_t data)
+  void *rbuf = dcache;
+  hid_t m_tid = dat->d_mid;
+  if (dat->tset) {
+    // Unless they go to a dataset of their own, ahead of the data
+    svp_io_commit_time(dat, tcache, dcache, wptr, cptr);
+  } else if (dat->t_mid) {
+    unsigned long long start = svp_prof_start(dat);
+    rbuf = svp_io_records(dat, tcache, dcache, wptr, cptr);
+    svp_prof_stop(&dat->prof.t_stage, start);
+    m_tid = dat->r_mid;
+  }
+#ifdef SVP_DIRECT_CHUNK
+  // Fast path, the cache maps exactly onto one unfiltered chunk, which is
+  // already in the on-disk layout so the HDF5 type conversion is skipped
+  if ((0 == dat->nfilt) && !dat->cdims && (dat->clen == cptr) &&
+      (0 == wptr % dat->clen)) {
+    svp_io_write_chunk(dat, dat->dset, wptr, rbuf, dat->clen * dat->rstride);
+    return;
+  }
+#endif
+  // Define the hyperslab where data will be written
+  svp_io_select(dat, dat->mspc, 0, cptr);
+  svp_io_select(dat, dat->dspc, wptr, cptr);
+  // Write data
+  unsigned long long start = svp_prof_start(dat);
+  H5Dwrite(dat->dset, m_tid, dat->mspc, dat->dspc, dat->xfer_id, rbuf);
+  svp_prof_stop(&dat->prof.t_write, start);
+}  // svp_io_commit
+
+
+void svp_io_submit(struct svp_dstore_t *dat) {
+  struct svp_hdf5_data *clsdat = dat->file;
+  // Allocate the back caches on first use
+  if (!dat->dcache_bk) {
+    dat->dcache_bk = svp_arena_alloc(&dat->file->arena,
+                                     dat->clen * dat->cstride);
+    svp_cache_track(dat, dat->clen * dat->cstride);
+    if (dat->tcache) {
+      dat->tcache_bk = svp_arena_alloc(&dat->file->arena,
+                                       dat->clen * sizeof(*dat->tcache_bk));
+      svp_cache_track(dat, dat->clen * sizeof(*dat->tcache_bk));
+    }
+  }
+  pthread_mutex_lock(&clsdat->io_mtx);
+  // The back cache may still be owned by the writer
+  while (dat->io_busy) {
+    pthread_cond_wait(&clsdat->io_done, &clsdat->io_mtx);
+  }
+  // Swap front and back caches
+  union svp_tstamp_u *tcache = dat->tcache;
+  void *dcache = dat->dcache;
+  dat->tcache = dat->tcache_bk;
+  dat->dcache = dat->dcache_bk;
+  dat->tcache_bk = tcache;
+  dat->dcache_bk = dcache;
+  // Describe the write and append it to the queue
+  dat->job.dat = dat;
+  dat->job.tcache = tcache;
+  dat->job.dcache = dcache;
+  dat->job.wptr = dat->wptr;
+  dat->job.cptr = dat->cptr;
+  dat->job.next = NULL;
+  dat->job.zstate = svp_zpool_eligible(&dat->job) ? 1 : 0;
+  if (clsdat->io_tail) {
+    clsdat->io_tail->next = &dat->job;
+  } else {
+    clsdat->io_head = &dat->job;
+  }
+  clsdat->io_tail = &dat->job;
+  dat->io_busy = 1;
+  pthread_cond_signal(&clsdat->io_wake);
+  pthread_mutex_unlock(&clsdat->io_mtx);
+  // The writer waits for the compressed chunk if the pool takes the job
+  if (dat->job.zstate) {
+    svp_zpool_submit(&dat->job);
+  }
+  // Now update the write and cache pointers
+  dat->wptr += dat->cptr;
+  dat->cptr = 0;
+}  // svp_io_submit
+
+
+void svp_io_wait(struct svp_dstore_t *dat) {
+  struct svp_hdf5_data *clsdat = dat->file;
+  if (!clsdat->async_io) {
+    return;
+  }
+  pthread_mutex_lock(&clsdat->io_mtx);
+  while (dat->io_busy) {
+    pthread_cond_wait(&clsdat->io_done, &clsdat->io_mtx);
+  }
+  pthread_mutex_unlock(&clsdat->io_mtx);
+}  // svp_io_wait
+
+
+int svp_io_start(struct svp_hdf5_data *clsdat) {
+  if (clsdat->async_io) {
+    return 0;
+  }
+  clsdat->io_head = NULL;
+  clsdat->io_tail = NULL;
+  clsdat->io_stop = 0;
+  pthread_mutex_init(&clsdat->io_mtx, NULL);
+  pthread_mutex_init(&clsdat->h5_mtx, NULL);
+  pthread_cond_init(&clsdat->io_wake, NULL);
+  pthread_cond_init(&clsdat->io_done, NULL);
+  // Unless a lock shared with other files was given
+  if (!clsdat->h5_lock) {
+    clsdat->h5_lock = &clsdat->h5_mtx;
+  }
+  if (pthread_create(&clsdat->io_thread, NULL, svp_io_main, clsdat)) {
+    fprintf(stderr, "ERROR %s: Could not start writer thread for %s\n",
+            __func__, clsdat->name);
+    return 1;
+  }
+  clsdat->async_io = 1;
+  return 0;
+}  // svp_io_start
+
+
+void svp_io_stop(struct svp_hdf5_data *clsdat) {
+  if (!clsdat->async_io) {
+    return;
+  }
+  // Request the stop, the thread exits once the queue is empty
+  pthread_mutex_lock(&clsdat->io_mtx);
+  clsdat->io_stop = 1;
+  pthread_cond_signal(&clsdat->io_wake);
+  pthread_mutex_unlock(&clsdat->io_mtx);
+  pthread_join(clsdat->io_thread, NULL);
+  // Tear down synchronization objects
+  pthread_cond_destroy(&clsdat->io_done);
+  pthread_cond_destroy(&clsdat->io_wake);
+  pthread_mutex_destroy(&clsdat->h5_mtx);
+  pthread_mutex_destroy(&clsdat->io_mtx);
+  if (&clsdat->h5_mtx == clsdat->h5_lock) {
+    clsdat->h5_lock = NULL;
+  }
+  clsdat->async_io = 0;
+}  // svp_io_stop
+
+
+void svp_io_lock(struct svp_hdf5_data *clsdat) {
+  if (clsdat->h5_lock) {
+    pthread_mutex_lock(clsdat->h5_lock);
+  }
+}  // svp_io_lock
+
+
+void svp_io_unlock(struct svp_hdf5_data *clsdat) {
+  if (clsdat->h5_lock) {
+    pthread_mutex_unlock(clsdat->h5_lock);
+  }
+}  // svp_io_unlock
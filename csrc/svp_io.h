@@ -0,0 +1,166 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Cache flushing to the HDF5 file, and the optional background writer thread
+// which performs those flushes off the simulator thread.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: Geometric dataset growth, persistent dataspaces.
+// 16-Oct-26: Exposed the on-disk chunk layout for the compression pool.
+// 16-Oct-26: Added the dataset extent of bit-packed data stores.
+// 16-Oct-26: Timestamped records are committed in a single write.
+// 16-Oct-26: Added the dataset reservation of the HDF5 backend.
+// 16-Oct-26: The HDF5 lock may be shared by the shards of a file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SVP__IO__H__
+#define __SVP__IO__H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "hdf5.h"
+#include "svp_hdf5_defs.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Arrange a full cache in the on-disk record layout.
+ *
+ * @param dat Data store owning the caches.
+ * @param tcache Timestamp cache.
+ * @param dcache Data cache.
+ * @return void* Contents of one full chunk, as stored in the file.
+ *
+ * Synchronous data is already in the on-disk layout and is returned as is.
+ * Otherwise the time and data caches are interleaved into the staging area
+ * of the data store, which is only valid until the next call.
+ */
+void *svp_io_layout(struct svp_dstore_t *dat, union svp_tstamp_u *tcache,
+                    void *dcache);
+
+
+/**
+ * @brief Dataset extent which holds a number of records.
+ *
+ * @param dat Data store owning the dataset.
+ * @param num Number of records.
+ * @return hsize_t Length of the first dataset dimension.
+ *
+ * This is num, except for bit-packed data stores whose dataset is a stream
+ * of bytes, where the last byte may be partly filled.
+ */
+hsize_t svp_io_extent(const struct svp_dstore_t *dat, unsigned long num);
+
+
+/**
+ * @brief Grow the dataset extent so that it can hold a number of elements.
+ *
+ * @param dat Data store owning the dataset.
+ * @param need Minimum number of elements the dataset must hold.
+ *
+ * The extent is doubled (or set to the expected element count, if one was
+ * given) rather than grown by a single chunk, so that H5Dset_extent is only
+ * called O(log(N)) times. Unwritten chunks take no space in the file, and
+ * the extent is trimmed to the written size when the data store is closed.
+ */
+void svp_io_grow(struct svp_dstore_t *dat, unsigned long need);
+
+
+/**
+ * @brief Grow the dataset extent, if needed, to hold a number of elements.
+ *
+ * @param dat Data store owning the dataset.
+ * @param num Number of elements expected.
+ */
+void svp_io_reserve(struct svp_dstore_t *dat, unsigned long num);
+
+
+/**
+ * @brief Write a block of cached samples to the dataset.
+ *
+ * @param dat Data store owning the dataset.
+ * @param tcache Timestamp cache (ignored unless the store has a time view).
+ * @param dcache Data cache.
+ * @param wptr Element offset within the dataset where the block starts.
+ * @param cptr Number of cached elements to be written.
+ *
+ * This performs the actual HDF5 calls, growing the dataset first if needed.
+ * Records with a timestamp are interleaved into the staging area first, so
+ * every commit is a single write. It does no locking of its own.
+ */
+void svp_io_commit(struct svp_dstore_t *dat, union svp_tstamp_u *tcache,
+                   void *dcache, unsigned long wptr, unsigned long cptr);
+
+
+/**
+ * @brief Hand the full cache of a data store to the background writer.
+ *
+ * @param dat Data store whose cache is full.
+ *
+ * The front and back caches are swapped, so the caller can keep filling the
+ * cache immediately. If the previous back cache is still being written, this
+ * blocks until the writer is done with it.
+ */
+void svp_io_submit(struct svp_dstore_t *dat);
+
+
+/**
+ * @brief Block until any queued write of the data store has completed.
+ *
+ * @param dat Data store object.
+ */
+void svp_io_wait(struct svp_dstore_t *dat);
+
+
+/**
+ * @brief Start the background writer thread of a file.
+ *
+ * @param clsdat File handle.
+ * @return int Returns 0 if successful.
+ */
+int svp_io_start(struct svp_hdf5_data *clsdat);
+
+
+/**
+ * @brief Drain the write queue and stop the background writer thread.
+ *
+ * @param clsdat File handle.
+ */
+void svp_io_stop(struct svp_hdf5_data *clsdat);
+
+
+/**
+ * @brief Acquire exclusive access to the HDF5 library.
+ *
+ * @param clsdat File handle.
+ *
+ * Only has an effect when the background writer is running (or the file is
+ * a shard, whose lock may be shared by all shards), in which case any HDF5
+ * call made from the simulator thread must be wrapped in a
+ * svp_io_lock()/svp_io_unlock() pair.
+ */
+void svp_io_lock(struct svp_hdf5_data *clsdat);
+
+
+/**
+ * @brief Release exclusive access to the HDF5 library.
+ *
+ * @param clsdat File handle.
+ */
+void svp_io_unlock(struct svp_hdf5_data *clsdat);
+
+#endif
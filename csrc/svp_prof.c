@@ -0,0 +1,280 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Write path profiling. Each data store counts its flushes and bytes, and
+// the time spent copying samples and in the HDF5 calls, which are reported
+// per signal when the file is closed.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "svp_prof.h"
+#include "svp_arena.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Seconds on the monotonic clock.
+ *
+ * @return double Current time (s).
+ */
+static double svp_prof_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}  // svp_prof_now
+
+
+/**
+ * @brief Measure the cycle rate since profiling started.
+ *
+ * @param clsdat File handle.
+ * @param elapsed Seconds since profiling started, 0 if it has not.
+ * @return double Cycles per second.
+ */
+static double svp_prof_rate(const struct svp_hdf5_data *clsdat,
+                            double *elapsed) {
+  if (!clsdat->profile) {
+    *elapsed = 0;
+    return 1e9;
+  }
+  unsigned long long cycles = svp_prof_cycles() - clsdat->prof_c0;
+  *elapsed = svp_prof_now() - clsdat->prof_t0;
+  if ((0 >= *elapsed) || (0 == cycles)) {
+    return 1e9;
+  }
+  return cycles / *elapsed;
+}  // svp_prof_rate
+
+
+/**
+ * @brief Look up a counter by name.
+ *
+ * @param prof Counters.
+ * @param samples Number of samples written.
+ * @param rate Cycles per second.
+ * @param counter Name of the counter (see svp_prof_signal).
+ * @param value Value of the counter, times in seconds.
+ * @return int Returns 0 if the counter exists.
+ */
+static int svp_prof_value(const struct svp_prof_t *prof,
+                          unsigned long samples, double rate,
+                          const char *counter, double *value) {
+  if (0 == strcmp(counter, "samples")) {
+    *value = samples;
+  } else if (0 == strcmp(counter, "bytes")) {
+    *value = prof->bytes;
+  } else if (0 == strcmp(counter, "flushes")) {
+    *value = prof->flushes;
+  } else if (0 == strcmp(counter, "write_s")) {
+    *value = prof->t_write / rate;
+  } else if (0 == strcmp(counter, "extent_s")) {
+    *value = prof->t_extent / rate;
+  } else if (0 == strcmp(counter, "copy_s")) {
+    *value = prof->t_copy / rate;
+  } else if (0 == strcmp(counter, "stage_s")) {
+    *value = prof->t_stage / rate;
+  } else {
+    return 1;
+  }
+  return 0;
+}  // svp_prof_value
+
+
+/**
+ * @brief Add one set of counters to another.
+ *
+ * @param sum Running totals.
+ * @param prof Counters to add.
+ */
+static void svp_prof_add(struct svp_prof_t *sum,
+                         const struct svp_prof_t *prof) {
+  sum->flushes += prof->flushes;
+  sum->bytes += prof->bytes;
+  sum->t_write += prof->t_write;
+  sum->t_extent += prof->t_extent;
+  sum->t_copy += prof->t_copy;
+  sum->t_stage += prof->t_stage;
+}  // svp_prof_add
+
+
+/**
+ * @brief Order profiles by bytes written, largest first.
+ */
+static int svp_prof_by_bytes(const void *a, const void *b) {
+  const struct svp_prof_t *pa = &(*(struct svp_prof_rec_t **)a)->prof;
+  const struct svp_prof_t *pb = &(*(struct svp_prof_rec_t **)b)->prof;
+  return (pa->bytes < pb->bytes) - (pa->bytes > pb->bytes);
+}  // svp_prof_by_bytes
+
+
+/**
+ * @brief Order profiles by time in HDF5 calls, longest first.
+ */
+static int svp_prof_by_time(const void *a, const void *b) {
+  const struct svp_prof_t *pa = &(*(struct svp_prof_rec_t **)a)->prof;
+  const struct svp_prof_t *pb = &(*(struct svp_prof_rec_t **)b)->prof;
+  unsigned long long ta = pa->t_write + pa->t_extent;
+  unsigned long long tb = pb->t_write + pb->t_extent;
+  return (ta < tb) - (ta > tb);
+}  // svp_prof_by_time
+
+
+/**
+ * @brief Print the first profiles of a sorted list.
+ *
+ * @param recs Sorted profiles.
+ * @param num Number of profiles to print.
+ * @param rate Cycles per second.
+ */
+static void svp_prof_table(struct svp_prof_rec_t **recs, int num,
+                           double rate) {
+  printf("%14s %12s %9s %10s %10s %10s %10s  %s\n", "bytes", "samples",
+         "flushes", "write s", "extent s", "copy s", "stage s", "signal");
+  for (int ii = 0; num > ii; ++ii) {
+    const struct svp_prof_t *prof = &recs[ii]->prof;
+    printf("%14llu %12lu %9llu %10.4f %10.4f %10.4f %10.4f  %s\n",
+           prof->bytes, recs[ii]->samples, prof->flushes,
+           prof->t_write / rate, prof->t_extent / rate, prof->t_copy / rate,
+           prof->t_stage / rate, recs[ii]->name);
+  }
+}  // svp_prof_table
+
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+void svp_prof_enable(struct svp_hdf5_data *clsdat, int topn) {
+  clsdat->prof_topn = topn;
+  if (clsdat->profile) {
+    return;
+  }
+  clsdat->prof_c0 = svp_prof_cycles();
+  clsdat->prof_t0 = svp_prof_now();
+  clsdat->profile = 1;
+}  // svp_prof_enable
+
+
+unsigned long svp_prof_samples(const struct svp_dstore_t *dat) {
+  if (SVP_STORE_CHANGE_DATA == dat->store_type) {
+    return dat->nsample;
+  }
+  return dat->wptr + dat->cptr;
+}  // svp_prof_samples
+
+
+double svp_prof_signal(const struct svp_dstore_t *dat, const char *counter) {
+  double elapsed;
+  double rate = svp_prof_rate(dat->file, &elapsed);
+  double value;
+  if (svp_prof_value(&dat->prof, svp_prof_samples(dat), rate, counter,
+                     &value)) {
+    fprintf(stderr, "ERROR %s: Unknown counter: %s\n", __func__, counter);
+    return -1;
+  }
+  return value;
+}  // svp_prof_signal
+
+
+double svp_prof_file(const struct svp_hdf5_data *clsdat, const char *counter) {
+  double elapsed;
+  double rate = svp_prof_rate(clsdat, &elapsed);
+  struct svp_prof_t sum = {0};
+  unsigned long samples = 0;
+  for (int ii = 0; clsdat->num_signals > ii; ++ii) {
+    svp_prof_add(&sum, &clsdat->dptr[ii]->prof);
+    samples += svp_prof_samples(clsdat->dptr[ii]);
+  }
+  double value;
+  if (0 == strcmp(counter, "elapsed_s")) {
+    value = elapsed;
+  } else if (0 == strcmp(counter, "mbps")) {
+    value = (0 < elapsed) ? 1e-6 * sum.bytes / elapsed : 0;
+  } else if (svp_prof_value(&sum, samples, rate, counter, &value)) {
+    fprintf(stderr, "ERROR %s: Unknown counter: %s\n", __func__, counter);
+    return -1;
+  }
+  return value;
+}  // svp_prof_file
+
+
+void svp_prof_keep(struct svp_dstore_t *dat) {
+  struct svp_hdf5_data *clsdat = dat->file;
+  struct svp_arena_t *arena = &clsdat->arena;
+  // One entry per registered signal, released with the arena
+  if (!clsdat->prof_log) {
+    clsdat->prof_log = svp_arena_alloc(
+        arena, clsdat->num_signals * sizeof(struct svp_prof_rec_t));
+  }
+  struct svp_prof_rec_t *rec = &clsdat->prof_log[clsdat->prof_nlog++];
+  char *name_cpy = svp_arena_alloc(arena, strlen(dat->name) + 1);
+  strcpy(name_cpy, dat->name);
+  rec->name = name_cpy;
+  rec->samples = svp_prof_samples(dat);
+  rec->prof = dat->prof;
+}  // svp_prof_keep
+
+
+void svp_prof_report(struct svp_hdf5_data *clsdat) {
+  double elapsed;
+  double rate = svp_prof_rate(clsdat, &elapsed);
+  int num = clsdat->prof_nlog;
+  struct svp_prof_t sum = {0};
+  unsigned long samples = 0;
+  struct svp_prof_rec_t **recs = malloc((num + 1) * sizeof(*recs));
+  for (int ii = 0; num > ii; ++ii) {
+    recs[ii] = &clsdat->prof_log[ii];
+    svp_prof_add(&sum, &recs[ii]->prof);
+    samples += recs[ii]->samples;
+  }
+  double mbps = (0 < elapsed) ? 1e-6 * sum.bytes / elapsed : 0;
+  // Totals go in the file
+  char str[32];
+  snprintf(str, sizeof(str), "%lu", samples);
+  clsdat->backend->fattr(clsdat, "prof_samples", str);
+  snprintf(str, sizeof(str), "%llu", sum.bytes);
+  clsdat->backend->fattr(clsdat, "prof_bytes", str);
+  snprintf(str, sizeof(str), "%llu", sum.flushes);
+  clsdat->backend->fattr(clsdat, "prof_flushes", str);
+  snprintf(str, sizeof(str), "%.6g", sum.t_write / rate);
+  clsdat->backend->fattr(clsdat, "prof_write_s", str);
+  snprintf(str, sizeof(str), "%.6g", sum.t_extent / rate);
+  clsdat->backend->fattr(clsdat, "prof_extent_s", str);
+  snprintf(str, sizeof(str), "%.6g", sum.t_copy / rate);
+  clsdat->backend->fattr(clsdat, "prof_copy_s", str);
+  snprintf(str, sizeof(str), "%.6g", sum.t_stage / rate);
+  clsdat->backend->fattr(clsdat, "prof_stage_s", str);
+  snprintf(str, sizeof(str), "%.6g", elapsed);
+  clsdat->backend->fattr(clsdat, "prof_elapsed_s", str);
+  snprintf(str, sizeof(str), "%.6g", mbps);
+  clsdat->backend->fattr(clsdat, "prof_mbps", str);
+  // And a summary to the log
+  printf("INFO %s: Write profile of %s, %d signals, %lu samples, %llu bytes "
+         "in %.3f s (%.1f MB/s)\n", __func__, clsdat->name, num, samples,
+         sum.bytes, elapsed, mbps);
+  printf("INFO %s: %llu flushes, write %.4f s, extent %.4f s, copy %.4f s, "
+         "stage %.4f s\n", __func__, sum.flushes, sum.t_write / rate,
+         sum.t_extent / rate, sum.t_copy / rate, sum.t_stage / rate);
+  int topn = (clsdat->prof_topn < num) ? clsdat->prof_topn : num;
+  if (0 < topn) {
+    printf("Top %d signals by bytes written:\n", topn);
+    qsort(recs, num, sizeof(*recs), svp_prof_by_bytes);
+    svp_prof_table(recs, topn, rate);
+    printf("Top %d signals by time in H5Dwrite and H5Dset_extent:\n", topn);
+    qsort(recs, num, sizeof(*recs), svp_prof_by_time);
+    svp_prof_table(recs, topn, rate);
+  }
+  free(recs);
+}  // svp_prof_report
@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Write path profiling. Each data store counts its flushes and bytes, and
+// the time spent copying samples and in the HDF5 calls, which are reported
+// per signal when the file is closed.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SVP__PROF__H__
+#define __SVP__PROF__H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "hdf5.h"
+#include "svp_hdf5_defs.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Timers
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Read the cycle counter.
+ *
+ * @return unsigned long long Time stamp counter on x86, otherwise the
+ * monotonic clock in ns. Converted to seconds with the rate measured since
+ * profiling started.
+ */
+static inline unsigned long long svp_prof_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return 1000000000ULL * ts.tv_sec + ts.tv_nsec;
+#endif
+}  // svp_prof_cycles
+
+
+/**
+ * @brief Start timing a step of the write path.
+ *
+ * @param dat Data store doing the work.
+ * @return unsigned long long Start cycle, 0 if the file is not profiled.
+ */
+static inline unsigned long long svp_prof_start(
+    const struct svp_dstore_t *dat) {
+  return dat->file->profile ? svp_prof_cycles() : 0;
+}  // svp_prof_start
+
+
+/**
+ * @brief Add the cycles since svp_prof_start to a counter.
+ *
+ * @param ctr Counter of the data store.
+ * @param start Value returned by svp_prof_start, nothing is added if 0.
+ */
+static inline void svp_prof_stop(unsigned long long *ctr,
+                                 unsigned long long start) {
+  if (start) {
+    *ctr += svp_prof_cycles() - start;
+  }
+}  // svp_prof_stop
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Start timing the write path of a file.
+ *
+ * @param clsdat File handle.
+ * @param topn Signals listed in each table of the report at close.
+ *
+ * Flushes and bytes are always counted. Times are counted from this call
+ * on, for all data stores of the file.
+ */
+void svp_prof_enable(struct svp_hdf5_data *clsdat, int topn);
+
+
+/**
+ * @brief Number of samples written to a data store.
+ *
+ * @param dat Data store.
+ * @return unsigned long Samples given to the writers, including repeated
+ * values of a value-change store.
+ */
+unsigned long svp_prof_samples(const struct svp_dstore_t *dat);
+
+
+/**
+ * @brief Read a profiling counter of one signal.
+ *
+ * @param dat Data store.
+ * @param counter One of "samples", "bytes", "flushes", "write_s",
+ * "extent_s", "copy_s" or "stage_s".
+ * @return double Value of the counter (times in seconds), -1 if there is no
+ * such counter.
+ *
+ * Caches queued for the background writer are counted once written.
+ */
+double svp_prof_signal(const struct svp_dstore_t *dat, const char *counter);
+
+
+/**
+ * @brief Read a profiling counter summed over the open signals of a file.
+ *
+ * @param clsdat File handle.
+ * @param counter Any counter of svp_prof_signal, or "elapsed_s" (time since
+ * profiling started) or "mbps" (bytes committed per elapsed second, in MB).
+ * @return double Value of the counter, -1 if there is no such counter.
+ */
+double svp_prof_file(const struct svp_hdf5_data *clsdat, const char *counter);
+
+
+/**
+ * @brief Keep the profile of a data store which is being closed.
+ *
+ * @param dat Data store, with all of its data committed.
+ */
+void svp_prof_keep(struct svp_dstore_t *dat);
+
+
+/**
+ * @brief Report the profiles of the closed data stores.
+ *
+ * @param clsdat File handle, with its signals closed and the file open.
+ *
+ * The totals are stored as attributes of the file root, and printed with
+ * the signals which wrote the most bytes and which spent the most time in
+ * HDF5 calls.
+ */
+void svp_prof_report(struct svp_hdf5_data *clsdat);
+
+#endif
@@ -0,0 +1,235 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Rolled over files. The signals of a file are written to a series of
+// segment files, each closed once it reaches its limit, and the file itself
+// becomes an index which links the finished segments in order.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: Segments are created before the current one is closed.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "svp_roll.h"
+#include "svp_dstore.h"
+#include "svp_io.h"
+#include "svp_group.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Build the name of a segment file.
+ *
+ * @param clsdat Rolled over file handle.
+ * @param seg Segment number.
+ * @return char* Segment file name, to be freed by the caller.
+ *
+ * Segments are named after the file, without its extension.
+ */
+static char *svp_roll_name(const struct svp_hdf5_data *clsdat, int seg) {
+  size_t len = strlen(clsdat->name);
+  if ((3 <= len) && (0 == strcmp(clsdat->name + len - 3, ".h5"))) {
+    len -= 3;
+  }
+  char *sname = malloc(len + 32);
+  snprintf(sname, len + 32, "%.*s_seg%04d.h5", (int)len, clsdat->name, seg);
+  return sname;
+}  // svp_roll_name
+
+
+/**
+ * @brief Create a segment file.
+ *
+ * @param clsdat Rolled over file handle.
+ * @param seg Segment number.
+ * @return hid_t Segment file handle, negative if it could not be created.
+ */
+static hid_t svp_roll_create(struct svp_hdf5_data *clsdat, int seg) {
+  char *sname = svp_roll_name(clsdat, seg);
+  hid_t fid = H5Fcreate(sname, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  if (0 > fid) {
+    fprintf(stderr, "ERROR %s: Could not create segment %s\n", __func__,
+            sname);
+    free(sname);
+    return fid;
+  }
+  free(sname);
+  char str[32];
+  snprintf(str, sizeof(str), "%d", seg);
+  svp_add_attr(fid, "segment", str);
+  return fid;
+}  // svp_roll_create
+
+
+/**
+ * @brief Open the index of a rolled over file for an update.
+ *
+ * @param clsdat Rolled over file handle.
+ * @return hid_t Index file handle, negative if it can not be opened now.
+ *
+ * A reader holding the index open locks it, so a failure is only reported
+ * and the update is tried again later.
+ */
+static hid_t svp_roll_index(const struct svp_hdf5_data *clsdat) {
+  hid_t fid;
+  H5E_BEGIN_TRY {
+    fid = H5Fopen(clsdat->name, H5F_ACC_RDWR, H5P_DEFAULT);
+  } H5E_END_TRY;
+  if (0 > fid) {
+    fprintf(stderr, "WARNING %s: Could not open %s, it may be in use\n",
+            __func__, clsdat->name);
+  }
+  return fid;
+}  // svp_roll_index
+
+
+/**
+ * @brief Link the finished segments which the index does not have yet.
+ *
+ * @param clsdat Rolled over file handle.
+ * @param nseg Number of finished segments.
+ *
+ * Segment K is the external link segK (with at least 4 digits) to the root
+ * of its file, by name alone so that HDF5 looks for it next to the index.
+ * The root attribute segments holds the number of links.
+ */
+static void svp_roll_link(struct svp_hdf5_data *clsdat, int nseg) {
+  if (clsdat->roll_linked == nseg) {
+    return;
+  }
+  hid_t fid = svp_roll_index(clsdat);
+  if (0 > fid) {
+    return;
+  }
+  char lname[32];
+  for (int ii = clsdat->roll_linked; nseg > ii; ++ii) {
+    char *sname = svp_roll_name(clsdat, ii);
+    const char *base = strrchr(sname, '/');
+    base = (base) ? base + 1 : sname;
+    snprintf(lname, sizeof(lname), "seg%04d", ii);
+    H5Lcreate_external(base, "/", fid, lname, H5P_DEFAULT, H5P_DEFAULT);
+    free(sname);
+  }
+  if (0 < H5Aexists(fid, "segments")) {
+    H5Adelete(fid, "segments");
+  }
+  char str[32];
+  snprintf(str, sizeof(str), "%d", nseg);
+  svp_add_attr(fid, "segments", str);
+  H5Fclose(fid);
+  clsdat->roll_linked = nseg;
+}  // svp_roll_link
+
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+int svp_roll_start(struct svp_hdf5_data *clsdat) {
+  svp_io_lock(clsdat);
+  hid_t fid = svp_roll_create(clsdat, 0);
+  if (0 > fid) {
+    // Leave the file as it was
+    svp_io_unlock(clsdat);
+    return 1;
+  }
+  H5Fclose(clsdat->fptr);
+  clsdat->fptr = fid;
+  svp_io_unlock(clsdat);
+  clsdat->roll = 1;
+  clsdat->roll_seg = 0;
+  if (0 < clsdat->roll_period) {
+    clsdat->roll_at = clsdat->roll_period;
+  }
+  return 0;
+}  // svp_roll_start
+
+
+int svp_roll_next(struct svp_hdf5_data *clsdat) {
+  // The next segment is created while the current one is still open, if
+  // that fails nothing is finished and the data carries on where it is
+  svp_io_lock(clsdat);
+  hid_t fid = svp_roll_create(clsdat, clsdat->roll_seg + 1);
+  svp_io_unlock(clsdat);
+  // Either way the limits count again from here, rather than trying again
+  // with every sample
+  clsdat->roll_samples = 0;
+  clsdat->roll_bytes = 0;
+  if (0 > fid) {
+    fprintf(stderr, "ERROR %s: Continuing in segment %d of %s\n", __func__,
+            clsdat->roll_seg, clsdat->name);
+    return 1;
+  }
+  // Finish every data store, after which nothing is queued for the writer
+  for (int ii = 0; clsdat->num_signals > ii; ++ii) {
+    svp_dstore_finish(clsdat->dptr[ii]);
+  }
+  svp_io_lock(clsdat);
+  svp_group_close(clsdat);
+  H5Fclose(clsdat->fptr);
+  clsdat->fptr = fid;
+  clsdat->roll_seg += 1;
+  svp_io_unlock(clsdat);
+  // The finished segment can be read through the index from now on
+  svp_roll_link(clsdat, clsdat->roll_seg);
+  // Data stores carry on in the new segment
+  for (int ii = 0; clsdat->num_signals > ii; ++ii) {
+    svp_dstore_reopen(clsdat->dptr[ii]);
+  }
+  return 0;
+}  // svp_roll_next
+
+
+void svp_roll_count(struct svp_dstore_t *dat) {
+  struct svp_hdf5_data *clsdat = dat->file;
+  unsigned long num = dat->wptr - dat->rcount;
+  dat->rcount = dat->wptr;
+  clsdat->roll_samples += num;
+  clsdat->roll_bytes += (dat->pwidth) ? svp_io_extent(dat, num)
+                                      : num * dat->rstride;
+  if ((clsdat->roll_max_samples &&
+       (clsdat->roll_samples >= clsdat->roll_max_samples)) ||
+      (clsdat->roll_max_bytes &&
+       (clsdat->roll_bytes >= clsdat->roll_max_bytes))) {
+    svp_roll_next(clsdat);
+  }
+}  // svp_roll_count
+
+
+void svp_roll_time(struct svp_hdf5_data *clsdat, double simtime) {
+  clsdat->roll_at = clsdat->roll_period *
+                    (floor(simtime / clsdat->roll_period) + 1);
+  svp_roll_next(clsdat);
+}  // svp_roll_time
+
+
+void svp_roll_attr(struct svp_hdf5_data *clsdat, const char *name,
+                   const char *value) {
+  hid_t fid = svp_roll_index(clsdat);
+  if (0 > fid) {
+    fprintf(stderr, "ERROR %s: Attribute %s is not stored\n", __func__,
+            name);
+    return;
+  }
+  svp_add_attr(fid, (char *)name, (char *)value);
+  H5Fclose(fid);
+}  // svp_roll_attr
+
+
+void svp_roll_close(struct svp_hdf5_data *clsdat) {
+  svp_roll_link(clsdat, clsdat->roll_seg + 1);
+  if (clsdat->roll_linked != clsdat->roll_seg + 1) {
+    fprintf(stderr, "ERROR %s: Segments %d to %d are not linked from %s\n",
+            __func__, clsdat->roll_linked, clsdat->roll_seg, clsdat->name);
+  }
+}  // svp_roll_close
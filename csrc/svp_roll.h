@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Rolled over files. The signals of a file are written to a series of
+// segment files, each closed once it reaches its limit, and the file itself
+// becomes an index which links the finished segments in order.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: A failed rollover carries on in the current segment.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SVP__ROLL__H__
+#define __SVP__ROLL__H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hdf5.h"
+#include "svp_hdf5_defs.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Turn a file into the index of its segments, and create the first.
+ *
+ * @param clsdat File handle, of the HDF5 backend, with no signals yet. Its
+ * rollover limits are already set.
+ * @return int Returns 0 if successful.
+ *
+ * Segment K of file.h5 is file_segK.h5 (K with at least 4 digits), next to
+ * it. The file is closed, keeping the attributes it has, and only opened
+ * again to be updated.
+ */
+int svp_roll_start(struct svp_hdf5_data *clsdat);
+
+
+/**
+ * @brief Close the current segment and continue in a new one.
+ *
+ * @param clsdat Rolled over file handle.
+ * @return int Returns 0 if successful.
+ *
+ * Every data store with storage is written out and finished, exactly as if
+ * the file were closed, then created again in the new segment with the same
+ * settings and attributes. The finished segment is linked from the index.
+ * The new segment is created first, if that fails the data stores carry on
+ * in the current segment, and the limits count again from this call.
+ */
+int svp_roll_next(struct svp_hdf5_data *clsdat);
+
+
+/**
+ * @brief Count the records a data store has written, and roll over if the
+ * segment has reached its sample or byte limit.
+ *
+ * @param dat Data store of a rolled over file, whose cache was just full.
+ */
+void svp_roll_count(struct svp_dstore_t *dat);
+
+
+/**
+ * @brief Roll over if a timestamp has reached the end of the segment.
+ *
+ * @param clsdat Rolled over file handle, with a time limit.
+ * @param simtime Timestamp of a sample about to be written (ns).
+ *
+ * The next segment ends at the first multiple of the period after simtime,
+ * so periods without any sample do not make empty segments.
+ */
+void svp_roll_time(struct svp_hdf5_data *clsdat, double simtime);
+
+
+/**
+ * @brief Add a string attribute to the index of a rolled over file.
+ *
+ * @param clsdat Rolled over file handle.
+ * @param name Attribute name.
+ * @param value Attribute value.
+ */
+void svp_roll_attr(struct svp_hdf5_data *clsdat, const char *name,
+                   const char *value);
+
+
+/**
+ * @brief Link the last segment, once it is closed.
+ *
+ * @param clsdat Rolled over file handle, with its current segment closed.
+ */
+void svp_roll_close(struct svp_hdf5_data *clsdat);
+
+#endif
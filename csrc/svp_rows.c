@@ -0,0 +1,218 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Row groups, which store the signals of one clock domain as the fields of a
+// single compound dataset, written one row per tick.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "svp_rows.h"
+#include "svp_dstore.h"
+#include "svp_file.h"
+#include "svp_arena.h"
+#include "svp_bits.h"
+
+/// Initial capacity of the field list of a row group (grows as needed)
+#define INIT_FIELDS 16
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Build the compound datatype of the records.
+ *
+ * @param rows Row group.
+ * @return hid_t Compound datatype, one member per field.
+ */
+static hid_t svp_rows_type(const struct svp_rows_t *rows) {
+  hid_t ctype = H5Tcreate(H5T_COMPOUND, rows->rsize);
+  for (int ii = 0; rows->nfield > ii; ++ii) {
+    const struct svp_field_t *fld = &rows->fields[ii];
+    if (1 == fld->size) {
+      H5Tinsert(ctype, fld->name, fld->offset, fld->h5type);
+    } else {
+      hsize_t dims[1] = {fld->size};
+      hid_t atype = H5Tarray_create2(fld->h5type, 1, dims);
+      H5Tinsert(ctype, fld->name, fld->offset, atype);
+      H5Tclose(atype);
+    }
+  }
+  return ctype;
+}  // svp_rows_type
+
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+struct svp_rows_t *svp_rows_create(struct svp_hdf5_data *clsdat,
+                                   const char *name, double period,
+                                   double start) {
+  struct svp_arena_t *arena = &clsdat->arena;
+  struct svp_rows_t *rows = svp_arena_alloc(arena, sizeof(struct svp_rows_t));
+  memset(rows, 0, sizeof(struct svp_rows_t));
+  char *name_cpy = svp_arena_alloc(arena, strlen(name) + 1);
+  strcpy(name_cpy, name);
+  rows->file = clsdat;
+  rows->name = name_cpy;
+  rows->period = period;
+  rows->start = start;
+  rows->fcap = INIT_FIELDS;
+  rows->fields = svp_arena_alloc(arena,
+                                 rows->fcap * sizeof(struct svp_field_t));
+  return rows;
+}  // svp_rows_create
+
+
+int svp_rows_add_field(struct svp_rows_t *rows, const char *fname,
+                       const char *dtype, int width, int size) {
+  if (rows->dat) {
+    fprintf(stderr, "ERROR %s: %s is already registered\n", __func__,
+            rows->name);
+    return 1;
+  }
+  if (0 <= svp_rows_offset(rows, fname)) {
+    fprintf(stderr, "ERROR %s: Field already exists: %s.%s\n", __func__,
+            rows->name, fname);
+    return 1;
+  }
+  hid_t h5type = svp_dtype_lookup(dtype);
+  if (0 > h5type) {
+    fprintf(stderr, "ERROR %s: Unknown dtype: %s\n", __func__, dtype);
+    return 1;
+  }
+  int esize = H5Tget_size(h5type);
+  if (0 == width) {
+    width = 8 * esize;
+  }
+  if ((1 > width) || (8 * esize < width) || (1 > size)) {
+    fprintf(stderr, "ERROR %s: Invalid field %s.%s: %d x %d bits\n", __func__,
+            rows->name, fname, size, width);
+    return 1;
+  }
+  // Grow the field list geometrically when it is full
+  struct svp_arena_t *arena = &rows->file->arena;
+  if (rows->fcap == rows->nfield) {
+    size_t nbytes = rows->fcap * sizeof(struct svp_field_t);
+    rows->fields = svp_arena_realloc(arena, rows->fields, nbytes, 2 * nbytes);
+    rows->fcap *= 2;
+  }
+  struct svp_field_t *fld = &rows->fields[rows->nfield];
+  char *fname_cpy = svp_arena_alloc(arena, strlen(fname) + 1);
+  strcpy(fname_cpy, fname);
+  fld->name = fname_cpy;
+  fld->h5type = h5type;
+  fld->esize = esize;
+  fld->size = size;
+  fld->width = width;
+  fld->is_signed = (H5T_INTEGER == H5Tget_class(h5type)) &&
+                   (H5T_SGN_2 == H5Tget_sign(h5type));
+  // Each field is aligned to its datatype within the record
+  fld->offset = esize * ((rows->rsize + esize - 1) / esize);
+  rows->rsize = fld->offset + (size_t)esize * size;
+  rows->nbits += (unsigned long)width * size;
+  rows->nfield += 1;
+  return 0;
+}  // svp_rows_add_field
+
+
+int svp_rows_register(struct svp_rows_t *rows, const char *filt) {
+  if (rows->dat) {
+    fprintf(stderr, "ERROR %s: %s is already registered\n", __func__,
+            rows->name);
+    return 1;
+  }
+  if (0 == rows->nfield) {
+    fprintf(stderr, "ERROR %s: %s has no fields\n", __func__, rows->name);
+    return 1;
+  }
+  // Pad the record so consecutive records stay aligned
+  size_t align = 1;
+  for (int ii = 0; rows->nfield > ii; ++ii) {
+    if ((size_t)rows->fields[ii].esize > align) {
+      align = rows->fields[ii].esize;
+    }
+  }
+  rows->rsize = align * ((rows->rsize + align - 1) / align);
+  // The first field is the most significant in the packed row
+  unsigned long bit = rows->nbits;
+  for (int ii = 0; rows->nfield > ii; ++ii) {
+    struct svp_field_t *fld = &rows->fields[ii];
+    bit -= (unsigned long)fld->width * fld->size;
+    fld->bit = bit;
+  }
+  // One data store holds all of the fields
+  struct svp_dstore_opt_t opt = {};
+  opt.filt = filt;
+  hid_t ctype = svp_rows_type(rows);
+  rows->dat = svp_dstore_create_opt(rows->file, rows->name,
+                                    SVP_STORE_SYNC_DATA, 0, NULL, ctype, &opt);
+  if (!rows->dat) {
+    H5Tclose(ctype);
+    return 1;
+  }
+  char str[32];
+  snprintf(str, sizeof(str), "%.17g", rows->period);
+  svp_dstore_svattr(rows->dat, "period", str);
+  snprintf(str, sizeof(str), "%.17g", rows->start);
+  svp_dstore_svattr(rows->dat, "start", str);
+  rows->row = svp_arena_alloc(&rows->file->arena, rows->rsize);
+  memset(rows->row, 0, rows->rsize);
+  return svp_hdf5_addsig(rows->file, rows->dat);
+}  // svp_rows_register
+
+
+long svp_rows_offset(const struct svp_rows_t *rows, const char *fname) {
+  for (int ii = 0; rows->nfield > ii; ++ii) {
+    if (0 == strcmp(rows->fields[ii].name, fname)) {
+      return rows->fields[ii].offset;
+    }
+  }
+  return -1;
+}  // svp_rows_offset
+
+
+int svp_rows_write(struct svp_rows_t *rows, const void *rec) {
+  if (!rows->dat) {
+    fprintf(stderr, "ERROR %s: %s is not registered\n", __func__, rows->name);
+    return 1;
+  }
+  return svp_dstore_write_data(rows->dat, 0, rec);
+}  // svp_rows_write
+
+
+int svp_rows_write_packed(struct svp_rows_t *rows, const svBitVecVal *vec) {
+  if (!rows->dat) {
+    fprintf(stderr, "ERROR %s: %s is not registered\n", __func__, rows->name);
+    return 1;
+  }
+  // Unpack every field into the staging record
+  for (int ii = 0; rows->nfield > ii; ++ii) {
+    const struct svp_field_t *fld = &rows->fields[ii];
+    svp_bits_extract((char *)rows->row + fld->offset, fld->esize, vec,
+                     fld->bit, fld->width, fld->size, fld->is_signed);
+  }
+  return svp_dstore_write_data(rows->dat, 0, rows->row);
+}  // svp_rows_write_packed
+
+
+int svp_rows_write_bitvec(struct svp_rows_t *rows,
+                          const svOpenArrayHandle dbuf, int nbits) {
+  if ((unsigned long)nbits != rows->nbits) {
+    fprintf(stderr, "ERROR %s: %d-bit row does not match %s (%lu bits)\n",
+            __func__, nbits, rows->name, rows->nbits);
+    return 1;
+  }
+  return svp_rows_write_packed(rows, svGetArrayPtr(dbuf));
+}  // svp_rows_write_bitvec
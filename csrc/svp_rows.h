@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Row groups, which store the signals of one clock domain as the fields of a
+// single compound dataset, written one row per tick.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SVP__ROWS__H__
+#define __SVP__ROWS__H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hdf5.h"
+#include "svdpi.h"
+#include "svp_hdf5_defs.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Start the description of a row group.
+ *
+ * @param clsdat File handle.
+ * @param name Fully-qualified name of the row group dataset.
+ * @param period Clock period, stored as the period attribute.
+ * @param start Time of the first row, stored as the start attribute.
+ * @return struct svp_rows_t* Row group, to which fields are added.
+ *
+ * Row k of the dataset is the sample taken at start + k * period. The row
+ * group is released with the file.
+ */
+struct svp_rows_t *svp_rows_create(struct svp_hdf5_data *clsdat,
+                                   const char *name, double period,
+                                   double start);
+
+
+/**
+ * @brief Add a field to a row group.
+ *
+ * @param rows Row group, not yet registered.
+ * @param fname Field name, unique within the row group.
+ * @param dtype Stored datatype (see svp_dtype_lookup).
+ * @param width Bits per lane in the packed row, 0 for the full datatype.
+ * @param size Number of lanes (1 for a scalar).
+ * @return int Returns 0 if successful.
+ *
+ * Lanes are sign-extended from width bits if the datatype is signed. Fields
+ * are laid out in the record in the order they are added, each aligned to
+ * its datatype.
+ */
+int svp_rows_add_field(struct svp_rows_t *rows, const char *fname,
+                       const char *dtype, int width, int size);
+
+
+/**
+ * @brief Create the dataset of a row group and register it with the file.
+ *
+ * @param rows Row group, with all of its fields.
+ * @param filt Compression filter spec, NULL or "" for the file default.
+ * @return int Returns 0 if successful.
+ *
+ * The rows are stored by a single synchronous data store (with rank 0
+ * records of the row compound), so they share one cache and one write per
+ * chunk, and follow the file settings (lazy creation, cache budget,
+ * background writer) like any other signal.
+ */
+int svp_rows_register(struct svp_rows_t *rows, const char *filt);
+
+
+/**
+ * @brief Byte offset of a field in the record.
+ *
+ * @param rows Row group.
+ * @param fname Field name.
+ * @return long Offset for building records in C, -1 if there is no such
+ * field.
+ */
+long svp_rows_offset(const struct svp_rows_t *rows, const char *fname);
+
+
+/**
+ * @brief Write one row, already laid out as a record.
+ *
+ * @param rows Registered row group.
+ * @param rec Record of rsize bytes, fields at their svp_rows_offset.
+ * @return int Returns 0 if successful.
+ */
+int svp_rows_write(struct svp_rows_t *rows, const void *rec);
+
+
+/**
+ * @brief Write one row given as a packed vector.
+ *
+ * @param rows Registered row group.
+ * @param vec Packed row of nbits bits. The first field added is the most
+ * significant, so this is the layout of an SV packed struct whose members
+ * are the fields in the same order.
+ * @return int Returns 0 if successful.
+ */
+int svp_rows_write_packed(struct svp_rows_t *rows, const svBitVecVal *vec);
+
+
+/**
+ * @brief Explicit call for DPI interface.
+ *
+ * @param rows Registered row group.
+ * @param dbuf Alias of svBitVecVal*, the packed row.
+ * @param nbits Width of the packed row, must match the fields.
+ * @return int Returns 0 if successful.
+ */
+int svp_rows_write_bitvec(struct svp_rows_t *rows,
+                          const svOpenArrayHandle dbuf, int nbits);
+
+#endif
@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Sharded files. The data stores of a file are spread over several shard
+// files, each with its own writer thread, and the file itself becomes a
+// master which links the signal hierarchy to the shards.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: All writers are stopped before the shards are closed.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "svp_shard.h"
+#include "svp_file.h"
+#include "svp_io.h"
+#include "svp_zpool.h"
+#include "svp_group.h"
+#include "svp_arena.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Find the shard which holds a data store.
+ *
+ * @param clsdat Sharded file handle.
+ * @param dat Data store of the file.
+ * @return int Index of the shard, -1 if the data store is left out of the
+ * file (an idle signal when lazy is SVP_LAZY_SKIP).
+ */
+static int svp_shard_owner(const struct svp_hdf5_data *clsdat,
+                           const struct svp_dstore_t *dat) {
+  if (!dat->dcache && (SVP_LAZY_SKIP == dat->file->lazy)) {
+    return -1;
+  }
+  for (int ii = 0; clsdat->nshards > ii; ++ii) {
+    if (clsdat->shards[ii] == dat->file) {
+      return ii;
+    }
+  }
+  return -1;
+}  // svp_shard_owner
+
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+int svp_shard_start(struct svp_hdf5_data *clsdat, int nshards) {
+  // The data is written by the shards, which take over the worker pool
+  int nthreads = clsdat->zp_nthreads;
+  svp_io_stop(clsdat);
+  svp_zpool_stop(clsdat);
+#ifndef H5_HAVE_THREADSAFE
+  // The HDF5 library can only be used by one thread at a time
+  pthread_mutex_init(&clsdat->shard_mtx, NULL);
+  clsdat->h5_lock = &clsdat->shard_mtx;
+#endif
+  // Shards are named after the file, without its extension
+  size_t len = strlen(clsdat->name);
+  if ((3 <= len) && (0 == strcmp(clsdat->name + len - 3, ".h5"))) {
+    len -= 3;
+  }
+  char *sname = malloc(len + 32);
+  clsdat->shards = svp_arena_alloc(&clsdat->arena,
+                                   nshards * sizeof(struct svp_hdf5_data *));
+  for (int ii = 0; nshards > ii; ++ii) {
+    snprintf(sname, len + 32, "%.*s_shard%d.h5", (int)len, clsdat->name, ii);
+    struct svp_hdf5_data *shard = svp_hdf5_fopen_backend(sname, "hdf5");
+    if (!shard) {
+      fprintf(stderr, "ERROR %s: Could not create shard %s\n", __func__,
+              sname);
+      break;
+    }
+    clsdat->shards[clsdat->nshards++] = shard;
+#ifndef H5_HAVE_THREADSAFE
+    shard->h5_lock = &clsdat->shard_mtx;
+#endif
+    if (svp_io_start(shard) ||
+        (nthreads && svp_zpool_start(shard, nthreads))) {
+      break;
+    }
+  }
+  free(sname);
+  if (nshards == clsdat->nshards) {
+    return 0;
+  }
+  // Leave the file unsharded
+  // Every writer is drained and stopped before any shard is closed, the
+  // closes run without the shared HDF5 lock
+  for (int ii = 0; clsdat->nshards > ii; ++ii) {
+    svp_io_stop(clsdat->shards[ii]);
+    svp_zpool_stop(clsdat->shards[ii]);
+  }
+  for (int ii = 0; clsdat->nshards > ii; ++ii) {
+    svp_hdf5_fclose(clsdat->shards[ii]);
+  }
+  clsdat->nshards = 0;
+  return 1;
+}  // svp_shard_start
+
+
+struct svp_hdf5_data *svp_shard_pick(struct svp_hdf5_data *clsdat) {
+  struct svp_hdf5_data *shard =
+      clsdat->shards[clsdat->shard_next % clsdat->nshards];
+  clsdat->shard_next += 1;
+  // Settings are read when data stores are created
+  shard->filt = clsdat->filt;
+  shard->chunk_bytes = clsdat->chunk_bytes;
+  shard->lazy = clsdat->lazy;
+  shard->time_res = clsdat->time_res;
+  shard->layout = clsdat->layout;
+  shard->arena.hugetlb = clsdat->arena.hugetlb;
+  // The shards share the memory budget
+  shard->cache_budget = clsdat->cache_budget / clsdat->nshards;
+  if (clsdat->cache_budget && !shard->cache_budget) {
+    shard->cache_budget = 1;
+  }
+  // And the profiling clock
+  if (clsdat->profile) {
+    shard->profile = 1;
+    shard->prof_topn = clsdat->prof_topn;
+    shard->prof_c0 = clsdat->prof_c0;
+    shard->prof_t0 = clsdat->prof_t0;
+  }
+  return shard;
+}  // svp_shard_pick
+
+
+void svp_shard_close(struct svp_hdf5_data *clsdat) {
+  struct svp_arena_t *arena = &clsdat->arena;
+  int num = clsdat->num_signals;
+  // The names outlive the data stores, which are closed by their shards
+  const char **names = svp_arena_alloc(arena, num * sizeof(char *));
+  int *owner = svp_arena_alloc(arena, num * sizeof(int));
+  size_t max_len = 0;
+  for (int ii = 0; num > ii; ++ii) {
+    struct svp_dstore_t *dat = clsdat->dptr[ii];
+    char *name_cpy = svp_arena_alloc(arena, strlen(dat->name) + 1);
+    strcpy(name_cpy, dat->name);
+    names[ii] = name_cpy;
+    owner[ii] = svp_shard_owner(clsdat, dat);
+    if (strlen(dat->name) > max_len) {
+      max_len = strlen(dat->name);
+    }
+  }
+  // Shards are linked by their name alone, HDF5 looks for them next to the
+  // file which holds the links
+  const char **bases = svp_arena_alloc(arena,
+                                       clsdat->nshards * sizeof(char *));
+  for (int ii = 0; clsdat->nshards > ii; ++ii) {
+    const char *sname = clsdat->shards[ii]->name;
+    const char *base = strrchr(sname, '/');
+    base = (base) ? base + 1 : sname;
+    char *base_cpy = svp_arena_alloc(arena, strlen(base) + 1);
+    strcpy(base_cpy, base);
+    bases[ii] = base_cpy;
+  }
+  // Every writer is drained and stopped before any shard is closed, the
+  // closes run without the shared HDF5 lock
+  for (int ii = 0; clsdat->nshards > ii; ++ii) {
+    svp_io_stop(clsdat->shards[ii]);
+    svp_zpool_stop(clsdat->shards[ii]);
+  }
+  for (int ii = 0; clsdat->nshards > ii; ++ii) {
+    svp_hdf5_fclose(clsdat->shards[ii]);
+  }
+  // Link each signal where it would be in an unsharded file, the path in
+  // its shard follows the hierarchy of its name
+  char *path = malloc(max_len + 2);
+  for (int ii = 0; num > ii; ++ii) {
+    if (0 > owner[ii]) {
+      continue;
+    }
+    const char *sig_name;
+    hid_t gid = svp_group_open(clsdat, names[ii], &sig_name);
+    path[0] = '/';
+    strcpy(path + 1, names[ii]);
+    for (char *pos = path; *pos; ++pos) {
+      if ('.' == *pos) {
+        *pos = '/';
+      }
+    }
+    H5Lcreate_external(bases[owner[ii]], path, gid, sig_name, H5P_DEFAULT,
+                       H5P_DEFAULT);
+  }
+  free(path);
+  char str[32];
+  snprintf(str, sizeof(str), "%d", clsdat->nshards);
+  svp_add_attr(clsdat->fptr, "shard_count", str);
+#ifndef H5_HAVE_THREADSAFE
+  clsdat->h5_lock = NULL;
+  pthread_mutex_destroy(&clsdat->shard_mtx);
+#endif
+}  // svp_shard_close
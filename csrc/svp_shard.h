@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Sharded files. The data stores of a file are spread over several shard
+// files, each with its own writer thread, and the file itself becomes a
+// master which links the signal hierarchy to the shards.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SVP__SHARD__H__
+#define __SVP__SHARD__H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hdf5.h"
+#include "svp_hdf5_defs.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Create the shard files of a file.
+ *
+ * @param clsdat File handle, of the HDF5 backend, with no signals yet.
+ * @param nshards Number of shard files.
+ * @return int Returns 0 if successful.
+ *
+ * Shard K of file.h5 is file_shardK.h5, next to it. Each shard starts its
+ * background writer, and a compression worker pool if the file has one.
+ */
+int svp_shard_start(struct svp_hdf5_data *clsdat, int nshards);
+
+
+/**
+ * @brief Choose the shard of a new data store.
+ *
+ * @param clsdat Sharded file handle.
+ * @return struct svp_hdf5_data* Shard file, given the current settings of
+ * clsdat.
+ *
+ * Shards are used in turn, so they hold the same number of data stores.
+ */
+struct svp_hdf5_data *svp_shard_pick(struct svp_hdf5_data *clsdat);
+
+
+/**
+ * @brief Close the shards, and link their signals into the file.
+ *
+ * @param clsdat Sharded file handle, its signals are closed by the shards.
+ *
+ * Each signal becomes an external link, in the same group it would have
+ * been in an unsharded file, so readers open the file as usual.
+ */
+void svp_shard_close(struct svp_hdf5_data *clsdat);
+
+#endif
@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Pool of worker threads which compress full chunks ahead of the background
+// writer, so that the HDF5 filter pipeline is not run serially.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: Chunk length taken from the data store.
+// 16-Oct-26: Staging areas are allocated from the file arena.
+// 16-Oct-26: Bit-packed data stores are left to the writer.
+// 16-Oct-26: Data stores with a time column are left to the writer.
+// 16-Oct-26: Records split across chunks are left to the writer.
+// 16-Oct-26: Drain the writer before stopping, restart to resize the pool.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <zlib.h>
+
+#include "svp_zpool.h"
+#include "svp_io.h"
+#include "svp_arena.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Byte-shuffle a chunk, identical to the HDF5 shuffle filter.
+ *
+ * @param dst Destination buffer.
+ * @param src Source buffer.
+ * @param nbytes Number of bytes in the chunk.
+ * @param esize Size of each element (the full dataset record).
+ *
+ * Byte j of element i is moved to position j * nelem + i. Trailing bytes
+ * which do not make up a full element are copied unchanged.
+ */
+static void svp_zpool_shuffle(unsigned char *dst, const unsigned char *src,
+                              size_t nbytes, size_t esize) {
+  size_t nelem = nbytes / esize;
+  for (size_t jj = 0; esize > jj; ++jj) {
+    unsigned char *dptr = dst + jj * nelem;
+    const unsigned char *sptr = src + jj;
+    for (size_t ii = 0; nelem > ii; ++ii) {
+      dptr[ii] = *sptr;
+      sptr += esize;
+    }
+  }
+  memcpy(dst + nelem * esize, src + nelem * esize, nbytes - nelem * esize);
+}  // svp_zpool_shuffle
+
+
+/**
+ * @brief Run the dataset filters on one full cache.
+ *
+ * @param job Write job describing the cache.
+ */
+static void svp_zpool_compress(struct svp_io_job_t *job) {
+  struct svp_dstore_t *dat = job->dat;
+  size_t nbytes = dat->clen * dat->rstride;
+  unsigned char *buf = svp_io_layout(dat, job->tcache, job->dcache);
+  // Shuffling is skipped by HDF5 for single byte elements
+  if (dat->filt.shuffle && (1 < dat->rstride)) {
+    if (!dat->scache) {
+      dat->scache = svp_arena_alloc(&dat->file->arena, nbytes);
+    }
+    svp_zpool_shuffle(dat->scache, buf, nbytes, dat->rstride);
+    buf = dat->scache;
+  }
+  job->zbuf = buf;
+  job->zsize = nbytes;
+  if (dat->filt.deflate) {
+    uLongf zsize = compressBound(nbytes);
+    if (!dat->zcache) {
+      dat->zcache = svp_arena_alloc(&dat->file->arena, zsize);
+    }
+    compress2(dat->zcache, &zsize, buf, nbytes, dat->filt.deflate);
+    job->zbuf = dat->zcache;
+    job->zsize = zsize;
+  }
+}  // svp_zpool_compress
+
+
+/**
+ * @brief Main loop of a compression worker.
+ *
+ * @param arg File handle (struct svp_hdf5_data *).
+ * @return void* Always NULL.
+ */
+static void *svp_zpool_main(void *arg) {
+  struct svp_hdf5_data *clsdat = (struct svp_hdf5_data *)arg;
+  struct svp_io_job_t *job;
+  pthread_mutex_lock(&clsdat->zp_mtx);
+  while (1) {
+    // Sleep until there is something to do
+    while (!clsdat->zp_head && !clsdat->zp_stop) {
+      pthread_cond_wait(&clsdat->zp_wake, &clsdat->zp_mtx);
+    }
+    if (!clsdat->zp_head) {
+      // Stop was requested and the queue is drained
+      break;
+    }
+    // Pop the oldest job
+    job = clsdat->zp_head;
+    clsdat->zp_head = job->znext;
+    if (!clsdat->zp_head) {
+      clsdat->zp_tail = NULL;
+    }
+    pthread_mutex_unlock(&clsdat->zp_mtx);
+    svp_zpool_compress(job);
+    // Mark the chunk ready for the writer
+    pthread_mutex_lock(&clsdat->zp_mtx);
+    job->zstate = 2;
+    pthread_cond_broadcast(&clsdat->zp_done);
+  }
+  pthread_mutex_unlock(&clsdat->zp_mtx);
+  return NULL;
+}  // svp_zpool_main
+
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+int svp_zpool_start(struct svp_hdf5_data *clsdat, int nthreads) {
+  if (nthreads == clsdat->zp_nthreads) {
+    return 0;
+  }
+  // A pool of another size is replaced
+  svp_zpool_stop(clsdat);
+  clsdat->zp_head = NULL;
+  clsdat->zp_tail = NULL;
+  clsdat->zp_stop = 0;
+  pthread_mutex_init(&clsdat->zp_mtx, NULL);
+  pthread_cond_init(&clsdat->zp_wake, NULL);
+  pthread_cond_init(&clsdat->zp_done, NULL);
+  clsdat->zp_threads = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+  for (int ii = 0; nthreads > ii; ++ii) {
+    if (pthread_create(&clsdat->zp_threads[ii], NULL, svp_zpool_main,
+                       clsdat)) {
+      fprintf(stderr, "ERROR %s: Could only start %d of %d workers for %s\n",
+              __func__, ii, nthreads, clsdat->name);
+      nthreads = ii;
+      break;
+    }
+  }
+  clsdat->zp_nthreads = nthreads;
+  if (!nthreads) {
+    free(clsdat->zp_threads);
+    return 1;
+  }
+  return 0;
+}  // svp_zpool_start
+
+
+void svp_zpool_stop(struct svp_hdf5_data *clsdat) {
+  if (!clsdat->zp_nthreads) {
+    return;
+  }
+  // The writer waits on the pool for the jobs it took, let it write them
+  // all before the pool goes away
+  for (int ii = 0; clsdat->num_signals > ii; ++ii) {
+    svp_io_wait(clsdat->dptr[ii]);
+  }
+  // Request the stop, the workers exit once the queue is empty
+  pthread_mutex_lock(&clsdat->zp_mtx);
+  clsdat->zp_stop = 1;
+  pthread_cond_broadcast(&clsdat->zp_wake);
+  pthread_mutex_unlock(&clsdat->zp_mtx);
+  for (int ii = 0; clsdat->zp_nthreads > ii; ++ii) {
+    pthread_join(clsdat->zp_threads[ii], NULL);
+  }
+  free(clsdat->zp_threads);
+  // Tear down synchronization objects
+  pthread_cond_destroy(&clsdat->zp_done);
+  pthread_cond_destroy(&clsdat->zp_wake);
+  pthread_mutex_destroy(&clsdat->zp_mtx);
+  clsdat->zp_nthreads = 0;
+}  // svp_zpool_stop
+
+
+int svp_zpool_eligible(const struct svp_io_job_t *job) {
+#ifdef SVP_DIRECT_CHUNK
+  const struct svp_dstore_t *dat = job->dat;
+  return dat->file->zp_nthreads && dat->nfilt && !dat->filt.nbit &&
+         !dat->filt.scaleoffset && !dat->pwidth && !dat->tset && !dat->cdims &&
+         (dat->clen == job->cptr) && (0 == job->wptr % dat->clen);
+#else
+  return 0;
+#endif
+}  // svp_zpool_eligible
+
+
+void svp_zpool_submit(struct svp_io_job_t *job) {
+  struct svp_hdf5_data *clsdat = job->dat->file;
+  pthread_mutex_lock(&clsdat->zp_mtx);
+  job->znext = NULL;
+  if (clsdat->zp_tail) {
+    clsdat->zp_tail->znext = job;
+  } else {
+    clsdat->zp_head = job;
+  }
+  clsdat->zp_tail = job;
+  pthread_cond_signal(&clsdat->zp_wake);
+  pthread_mutex_unlock(&clsdat->zp_mtx);
+}  // svp_zpool_submit
+
+
+void svp_zpool_wait(struct svp_io_job_t *job) {
+  struct svp_hdf5_data *clsdat = job->dat->file;
+  pthread_mutex_lock(&clsdat->zp_mtx);
+  while (2 != job->zstate) {
+    pthread_cond_wait(&clsdat->zp_done, &clsdat->zp_mtx);
+  }
+  pthread_mutex_unlock(&clsdat->zp_mtx);
+}  // svp_zpool_wait
+
+
+void svp_zpool_free(struct svp_dstore_t *dat) {
+  size_t nbytes = dat->clen * dat->rstride;
+  svp_arena_free(&dat->file->arena, dat->scache, nbytes);
+  svp_arena_free(&dat->file->arena, dat->zcache, compressBound(nbytes));
+  dat->scache = NULL;
+  dat->zcache = NULL;
+}  // svp_zpool_free
@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Pool of worker threads which compress full chunks ahead of the background
+// writer, so that the HDF5 filter pipeline is not run serially.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: Added release of the staging areas.
+// 16-Oct-26: A running pool is resized by starting it again.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SVP__ZPOOL__H__
+#define __SVP__ZPOOL__H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "hdf5.h"
+#include "svp_hdf5_defs.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// API
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Start the compression workers of a file.
+ *
+ * @param clsdat File handle.
+ * @param nthreads Number of worker threads.
+ * @return int Returns 0 if successful.
+ *
+ * A running pool with another number of workers is stopped first.
+ */
+int svp_zpool_start(struct svp_hdf5_data *clsdat, int nthreads);
+
+
+/**
+ * @brief Compress all queued chunks, then stop the workers.
+ *
+ * @param clsdat File handle.
+ *
+ * Chunks compressed by the pool are written by the background writer before
+ * this returns, so the writer can keep running without the pool.
+ */
+void svp_zpool_stop(struct svp_hdf5_data *clsdat);
+
+
+/**
+ * @brief Check whether a queued cache can be compressed by the pool.
+ *
+ * @param job Write job describing the cache.
+ * @return int Non-zero if the pool can produce the chunk.
+ *
+ * Only full, chunk-aligned caches of datasets whose filters are limited to
+ * shuffle and deflate are handled, since those filters are reproduced here
+ * exactly as HDF5 applies them. Everything else, including bit-packed data
+ * stores and those with a separate time column, goes through the writer.
+ */
+int svp_zpool_eligible(const struct svp_io_job_t *job);
+
+
+/**
+ * @brief Queue a write job for compression.
+ *
+ * @param job Write job, which must already be in the writer queue.
+ */
+void svp_zpool_submit(struct svp_io_job_t *job);
+
+
+/**
+ * @brief Block until a queued job has been compressed.
+ *
+ * @param job Write job previously passed to svp_zpool_submit().
+ */
+void svp_zpool_wait(struct svp_io_job_t *job);
+
+
+/**
+ * @brief Release the compression staging areas of a data store.
+ *
+ * @param dat Data store, with no job pending in the pool.
+ */
+void svp_zpool_free(struct svp_dstore_t *dat);
+
+#endif
@@ -12,12 +12,20 @@
 # Version History
 # ---------------
 # 19-Nov-22: Initial version
+# 16-Oct-26: Handle plain (non-compound) synchronous datasets.
+# 16-Oct-26: Decode bit-packed synchronous datasets.
+# 16-Oct-26: Value-change datasets, with expansion to one sample per record.
+# 16-Oct-26: Row groups, each field presented as a signal.
+# 16-Oct-26: Decode integer tick timestamps.
+# 16-Oct-26: Signals stored as separate time and data datasets.
+# 16-Oct-26: Join the segments of a rolled over file.
 #
 ###############################################################################
 
 import os
 import psutil
 import h5py
+import numpy as np
 from dataclasses import dataclass
 
 ###########
@@ -48,28 +56,138 @@ class _DumpInfo:
     dtype : None
 
 
+def _unpackbits(dobj):
+    """Decode a bit-packed dataset into an array of records.
+
+    Lanes of packed_width bits are stored back to back, least significant
+    bit first, and records are packed_dims lanes each.
+    """
+    attr = lambda key: dobj.attrs[key].decode('ascii')
+    width = int(attr('packed_width'))
+    is_signed = int(attr('packed_signed'))
+    dims = tuple(int(x) for x in attr('packed_dims').split(','))
+    count = int(attr('packed_count'))
+    nlanes = count * int(np.prod(dims))
+    # One row of width bits per lane, folded back into bytes
+    bits = np.unpackbits(dobj[()], bitorder='little')[:nlanes * width]
+    vals = np.packbits(bits.reshape(nlanes, width), axis=1,
+                       bitorder='little')[:, 0]
+    if is_signed:
+        vals = vals.astype(np.int16)
+        vals[vals >= (1 << (width - 1))] -= (1 << width)
+        vals = vals.astype(np.int8)
+    return vals.reshape((count,) + dims)
+
+
+def _expand(dobj):
+    """Expand a value-change dataset into one record per sample.
+
+    Each change holds from its own index up to the next change, and the last
+    one up to change_count samples.
+    """
+    index = dobj['index']
+    data = dobj['data']
+    count = int(dobj.attrs['change_count'].decode('ascii'))
+    reps = np.diff(np.append(index, count))
+    return np.repeat(data, reps, axis=0)
+
+
+
+def _ticks(dobj):
+    """Decode an integer time column into absolute ticks.
+
+    Each record holds the difference from the previous tick, except the first
+    record of every chunk of time_chunk records, which is absolute.
+    """
+    delta = np.asarray(dobj['time'][()], dtype=np.int64)
+    clen = int(dobj.attrs['time_chunk'].decode('ascii'))
+    num = delta.shape[0]
+    pad = np.zeros(-num % clen, dtype=np.int64)
+    chunks = np.concatenate((delta, pad)).reshape(-1, clen)
+    return np.cumsum(chunks, axis=1).ravel()[:num]
+
+def _parserows(dobjs):
+    """Split a row group into one synchronous signal per field.
+
+    Row k was sampled at start + k * period, time() returns those times. The
+    rows of a rolled over file continue from one segment to the next.
+    """
+    obj = _DumpGroup()
+    info = _DumpGroup()
+    period = float(dobjs[0].attrs['period'].decode('ascii'))
+    start = float(dobjs[0].attrs['start'].decode('ascii'))
+    num = sum(dobj.shape[0] for dobj in dobjs)
+    setattr(obj, 'time', lambda: start + period * np.arange(num))
+    for fname in dobjs[0].dtype.names:
+        data = np.concatenate([dobj[fname] for dobj in dobjs])
+        svtype = 'real' if ('f' == data.dtype.kind) else 'bit'
+        setattr(obj, fname, data)
+        setattr(info, fname, _DumpInfo(fname, 'sync', svtype, data.shape,
+                                       data.dtype))
+    return obj, info
+
+
 def _parsedata(name, dobj):
     """Process attributes and information about the dataset contents.
+
+    Signals stored as columns are groups of a time (or index) dataset and a
+    data dataset, which are accessed like the members of a compound dataset.
     """
+    if ('period' in dobj.attrs):
+        # Row group of one clock domain
+        return _parserows([dobj])
     obj = _DumpData()
     info = _DumpInfo(name, dobj.attrs['storage'].decode('ascii'),
                      dobj.attrs['svtype'].decode('ascii'),
                      None, None)
     # Construct the members
+    if ('time_res' in dobj.attrs):
+        # Integer ticks, which are also presented in ns
+        ticks = _ticks(dobj)
+        res = float(dobj.attrs['time_res'].decode('ascii'))
+        tpn = int(round(1e-9 / res))
+        setattr(obj, 'ticks', ticks)
     if ('time' == info.storage):
         # This is time, add ns and rem
-        setattr(obj, 'ns', dobj['ns'])
-        setattr(obj, 'rem', dobj['rem'])
+        if ('time_res' in dobj.attrs):
+            setattr(obj, 'ns', ticks // tpn)
+            setattr(obj, 'rem', (ticks % tpn) / tpn)
+        else:
+            setattr(obj, 'ns', dobj['ns'])
+            setattr(obj, 'rem', dobj['rem'])
         info.shape = dobj.shape
         info.dtype = dobj.dtype
         return obj, info
     elif ('async' == info.storage):
         # Split into time and data
-        setattr(obj, 'time', dobj['time'])
+        if ('time_res' in dobj.attrs):
+            setattr(obj, 'time', ticks / tpn)
+        else:
+            setattr(obj, 'time', dobj['time'])
         setattr(obj, 'data', dobj['data'])
         info.shape = dobj['data'].shape
         info.dtype = dobj['data'].dtype
         return obj, info
+    elif ('change' == info.storage):
+        # Sample index and data of each change, dense() expands them
+        setattr(obj, 'index', dobj['index'])
+        setattr(obj, 'data', dobj['data'])
+        setattr(obj, 'dense', lambda: _expand(dobj))
+        count = int(dobj.attrs['change_count'].decode('ascii'))
+        info.shape = (count,) + dobj['data'].shape[1:]
+        info.dtype = dobj['data'].dtype
+        return obj, info
+    elif ('packed_width' in dobj.attrs):
+        # Synchronous data stored as a bit stream, decoded in memory
+        data = _unpackbits(dobj)
+        info.shape = data.shape
+        info.dtype = data.dtype
+        return data, info
+    elif (dobj.dtype.names is None):
+        # Synchronous data stored as a plain array (e.g. scale-offset)
+        info.shape = dobj.shape
+        info.dtype = dobj.dtype
+        return dobj, info
     else:
         # This is synchronous data, drop final hierarchy level
         info.shape = dobj['data'].shape
@@ -83,13 +201,14 @@ def _treewalk(grp):
     node_obj = _DumpGroup()
     node_info = _DumpGroup()
     for k, v in grp.items():
-        if (h5py.Group == type(v)):
+        if ((h5py.Group == type(v)) and ('storage' not in v.attrs)):
             # Add this name as an attribute to the current group, and recurse
             obj_data, obj_info = _treewalk(v)
             setattr(node_obj, k, obj_data)
             setattr(node_info, k, obj_info)
-        elif (h5py.Dataset == type(v)):
-            # Assign the member to the data structure itself
+        elif (h5py.Dataset == type(v)) or (h5py.Group == type(v)):
+            # Assign the member (a dataset, or a signal stored as columns) to
+            # the data structure itself
             obj_data, obj_info = _parsedata(k, v)
             setattr(node_obj, k, obj_data)
             setattr(node_info, k, obj_info)
@@ -99,6 +218,72 @@ def _treewalk(grp):
     return node_obj, node_info
 
 
+def _joindata(name, dobjs):
+    """Join a signal of a rolled over file, from the segments which hold it.
+
+    Each segment is decoded on its own and the pieces are concatenated. The
+    sample indices of value changes count from the start of their segment,
+    which also begins with a change.
+    """
+    if ('period' in dobjs[0].attrs):
+        return _parserows(dobjs)
+    if (1 == len(dobjs)):
+        return _parsedata(name, dobjs[0])
+    parts = [_parsedata(name, dobj) for dobj in dobjs]
+    objs = [obj for obj, _ in parts]
+    infos = [info for _, info in parts]
+    info = infos[0]
+    info.shape = (sum(x.shape[0] for x in infos),) + tuple(info.shape[1:])
+    if (_DumpData != type(objs[0])):
+        # Synchronous data, a plain array of samples
+        return np.concatenate([x[()] for x in objs]), info
+    obj = _DumpData()
+    for key, val in vars(objs[0]).items():
+        if callable(val):
+            # Such as dense(), evaluated segment by segment
+            setattr(obj, key, lambda key=key: np.concatenate(
+                [getattr(x, key)() for x in objs]))
+        elif ('index' == key):
+            # Offset by the samples of the earlier segments
+            offs = np.cumsum([0] + [x.shape[0] for x in infos[:-1]])
+            setattr(obj, key, np.concatenate(
+                [x.index[()] + np.uint64(off) for x, off in zip(objs, offs)]))
+        else:
+            setattr(obj, key, np.concatenate(
+                [getattr(x, key)[()] for x in objs]))
+    return obj, info
+
+
+def _segwalk(grps):
+    """Walk the same group of every segment of a rolled over file together.
+
+    A signal is joined from the segments which hold it, those created after
+    the first segment are missing from the earlier ones.
+    """
+    node_obj = _DumpGroup()
+    node_info = _DumpGroup()
+    keys = []
+    for grp in grps:
+        keys += [k for k in grp.keys() if k not in keys]
+    for k in keys:
+        parts = [grp[k] for grp in grps if k in grp]
+        v = parts[0]
+        if ((h5py.Group == type(v)) and ('storage' not in v.attrs)):
+            # A group of the hierarchy, recurse into all of its segments
+            obj_data, obj_info = _segwalk(parts)
+            setattr(node_obj, k, obj_data)
+            setattr(node_info, k, obj_info)
+        elif (h5py.Dataset == type(v)) or (h5py.Group == type(v)):
+            # A signal, joined across the segments
+            obj_data, obj_info = _joindata(k, parts)
+            setattr(node_obj, k, obj_data)
+            setattr(node_info, k, obj_info)
+        else:
+            # This is an unrecognized group member
+            print("Member {} is unknown type: {}".format(k, type(v)))
+    return node_obj, node_info
+
+
 def _fmt_data(obj):
     """Format information about the dataset.
     """
@@ -116,6 +301,8 @@ def _fmt_data(obj):
         defstr += "{}:(time)".format(obj.shape)
     elif ('async' == obj.storage):
         defstr += "{}:(async {})".format(obj.shape, obj.dtype)
+    elif ('change' == obj.storage):
+        defstr += "{}:(change {})".format(obj.shape, obj.dtype)
     else:
         defstr += "{}:(sync {})".format(obj.shape, obj.dtype)
     return defstr
@@ -182,8 +369,14 @@ class SimDump:
         cache_bytes = cache_size * 1024 * 1024
         # Open the file
         self.fp = h5py.File(fname, rdcc_nbytes=cache_bytes)
-        # Construct the object members by traversing the tree
-        self.data, self.info = _treewalk(self.fp)
+        # Construct the object members by traversing the tree, a rolled over
+        # file links the segments which are finished, in order
+        if ('segments' in self.fp.attrs):
+            nseg = int(self.fp.attrs['segments'].decode('ascii'))
+            segs = [self.fp['seg{:04d}'.format(k)] for k in range(nseg)]
+            self.data, self.info = _segwalk(segs)
+        else:
+            self.data, self.info = _treewalk(self.fp)
 
     def close(self):
         """Explicitly close the file.
@@ -14,6 +14,27 @@
 // 13-Nov-22: Initial version
 // 19-Dec-22: Lock the C random seed to the simulator random seed.
 // 12-Feb-23: Added flicker noise flush function.
+// 16-Oct-26: Added background writer option to svpDumpFile.
+// 16-Oct-26: Added expected sample count hint to svpDumpAbc.
+// 16-Oct-26: Added per-signal and file default compression filters.
+// 16-Oct-26: Added compression worker pool option to svpDumpFile.
+// 16-Oct-26: Added chunk size target to svpDumpFile.
+// 16-Oct-26: Added cache memory budget to svpDumpFile.
+// 16-Oct-26: Added huge page option to svpDumpFile.
+// 16-Oct-26: Added signal lookup by name, duplicate names are an error.
+// 16-Oct-26: Added lazy dataset creation option to svpDumpFile.
+// 16-Oct-26: Added write_block/write_queue to the dump classes.
+// 16-Oct-26: Scalar dumps pass their value directly, not as an array.
+// 16-Oct-26: svpBitArrayDump passes the packed vector, unpacked in C.
+// 16-Oct-26: Documented the bitpack storage option.
+// 16-Oct-26: ASYNC=2 stores only the samples which change value.
+// 16-Oct-26: Added svpRowGroup, one table per clock domain.
+// 16-Oct-26: Added the integer time base option.
+// 16-Oct-26: Added the time column layout option.
+// 16-Oct-26: Added write profiling to svpDumpFile and svpDumpAbc.
+// 16-Oct-26: Added the sharding option to svpDumpFile.
+// 16-Oct-26: Added the rollover option to svpDumpFile.
+// 16-Oct-26: Samples are timestamped with the exact fs count (svp_now_fs).
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -22,8 +43,26 @@
 
 `timescale 1ns/1fs
 
+/**
+ * Simulation time in fs, read in a scope of its own so that $time is an
+ * exact integer count whatever the timescale of the caller.
+ */
+package svp_time_pkg;
+timeunit 1fs;
+timeprecision 1fs;
+
+function automatic longint svp_now_fs();
+  return $time;
+endfunction : svp_now_fs
+
+endpackage  // svp_time_pkg
+
+
 package svp_pkg;
 
+import svp_time_pkg::svp_now_fs;
+export svp_time_pkg::svp_now_fs;
+
 ///////////////////////////////////////////////////////////////////////////////
 // Generally useful functions
 import "DPI-C" function string getenv(input string env_name);
@@ -152,19 +191,16 @@ typedef struct {
   real rem;
 } svp_sim_time_t;
 
+// Units per ns of the timestamps from svp_now_fs
+localparam longint FS_PER_NS = 1000000;
+
 
 function svp_sim_time_t get_sim_time();
-  real ctime;
-  ctime = $realtime();
-  get_sim_time.ns = $floor(ctime);
-  get_sim_time.rem = ctime - real'(get_sim_time.ns);
-  if (0 > get_sim_time.rem) begin
-    get_sim_time.ns -= 1;
-    get_sim_time.rem += 1.0;
-  end else if (1 <= get_sim_time.rem) begin
-    get_sim_time.ns += 1;
-    get_sim_time.ns -= 1.0;
-  end
+  // Split the exact fs count, $realtime drops fs beyond about 9 s
+  longint fs;
+  fs = svp_now_fs();
+  get_sim_time.ns = fs / FS_PER_NS;
+  get_sim_time.rem = real'(fs % FS_PER_NS) / FS_PER_NS;
   return get_sim_time;
 endfunction : get_sim_time
 
@@ -226,15 +262,39 @@ endfunction : svp_real_to_sim_time
 // HDF5 file handling
 import "DPI-C" function chandle svp_hdf5_fopen(string fname);
 import "DPI-C" function int svp_hdf5_addsig(chandle clsdat, chandle dat);
+import "DPI-C" function chandle svp_hdf5_getsig(chandle clsdat, string name);
 import "DPI-C" function int svp_hdf5_fclose(chandle clsdat);
+import "DPI-C" function int svp_hdf5_set_async_io(chandle clsdat, int enable);
+import "DPI-C" function int svp_hdf5_set_filter(chandle clsdat, string spec);
+import "DPI-C" function int svp_hdf5_set_compress_threads(chandle clsdat,
+                                                         int nthreads);
+import "DPI-C" function int svp_hdf5_set_chunk_bytes(chandle clsdat,
+                                                    longint nbytes);
+import "DPI-C" function int svp_hdf5_set_cache_budget(chandle clsdat,
+                                                     longint nbytes);
+import "DPI-C" function void svp_hdf5_set_huge_pages(chandle clsdat,
+                                                    int enable);
+import "DPI-C" function int svp_hdf5_set_lazy(chandle clsdat, int mode);
+import "DPI-C" function int svp_hdf5_set_time_res(chandle clsdat, real res);
+import "DPI-C" function int svp_hdf5_set_layout(chandle clsdat, int mode);
+import "DPI-C" function int svp_hdf5_set_profile(chandle clsdat, int topn);
+import "DPI-C" function int svp_hdf5_set_shards(chandle clsdat, int nshards);
+import "DPI-C" function int svp_hdf5_set_rollover(chandle clsdat, real period,
+                                                  longint samples,
+                                                  longint nbytes);
+import "DPI-C" function int svp_hdf5_rollover(chandle clsdat);
+import "DPI-C" function real svp_prof_file(chandle clsdat, string counter);
 import "DPI-C" function void svp_hdf5_add_attribute(chandle clsdat, string name,
                                                     string value);
 // Dump objects
 import "DPI-C" function chandle svp_dstore_svcreate(chandle clsdat, string name,
                                                     int store_type, int width,
-                                                    string dtype);
+                                                    string dtype, int precision,
+                                                    string filt);
 import "DPI-C" function void svp_dstore_svattr(chandle dat, string name,
                                                string value);
+import "DPI-C" function void svp_dstore_expect(chandle dat, longint num);
+import "DPI-C" function real svp_prof_signal(chandle dat, string counter);
 // Data writers
 import "DPI-C" function int svp_dstore_write_int8(chandle dat, real simtime,
                                                   input byte dbuf []);
@@ -248,6 +308,84 @@ import "DPI-C" function int svp_dstore_write_float64(chandle dat, real simtime,
                                                      input real dbuf []);
 import "DPI-C" function int svp_dstore_write_time(chandle dat,
                                                   svp_sim_time_t simtime);
+// Scalar writers
+import "DPI-C" function int svp_dstore_write_scalar_int8(chandle dat,
+                                                         real simtime,
+                                                         byte val);
+import "DPI-C" function int svp_dstore_write_scalar_int16(chandle dat,
+                                                          real simtime,
+                                                          shortint val);
+import "DPI-C" function int svp_dstore_write_scalar_int32(chandle dat,
+                                                          real simtime,
+                                                          int val);
+import "DPI-C" function int svp_dstore_write_scalar_int64(chandle dat,
+                                                          real simtime,
+                                                          longint val);
+import "DPI-C" function int svp_dstore_write_scalar_float64(chandle dat,
+                                                            real simtime,
+                                                            real val);
+// Packed bit vector writers
+import "DPI-C" function int svp_dstore_write_bitvec(chandle dat, real simtime,
+                                                    input bit [] dbuf,
+                                                    int width, int size,
+                                                    int is_signed);
+import "DPI-C" function int svp_dstore_write_bitvec_block(chandle dat, int num,
+                                                          input real tbuf [],
+                                                          input bit [] dbuf [],
+                                                          int width, int size,
+                                                          int is_signed);
+// Block writers
+import "DPI-C" function int svp_dstore_write_block_int8(chandle dat, int num,
+                                                        input real tbuf [],
+                                                        input byte dbuf []);
+import "DPI-C" function int svp_dstore_write_block_int16(chandle dat,
+                                                         int num,
+                                                         input real tbuf [],
+                                                         input shortint dbuf[]);
+import "DPI-C" function int svp_dstore_write_block_int32(chandle dat, int num,
+                                                         input real tbuf [],
+                                                         input int dbuf []);
+import "DPI-C" function int svp_dstore_write_block_int64(chandle dat, int num,
+                                                         input real tbuf [],
+                                                         input longint dbuf []);
+import "DPI-C" function int svp_dstore_write_block_float64(chandle dat,
+                                                           int num,
+                                                           input real tbuf [],
+                                                           input real dbuf []);
+// Writers taking an integer timestamp, in units of 1 / per_ns ns
+import "DPI-C" function int svp_dstore_write_stamp_int(chandle dat,
+                                                       longint stamp,
+                                                       longint per_ns,
+                                                       longint val);
+import "DPI-C" function int svp_dstore_write_stamp_real(chandle dat,
+                                                        longint stamp,
+                                                        longint per_ns,
+                                                        real val);
+import "DPI-C" function int svp_dstore_write_stamp_ints(chandle dat,
+                                                        longint stamp,
+                                                        longint per_ns,
+                                                        input longint dbuf [],
+                                                        int size);
+import "DPI-C" function int svp_dstore_write_stamp_reals(chandle dat,
+                                                         longint stamp,
+                                                         longint per_ns,
+                                                         input real dbuf []);
+import "DPI-C" function int svp_dstore_write_stamp_bitvec(chandle dat,
+                                                          longint stamp,
+                                                          longint per_ns,
+                                                          input bit [] dbuf,
+                                                          int width, int size,
+                                                          int is_signed);
+// Row groups
+import "DPI-C" function chandle svp_rows_create(chandle clsdat, string name,
+                                                real period, real start);
+import "DPI-C" function int svp_rows_add_field(chandle rows, string fname,
+                                               string dtype, int width,
+                                               int size);
+import "DPI-C" function int svp_rows_register(chandle rows, string filt);
+import "DPI-C" function int svp_rows_write_bitvec(chandle rows,
+                                                  input bit [] dbuf,
+                                                  int nbits);
 
 
 /**
@@ -276,6 +414,212 @@ function new(string fname);
   svp_hdf5_add_attribute(this.dat, "dir", getenv("PWD"));
 endfunction
 
+/**
+ * Write full caches from a background thread instead of the simulator thread.
+ *
+ * @param enable If non-zero, the background writer is used.
+ */
+function void set_async_io(int enable);
+  void'(svp_hdf5_set_async_io(this.dat, enable));
+endfunction
+
+/**
+ * Set the compression filters used by signals that do not specify their own.
+ *
+ * @param spec Filters joined by '+': none, shuffle, deflate[:level], nbit,
+ * scaleoffset, bitpack. For example "shuffle+deflate:4". With bitpack,
+ * synchronous bit dumps narrower than 8 bits store WIDTH bits per sample.
+ */
+function void set_filter(string spec);
+  if (svp_hdf5_set_filter(this.dat, spec)) begin
+    $error("Invalid filter spec: %s", spec);
+  end
+endfunction
+
+/**
+ * Compress full caches on a pool of worker threads. This also enables the
+ * background writer (see set_async_io).
+ *
+ * @param nthreads Number of worker threads, 0 to stop the pool.
+ */
+function void set_compress_threads(int nthreads);
+  void'(svp_hdf5_set_compress_threads(this.dat, nthreads));
+endfunction
+
+/**
+ * Spread the signals over several files, each written by its own background
+ * writer. Must be called before any signal is created. Shard K of file.h5 is
+ * file_shardK.h5, and at close file.h5 links to every signal in the shards,
+ * so it is read as usual (keep the shards next to it).
+ *
+ * @param nshards Number of shard files.
+ */
+function void set_shards(int nshards);
+  if (svp_hdf5_set_shards(this.dat, nshards)) begin
+    $error("Could not create %0d shards", nshards);
+  end
+endfunction
+
+/**
+ * Write the signals to a series of segment files, so that a long simulation
+ * can be read up to its last finished segment while it runs. Must be called
+ * before any signal is created. Segment K of file.h5 is file_segK.h5, and
+ * file.h5 links the finished segments, which SimDump joins back into whole
+ * signals (keep the segments next to it). Each limit ends a segment when it
+ * is reached, and is only checked when a signal is written, so segments end
+ * near (not exactly at) their limits.
+ *
+ * @param period Sim time per segment (ns), 0 for no limit.
+ * @param samples Samples written to a segment over all of its signals, 0
+ * for no limit.
+ * @param nbytes Bytes written to a segment, 0 for no limit.
+ */
+function void set_rollover(real period, longint samples=0, longint nbytes=0);
+  if (svp_hdf5_set_rollover(this.dat, period, samples, nbytes)) begin
+    $error("Could not set rollover: %g, %0d, %0d", period, samples, nbytes);
+  end
+endfunction
+
+/**
+ * Close the current segment now and start the next one, in a file set up
+ * with set_rollover.
+ */
+function void rollover();
+  if (svp_hdf5_rollover(this.dat)) begin
+    $error("Could not roll over");
+  end
+endfunction
+
+/**
+ * Set the target size of each chunk (and its memory cache) for signals
+ * created after this call. The default is 1 MiB.
+ *
+ * @param nbytes Target chunk size in bytes.
+ */
+function void set_chunk_bytes(longint nbytes);
+  if (svp_hdf5_set_chunk_bytes(this.dat, nbytes)) begin
+    $error("Invalid chunk size: %0d", nbytes);
+  end
+endfunction
+
+/**
+ * Limit the total cache memory of the signals created after this call. The
+ * largest caches are flushed early when the limit is reached, and the memory
+ * used by each signal is printed at close.
+ *
+ * @param nbytes Cache memory budget in bytes, 0 for no limit.
+ */
+function void set_cache_budget(longint nbytes);
+  if (svp_hdf5_set_cache_budget(this.dat, nbytes)) begin
+    $error("Invalid cache budget: %0d", nbytes);
+  end
+endfunction
+
+/**
+ * Allocate the memory of signals created after this call from explicit huge
+ * pages, which must be reserved by the system (vm.nr_hugepages).
+ *
+ * @param enable If non-zero, huge pages are used.
+ */
+function void set_huge_pages(int enable);
+  svp_hdf5_set_huge_pages(this.dat, enable);
+endfunction
+
+/**
+ * Create the datasets of signals created after this call only when their
+ * first sample is written, so that idle signals cost no file objects or cache
+ * memory.
+ *
+ * @param mode 0: create datasets immediately (the default), 1: create idle
+ * signals as empty datasets at close, 2: leave idle signals out of the file.
+ */
+function void set_lazy(int mode);
+  if (svp_hdf5_set_lazy(this.dat, mode)) begin
+    $error("Invalid lazy mode: %0d", mode);
+  end
+endfunction
+
+/**
+ * Store the timestamps of async and time signals created after this call as
+ * exact 64-bit integer ticks, delta-encoded so they compress well, instead
+ * of doubles. The dump classes pass the simulation time as a whole number
+ * of fs (svp_now_fs), which is converted to ticks without rounding through
+ * a double, so timestamps stay exact however long the simulation runs.
+ *
+ * @param res Seconds per tick, normally the simulator precision (1e-15 with
+ * this package), or 0 for double timestamps (the default). A mismatch with
+ * the simulator precision is reported.
+ */
+function void set_time_res(real res);
+  real prec;
+  if (svp_hdf5_set_time_res(this.dat, res)) begin
+    $error("Invalid time resolution: %g", res);
+    return;
+  end
+  // Each tick should be one simulator time step, of at least the 1 fs step
+  // of the timestamps passed to the library
+  prec = 10.0 ** $timeprecision($root);
+  if ((0 < res) && (prec * (1 + 1e-6) < res)) begin
+    $warning("Time resolution %g is coarser than the simulator precision %g",
+             res, prec);
+  end else if ((0 < res) && (res * (1 + 1e-6) < prec)) begin
+    $warning("Time resolution %g is finer than the simulator precision %g",
+             res, prec);
+  end
+  if ((0 < res) && (prec * (1 + 1e-6) < 1e-15)) begin
+    $warning("Simulator precision %g is finer than 1 fs", prec);
+  end
+endfunction
+
+/**
+ * Choose how async (and ASYNC=2 value-change) signals created after this
+ * call are stored.
+ *
+ * @param mode 0: one compound dataset of time and data records (the
+ * default), 1: a group of separate time and data datasets, so the time
+ * column can be read on its own.
+ */
+function void set_layout(int mode);
+  if (svp_hdf5_set_layout(this.dat, mode)) begin
+    $error("Invalid layout: %0d", mode);
+  end
+endfunction
+
+/**
+ * Time the write path of every signal from this call on. At close, the
+ * totals are stored as prof_* attributes of the file, and printed with the
+ * signals which wrote the most bytes and spent the most time in HDF5 calls.
+ *
+ * @param topn Signals listed in each table of the report, 0 for the totals
+ * only.
+ */
+function void set_profile(int topn);
+  if (svp_hdf5_set_profile(this.dat, topn)) begin
+    $error("Invalid profile signal count: %0d", topn);
+  end
+endfunction
+
+/**
+ * Read a write profiling counter, summed over all signals.
+ *
+ * @param counter One of samples, bytes, flushes, write_s, extent_s, copy_s,
+ * stage_s, elapsed_s or mbps.
+ * @return Value of the counter (times in seconds), -1 if unknown.
+ */
+function real profile(string counter);
+  return svp_prof_file(this.dat, counter);
+endfunction
+
+/**
+ * Find the data store of a signal already added to this file.
+ *
+ * @param signame Name of the signal, as given when it was created.
+ * @return Data store handle, null if there is no such signal.
+ */
+function chandle find(string signame);
+  return svp_hdf5_getsig(this.dat, signame);
+endfunction
+
 /**
  * Close the file object. This MUST BE CALLED at the end of the simulation
  * (after all writes have finished).
@@ -296,15 +640,25 @@ endclass  // svpHdf5File
 virtual class svpDumpAbc;
   // HDF5 dataset data structure
   chandle dat;
+  // Staging arrays for block writes
+  byte blk8[];
+  shortint blk16[];
+  int blk32[];
+  longint blk64[];
+  real blkd[];
+  real blkt[];
 
   /**
    * Create new data dump object.
    *
    * @param fobj Instance of an SV-wrapped file object.
    * @param signame Name of signal to be dumped (as it will appear in the file).
-   * @param is_async If async, store a timestamp with each data sample.
+   * @param is_async 1 to store a timestamp with each data sample, 2 to store
+   * only the samples which change value.
    * @param width Array data width.
    * @param dtype Name of datatype to be stored.
+   * @param precision Significant bits of integer data (for nbit), 0 for all.
+   * @param filt Compression filters, "" to use the file default.
    *
    * Note that the signame can have hierarchy, e.g. u_top.u_mod.u_foo.mysig.
    * The data file will create the hierarchy according to the dot-delimiter.
@@ -313,11 +667,78 @@ virtual class svpDumpAbc;
   endfunction
 
   function alloc(svpDumpFile fobj, string signame, int is_async, int width,
-                 string dtype);
+                 string dtype, int precision=0, string filt="");
     // Create a new dstore object and pass structure pointer back
-    this.dat = svp_dstore_svcreate(fobj.dat, signame, is_async, width, dtype);
+    this.dat = svp_dstore_svcreate(fobj.dat, signame, is_async, width, dtype,
+                                   precision, filt);
+    if (null == this.dat) begin
+      $error("Could not create signal: %s", signame);
+      return 1;
+    end
     // Register signal with the file
-    void'(svp_hdf5_addsig(fobj.dat, this.dat));
+    return svp_hdf5_addsig(fobj.dat, this.dat);
+  endfunction
+
+  /**
+   * Pre-size the dataset for the number of samples expected to be written.
+   *
+   * @param num Expected number of samples (a hint, not a limit).
+   */
+  function void expect(longint num);
+    svp_dstore_expect(this.dat, num);
+  endfunction
+
+  /**
+   * Read a write profiling counter of this signal (see svpDumpFile).
+   *
+   * @param counter One of samples, bytes, flushes, write_s, extent_s,
+   * copy_s or stage_s.
+   * @return Value of the counter (times in seconds), -1 if unknown.
+   */
+  function real profile(string counter);
+    return svp_prof_signal(this.dat, counter);
+  endfunction
+
+  /**
+   * Size the staging arrays of a block write.
+   *
+   * @param num Number of elements needed.
+   * @param nbits Width of the elements (8, 16, 32, 64), 0 for real.
+   */
+  protected function void stage(int num, int nbits);
+    case (nbits)
+      8: begin
+        if (num != this.blk8.size()) this.blk8 = new[num];
+      end
+      16: begin
+        if (num != this.blk16.size()) this.blk16 = new[num];
+      end
+      32: begin
+        if (num != this.blk32.size()) this.blk32 = new[num];
+      end
+      64: begin
+        if (num != this.blk64.size()) this.blk64 = new[num];
+      end
+      default: begin
+        if (num != this.blkd.size()) this.blkd = new[num];
+      end
+    endcase
+  endfunction
+
+  /**
+   * Check that a block write has a timestamp for each sample, if needed.
+   *
+   * @param is_async Data has timestamps if 1.
+   * @param num Number of samples.
+   * @param ntimes Number of timestamps.
+   * @return 0 if the timestamps are valid.
+   */
+  protected function int check_times(int is_async, int num, int ntimes);
+    if ((1 == is_async) && (num != ntimes)) begin
+      $error("Expected %0d timestamps, got %0d", num, ntimes);
+      return 1;
+    end
+    return 0;
   endfunction
 
 endclass  // svpDumpAbc
@@ -326,50 +747,50 @@ endclass  // svpDumpAbc
 /**
  * Write raw binary signals.
  *
- * @tparam ASYNC If true, a timestamp is stored with each data sample.
+ * @tparam ASYNC If 1, a timestamp is stored with each data sample. If 2,
+ * only samples which differ from the previous one are stored, with their
+ * sample index.
  * @tparam SIGNED Specify whether the data should be interpreted as signed.
  * @tparam WIDTH Number of bits in the data bus.
  *
+ * Synchronous signals with WIDTH < 8 can be stored bit-packed, 8 / WIDTH
+ * samples per byte, by adding "bitpack" to the filters.
  */
 class svpBitDump #(int ASYNC=0, int SIGNED=1, int WIDTH=1) extends svpDumpAbc;
-  // Create local versions of all the different data sizes
-  byte val8[1];
-  shortint val16[1];
-  int val32[1];
-  longint val64[1];
 
   /**
    * Create a new data dump object.
    *
    * @param fobj Instance of opened data dump file.
    * @param signame Name of signal (as it will appear in data file).
+   * @param filt Compression filters, "" to use the file default.
    */
-  function new(svpDumpFile fobj, string signame);
+  function new(svpDumpFile fobj, string signame, string filt="");
     // Use the smallest possible datatype that can store the vector
     int status;
     if (8 >= WIDTH) begin
       if (SIGNED) begin
-        status = super.alloc(fobj, signame, ASYNC, 1, "char");
+        status = super.alloc(fobj, signame, ASYNC, 1, "char", WIDTH, filt);
       end else begin
-        status = super.alloc(fobj, signame, ASYNC, 1, "uchar");
+        status = super.alloc(fobj, signame, ASYNC, 1, "uchar", WIDTH, filt);
       end
     end else if (16 >= WIDTH) begin
       if (SIGNED) begin
-        status = super.alloc(fobj, signame, ASYNC, 1, "sint");
+        status = super.alloc(fobj, signame, ASYNC, 1, "sint", WIDTH, filt);
       end else begin
-        status = super.alloc(fobj, signame, ASYNC, 1, "usint");
+        status = super.alloc(fobj, signame, ASYNC, 1, "usint", WIDTH, filt);
       end
     end else if (32 >= WIDTH) begin
       if (SIGNED) begin
-        status = super.alloc(fobj, signame, ASYNC, 1, "int");
+        status = super.alloc(fobj, signame, ASYNC, 1, "int", WIDTH, filt);
       end else begin
-        status = super.alloc(fobj, signame, ASYNC, 1, "uint");
+        status = super.alloc(fobj, signame, ASYNC, 1, "uint", WIDTH, filt);
       end
     end else begin
       if (SIGNED) begin
-        status = super.alloc(fobj, signame, ASYNC, 1, "long");
+        status = super.alloc(fobj, signame, ASYNC, 1, "long", WIDTH, filt);
       end else begin
-        status = super.alloc(fobj, signame, ASYNC, 1, "ulong");
+        status = super.alloc(fobj, signame, ASYNC, 1, "ulong", WIDTH, filt);
       end
     end
     // Add SV type
@@ -382,89 +803,142 @@ class svpBitDump #(int ASYNC=0, int SIGNED=1, int WIDTH=1) extends svpDumpAbc;
    * @param dwrite Data to be written.
    */
   function void write(input bit [WIDTH-1:0] dwrite);
+    // Narrowed back to the width of the records in C
+    if (SIGNED) begin
+      void'(svp_dstore_write_stamp_int(super.dat, svp_now_fs(), FS_PER_NS,
+                                       signed'(dwrite)));
+    end else begin
+      void'(svp_dstore_write_stamp_int(super.dat, svp_now_fs(), FS_PER_NS,
+                                       unsigned'(dwrite)));
+    end
+  endfunction
+
+  /**
+   * Write many data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   * @param times Timestamp of each sample (only used if ASYNC is 1).
+   */
+  function void write_block(input bit [WIDTH-1:0] dwrite[],
+                            input real times[]={});
+    int num = dwrite.size();
+    if (check_times(ASYNC, num, times.size())) begin
+      return;
+    end
     if (8 >= WIDTH) begin
+      stage(num, 8);
       if (SIGNED) begin
-        this.val8[0] = signed'(dwrite);
+        foreach (dwrite[ii]) begin
+          this.blk8[ii] = signed'(dwrite[ii]);
+        end
       end else begin
-        this.val8[0] = unsigned'(dwrite);
+        foreach (dwrite[ii]) begin
+          this.blk8[ii] = unsigned'(dwrite[ii]);
+        end
       end
-      void'(svp_dstore_write_int8(super.dat, $realtime, this.val8));
+      void'(svp_dstore_write_block_int8(super.dat, num, times, this.blk8));
     end else if (16 >= WIDTH) begin
+      stage(num, 16);
       if (SIGNED) begin
-        this.val16[0] = signed'(dwrite);
+        foreach (dwrite[ii]) begin
+          this.blk16[ii] = signed'(dwrite[ii]);
+        end
       end else begin
-        this.val16[0] = unsigned'(dwrite);
+        foreach (dwrite[ii]) begin
+          this.blk16[ii] = unsigned'(dwrite[ii]);
+        end
       end
-      void'(svp_dstore_write_int16(super.dat, $realtime, this.val16));
+      void'(svp_dstore_write_block_int16(super.dat, num, times, this.blk16));
     end else if (32 >= WIDTH) begin
+      stage(num, 32);
       if (SIGNED) begin
-        this.val32[0] = signed'(dwrite);
+        foreach (dwrite[ii]) begin
+          this.blk32[ii] = signed'(dwrite[ii]);
+        end
       end else begin
-        this.val32[0] = unsigned'(dwrite);
+        foreach (dwrite[ii]) begin
+          this.blk32[ii] = unsigned'(dwrite[ii]);
+        end
       end
-      void'(svp_dstore_write_int32(super.dat, $realtime, this.val32));
+      void'(svp_dstore_write_block_int32(super.dat, num, times, this.blk32));
     end else begin
+      stage(num, 64);
       if (SIGNED) begin
-        this.val64[0] = signed'(dwrite);
+        foreach (dwrite[ii]) begin
+          this.blk64[ii] = signed'(dwrite[ii]);
+        end
       end else begin
-        this.val64[0] = unsigned'(dwrite);
+        foreach (dwrite[ii]) begin
+          this.blk64[ii] = unsigned'(dwrite[ii]);
+        end
       end
-      void'(svp_dstore_write_int64(super.dat, $realtime, this.val64));
+      void'(svp_dstore_write_block_int64(super.dat, num, times, this.blk64));
     end
   endfunction
 
+  /**
+   * Write a queue of data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   * @param times Timestamp of each sample (only used if ASYNC is 1).
+   */
+  function void write_queue(input bit [WIDTH-1:0] dwrite[$],
+                            input real times[$]={});
+    this.write_block(dwrite, times);
+  endfunction
+
 endclass  // svpBitDump
 
 
 /**
  * Write a 1-D packed array of raw binary signals.
  *
- * @tparam ASYNC If true, a timestamp is stored with each data sample.
+ * @tparam ASYNC If 1, a timestamp is stored with each data sample. If 2,
+ * only samples which differ from the previous one are stored, with their
+ * sample index.
  * @tparam SIGNED Specify whether the data should be interpreted as signed.
  * @tparam WIDTH Number of bits in the data bus.
  * @tparam SIZE Packed data width.
  *
+ * Synchronous signals with WIDTH < 8 can be stored bit-packed, with the lanes
+ * of each sample back to back, by adding "bitpack" to the filters.
  */
 class svpBitArrayDump
 #(int ASYNC=0, int SIGNED=1, int WIDTH=1, int SIZE=1) extends svpDumpAbc;
-  // Create local versions of all the different data sizes
-  byte val8[SIZE];
-  shortint val16[SIZE];
-  int val32[SIZE];
-  longint val64[SIZE];
 
   /**
    * Create a new data dump object.
    *
    * @param fobj Instance of opened data dump file.
    * @param signame Name of signal (as it will appear in data file).
+   * @param filt Compression filters, "" to use the file default.
    */
-  function new(svpDumpFile fobj, string signame);
+  function new(svpDumpFile fobj, string signame, string filt="");
     // Use the smallest possible datatype that can store the vector
     int status;
     if (8 >= WIDTH) begin
       if (SIGNED) begin
-        status = super.alloc(fobj, signame, ASYNC, SIZE, "char");
+        status = super.alloc(fobj, signame, ASYNC, SIZE, "char", WIDTH, filt);
       end else begin
-        status = super.alloc(fobj, signame, ASYNC, SIZE, "uchar");
+        status = super.alloc(fobj, signame, ASYNC, SIZE, "uchar", WIDTH, filt);
       end
     end else if (16 >= WIDTH) begin
       if (SIGNED) begin
-        status = super.alloc(fobj, signame, ASYNC, SIZE, "sint");
+        status = super.alloc(fobj, signame, ASYNC, SIZE, "sint", WIDTH, filt);
       end else begin
-        status = super.alloc(fobj, signame, ASYNC, SIZE, "usint");
+        status = super.alloc(fobj, signame, ASYNC, SIZE, "usint", WIDTH, filt);
       end
     end else if (32 >= WIDTH) begin
       if (SIGNED) begin
-        status = super.alloc(fobj, signame, ASYNC, SIZE, "int");
+        status = super.alloc(fobj, signame, ASYNC, SIZE, "int", WIDTH, filt);
       end else begin
-        status = super.alloc(fobj, signame, ASYNC, SIZE, "uint");
+        status = super.alloc(fobj, signame, ASYNC, SIZE, "uint", WIDTH, filt);
       end
     end else begin
       if (SIGNED) begin
-        status = super.alloc(fobj, signame, ASYNC, SIZE, "long");
+        status = super.alloc(fobj, signame, ASYNC, SIZE, "long", WIDTH, filt);
       end else begin
-        status = super.alloc(fobj, signame, ASYNC, SIZE, "ulong");
+        status = super.alloc(fobj, signame, ASYNC, SIZE, "ulong", WIDTH, filt);
       end
     end
     // Add SV type
@@ -477,53 +951,35 @@ class svpBitArrayDump
    * @param dwrite Data to be written.
    */
   function void write(input bit [SIZE-1:0][WIDTH-1:0] dwrite);
-    // Data must be copied to a C-compliant (unpacked) array
-    int ii = 0;
-    if (8 >= WIDTH) begin
-      if (SIGNED) begin
-        for (ii = 0; SIZE > ii; ii++) begin
-          this.val8[ii] = signed'(dwrite[ii]);
-        end
-      end else begin
-        for (ii = 0; SIZE > ii; ii++) begin
-          this.val8[ii] = unsigned'(dwrite[ii]);
-        end
-      end
-      void'(svp_dstore_write_int8(super.dat, $realtime, this.val8));
-    end else if (16 >= WIDTH) begin
-      if (SIGNED) begin
-        for (ii = 0; SIZE > ii; ii++) begin
-          this.val16[ii] = signed'(dwrite[ii]);
-        end
-      end else begin
-        for (ii = 0; SIZE > ii; ii++) begin
-          this.val16[ii] = unsigned'(dwrite[ii]);
-        end
-      end
-      void'(svp_dstore_write_int16(super.dat, $realtime, this.val16));
-    end else if (32 >= WIDTH) begin
-      if (SIGNED) begin
-        for (ii = 0; SIZE > ii; ii++) begin
-          this.val32[ii] = signed'(dwrite[ii]);
-        end
-      end else begin
-        for (ii = 0; SIZE > ii; ii++) begin
-          this.val32[ii] = unsigned'(dwrite[ii]);
-        end
-      end
-      void'(svp_dstore_write_int32(super.dat, $realtime, this.val32));
-    end else begin
-      if (SIGNED) begin
-        for (ii = 0; SIZE > ii; ii++) begin
-          this.val64[ii] = signed'(dwrite[ii]);
-        end
-      end else begin
-        for (ii = 0; SIZE > ii; ii++) begin
-          this.val64[ii] = unsigned'(dwrite[ii]);
-        end
-      end
-      void'(svp_dstore_write_int64(super.dat, $realtime, this.val64));
+    // The lanes are unpacked (and sign-extended) in C
+    void'(svp_dstore_write_stamp_bitvec(super.dat, svp_now_fs(), FS_PER_NS,
+                                        dwrite, WIDTH, SIZE, SIGNED));
+  endfunction
+
+  /**
+   * Write many data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   * @param times Timestamp of each sample (only used if ASYNC is 1).
+   */
+  function void write_block(input bit [SIZE-1:0][WIDTH-1:0] dwrite[],
+                            input real times[]={});
+    if (check_times(ASYNC, dwrite.size(), times.size())) begin
+      return;
     end
+    void'(svp_dstore_write_bitvec_block(super.dat, dwrite.size(), times,
+                                        dwrite, WIDTH, SIZE, SIGNED));
+  endfunction
+
+  /**
+   * Write a queue of data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   * @param times Timestamp of each sample (only used if ASYNC is 1).
+   */
+  function void write_queue(input bit [SIZE-1:0][WIDTH-1:0] dwrite[$],
+                            input real times[$]={});
+    this.write_block(dwrite, times);
   endfunction
 
 endclass  // svpBitArrayDump
@@ -532,38 +988,36 @@ endclass  // svpBitArrayDump
 /**
  * Write integers.
  *
- * @tparam ASYNC If true, a timestamp is stored with each data sample.
+ * @tparam ASYNC If 1, a timestamp is stored with each data sample. If 2,
+ * only samples which differ from the previous one are stored, with their
+ * sample index.
  * @tparam T integer datatype (byte, shortint, int, longint).
  *
  */
 class svpIntegerDump #(int ASYNC=0, type T=byte) extends svpDumpAbc;
-  // Local array storage
-  byte val8[1];
-  shortint val16[1];
-  int val32[1];
-  longint val64[1];
 
   /**
    * Create a new data dump object.
    *
    * @param fobj Instance of opened data dump file.
    * @param signame Name of signal (as it will appear in data file).
+   * @param filt Compression filters, "" to use the file default.
    */
-  function new(svpDumpFile fobj, string signame);
+  function new(svpDumpFile fobj, string signame, string filt="");
     // Check type
     int status;
     case ($typename(T))
       "byte": begin
-        status = super.alloc(fobj, signame, ASYNC, 1, "char");
+        status = super.alloc(fobj, signame, ASYNC, 1, "char", 0, filt);
       end
       "shortint": begin
-        status = super.alloc(fobj, signame, ASYNC, 1, "sint");
+        status = super.alloc(fobj, signame, ASYNC, 1, "sint", 0, filt);
       end
       "int": begin
-        status = super.alloc(fobj, signame, ASYNC, 1, "int");
+        status = super.alloc(fobj, signame, ASYNC, 1, "int", 0, filt);
       end
       "longint": begin
-        status = super.alloc(fobj, signame, ASYNC, 1, "long");
+        status = super.alloc(fobj, signame, ASYNC, 1, "long", 0, filt);
       end
       default: begin
         $error("Datatype %s is invalid!", $typename(T));
@@ -579,34 +1033,74 @@ class svpIntegerDump #(int ASYNC=0, type T=byte) extends svpDumpAbc;
    * @param dwrite Data to be written.
    */
   function void write(input T dwrite);
-    // Call correct write method
+    // Narrowed back to T in C
+    void'(svp_dstore_write_stamp_int(super.dat, svp_now_fs(), FS_PER_NS,
+                                     dwrite));
+  endfunction
+
+  /**
+   * Write many data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   * @param times Timestamp of each sample (only used if ASYNC is 1).
+   */
+  function void write_block(input T dwrite[], input real times[]={});
+    int num = dwrite.size();
+    if (check_times(ASYNC, num, times.size())) begin
+      return;
+    end
     case ($typename(T))
       "byte": begin
-        this.val8[0] = dwrite;
-        void'(svp_dstore_write_int8(super.dat, $realtime, this.val8));
+        stage(num, 8);
+        foreach (dwrite[ii]) begin
+          this.blk8[ii] = dwrite[ii];
+        end
+        void'(svp_dstore_write_block_int8(super.dat, num, times, this.blk8));
       end
       "shortint": begin
-        this.val16[0] = dwrite;
-        void'(svp_dstore_write_int16(super.dat, $realtime, this.val16));
+        stage(num, 16);
+        foreach (dwrite[ii]) begin
+          this.blk16[ii] = dwrite[ii];
+        end
+        void'(svp_dstore_write_block_int16(super.dat, num, times, this.blk16));
       end
       "int": begin
-        this.val32[0] = dwrite;
-        void'(svp_dstore_write_int32(super.dat, $realtime, this.val32));
+        stage(num, 32);
+        foreach (dwrite[ii]) begin
+          this.blk32[ii] = dwrite[ii];
+        end
+        void'(svp_dstore_write_block_int32(super.dat, num, times, this.blk32));
       end
       "longint": begin
-        this.val64[0] = dwrite;
-        void'(svp_dstore_write_int64(super.dat, $realtime, this.val64));
+        stage(num, 64);
+        foreach (dwrite[ii]) begin
+          this.blk64[ii] = dwrite[ii];
+        end
+        void'(svp_dstore_write_block_int64(super.dat, num, times, this.blk64));
       end
     endcase
   endfunction
 
+  /**
+   * Write a queue of data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   * @param times Timestamp of each sample (only used if ASYNC is 1).
+   */
+  function void write_queue(input T dwrite[$],
+                            input real times[$]={});
+    this.write_block(dwrite, times);
+  endfunction
+
 endclass  // svpIntegerDump
 
 
 /**
  * Write an array of integers.
  *
- * @tparam ASYNC If true, a timestamp is stored with each data sample.
+ * @tparam ASYNC If 1, a timestamp is stored with each data sample. If 2,
+ * only samples which differ from the previous one are stored, with their
+ * sample index.
  * @tparam T integer datatype (byte, shortint, int, longint).
  * @tparam SIZE array width.
  *
@@ -614,9 +1108,6 @@ endclass  // svpIntegerDump
 class svpIntegerArrayDump
 #(int ASYNC=0, type T=byte, int SIZE=1) extends svpDumpAbc;
   // Local array storage
-  byte val8[SIZE];
-  shortint val16[SIZE];
-  int val32[SIZE];
   longint val64[SIZE];
 
   /**
@@ -624,22 +1115,23 @@ class svpIntegerArrayDump
    *
    * @param fobj Instance of opened data dump file.
    * @param signame Name of signal (as it will appear in data file).
+   * @param filt Compression filters, "" to use the file default.
    */
-  function new(svpDumpFile fobj, string signame);
+  function new(svpDumpFile fobj, string signame, string filt="");
     // Check type
     int status;
     case ($typename(T))
       "byte": begin
-        status = super.alloc(fobj, signame, ASYNC, SIZE, "char");
+        status = super.alloc(fobj, signame, ASYNC, SIZE, "char", 0, filt);
       end
       "shortint": begin
-        status = super.alloc(fobj, signame, ASYNC, SIZE, "sint");
+        status = super.alloc(fobj, signame, ASYNC, SIZE, "sint", 0, filt);
       end
       "int": begin
-        status = super.alloc(fobj, signame, ASYNC, SIZE, "int");
+        status = super.alloc(fobj, signame, ASYNC, SIZE, "int", 0, filt);
       end
       "longint": begin
-        status = super.alloc(fobj, signame, ASYNC, SIZE, "long");
+        status = super.alloc(fobj, signame, ASYNC, SIZE, "long", 0, filt);
       end
       default: begin
         $error("Datatype %s is invalid!", $typename(T));
@@ -655,55 +1147,89 @@ class svpIntegerArrayDump
    * @param dwrite Data to be written.
    */
   function void write(input T dwrite[SIZE]);
-    // Call correct write method
-    int ii;
+    // Narrowed back to T in C
+    foreach (dwrite[ii]) begin
+      this.val64[ii] = dwrite[ii];
+    end
+    void'(svp_dstore_write_stamp_ints(super.dat, svp_now_fs(), FS_PER_NS,
+                                      this.val64, SIZE));
+  endfunction
+
+  /**
+   * Write many data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   * @param times Timestamp of each sample (only used if ASYNC is 1).
+   */
+  function void write_block(input T dwrite[][SIZE], input real times[]={});
+    int num = dwrite.size();
+    if (check_times(ASYNC, num, times.size())) begin
+      return;
+    end
     case ($typename(T))
       "byte": begin
-        for (ii = 0; SIZE > ii; ii++) begin
-          this.val8[ii] = dwrite[ii];
+        stage(num * SIZE, 8);
+        foreach (dwrite[ii, jj]) begin
+          this.blk8[ii * SIZE + jj] = dwrite[ii][jj];
         end
-        void'(svp_dstore_write_int8(super.dat, $realtime, this.val8));
+        void'(svp_dstore_write_block_int8(super.dat, num, times, this.blk8));
       end
       "shortint": begin
-        for (ii = 0; SIZE > ii; ii++) begin
-          this.val16[ii] = dwrite[ii];
+        stage(num * SIZE, 16);
+        foreach (dwrite[ii, jj]) begin
+          this.blk16[ii * SIZE + jj] = dwrite[ii][jj];
         end
-        void'(svp_dstore_write_int16(super.dat, $realtime, this.val16));
+        void'(svp_dstore_write_block_int16(super.dat, num, times, this.blk16));
       end
       "int": begin
-        for (ii = 0; SIZE > ii; ii++) begin
-          this.val32[ii] = dwrite[ii];
+        stage(num * SIZE, 32);
+        foreach (dwrite[ii, jj]) begin
+          this.blk32[ii * SIZE + jj] = dwrite[ii][jj];
         end
-        void'(svp_dstore_write_int32(super.dat, $realtime, this.val32));
+        void'(svp_dstore_write_block_int32(super.dat, num, times, this.blk32));
       end
       "longint": begin
-        for (ii = 0; SIZE > ii; ii++) begin
-          this.val64[ii] = dwrite[ii];
+        stage(num * SIZE, 64);
+        foreach (dwrite[ii, jj]) begin
+          this.blk64[ii * SIZE + jj] = dwrite[ii][jj];
         end
-        void'(svp_dstore_write_int64(super.dat, $realtime, this.val64));
+        void'(svp_dstore_write_block_int64(super.dat, num, times, this.blk64));
       end
     endcase
   endfunction
 
+  /**
+   * Write a queue of data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   * @param times Timestamp of each sample (only used if ASYNC is 1).
+   */
+  function void write_queue(input T dwrite[$][SIZE],
+                            input real times[$]={});
+    this.write_block(dwrite, times);
+  endfunction
+
 endclass  // svpIntegerDump
 
 
 /**
  * Write real numbers.
  *
- * @tparam ASYNC If true, a timestamp is stored with each data sample.
+ * @tparam ASYNC If 1, a timestamp is stored with each data sample. If 2,
+ * only samples which differ from the previous one are stored, with their
+ * sample index.
  */
 class svpRealDump #(int ASYNC=0) extends svpDumpAbc;
-  real dval[1];
 
   /**
    * Create a new data dump object.
    *
    * @param fobj Instance of opened data dump file.
    * @param signame Name of signal (as it will appear in data file).
+   * @param filt Compression filters, "" to use the file default.
    */
-  function new(svpDumpFile fobj, string signame);
-    int status = super.alloc(fobj, signame, ASYNC, 1, "double");
+  function new(svpDumpFile fobj, string signame, string filt="");
+    int status = super.alloc(fobj, signame, ASYNC, 1, "double", 0, filt);
     // Add SV type
     svp_dstore_svattr(this.dat, "svtype", "real");
   endfunction
@@ -714,8 +1240,33 @@ class svpRealDump #(int ASYNC=0) extends svpDumpAbc;
    * @param dwrite Data to be written.
    */
   function void write(input real dwrite);
-    this.dval[0] = dwrite;
-    void'(svp_dstore_write_float64(super.dat, $realtime, this.dval));
+    void'(svp_dstore_write_stamp_real(super.dat, svp_now_fs(), FS_PER_NS,
+                                      dwrite));
+  endfunction
+
+  /**
+   * Write many data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   * @param times Timestamp of each sample (only used if ASYNC is 1).
+   */
+  function void write_block(input real dwrite[], input real times[]={});
+    if (check_times(ASYNC, dwrite.size(), times.size())) begin
+      return;
+    end
+    void'(svp_dstore_write_block_float64(super.dat, dwrite.size(), times,
+                                         dwrite));
+  endfunction
+
+  /**
+   * Write a queue of data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   * @param times Timestamp of each sample (only used if ASYNC is 1).
+   */
+  function void write_queue(input real dwrite[$],
+                            input real times[$]={});
+    this.write_block(dwrite, times);
   endfunction
 endclass  //svpRealDump
 
@@ -723,7 +1274,9 @@ endclass  //svpRealDump
 /**
  * Write an array of real numbers.
  *
- * @tparam ASYNC If true, a timestamp is stored with each data sample.
+ * @tparam ASYNC If 1, a timestamp is stored with each data sample. If 2,
+ * only samples which differ from the previous one are stored, with their
+ * sample index.
  * @tparam T integer datatype (byte, shortint, int, longint).
  * @tparam SIZE array width.
  */
@@ -734,9 +1287,10 @@ class svpRealArrayDump #(int ASYNC=0, int SIZE=1) extends svpDumpAbc;
    *
    * @param fobj Instance of opened data dump file.
    * @param signame Name of signal (as it will appear in data file).
+   * @param filt Compression filters, "" to use the file default.
    */
-  function new(svpDumpFile fobj, string signame);
-    int status = super.alloc(fobj, signame, ASYNC, SIZE, "double");
+  function new(svpDumpFile fobj, string signame, string filt="");
+    int status = super.alloc(fobj, signame, ASYNC, SIZE, "double", 0, filt);
     // Add SV type
     svp_dstore_svattr(this.dat, "svtype", "real");
   endfunction
@@ -747,7 +1301,38 @@ class svpRealArrayDump #(int ASYNC=0, int SIZE=1) extends svpDumpAbc;
    * @param dwrite Data to be written.
    */
   function void write(input real dwrite[SIZE]);
-    void'(svp_dstore_write_float64(super.dat, $realtime, dwrite));
+    void'(svp_dstore_write_stamp_reals(super.dat, svp_now_fs(), FS_PER_NS,
+                                       dwrite));
+  endfunction
+
+  /**
+   * Write many data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   * @param times Timestamp of each sample (only used if ASYNC is 1).
+   */
+  function void write_block(input real dwrite[][SIZE],
+                            input real times[]={});
+    int num = dwrite.size();
+    if (check_times(ASYNC, num, times.size())) begin
+      return;
+    end
+    stage(num * SIZE, 0);
+    foreach (dwrite[ii, jj]) begin
+      this.blkd[ii * SIZE + jj] = dwrite[ii][jj];
+    end
+    void'(svp_dstore_write_block_float64(super.dat, num, times, this.blkd));
+  endfunction
+
+  /**
+   * Write a queue of data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   * @param times Timestamp of each sample (only used if ASYNC is 1).
+   */
+  function void write_queue(input real dwrite[$][SIZE],
+                            input real times[$]={});
+    this.write_block(dwrite, times);
   endfunction
 
 endclass // svpRealArrayDump
@@ -758,16 +1343,16 @@ endclass // svpRealArrayDump
  *
  */
 class svpTimeDump extends svpDumpAbc;
-  longint ns[1];
 
   /**
    * Create a new data dump object.
    *
    * @param fobj Instance of opened data dump file.
    * @param signame Name of signal (as it will appear in data file).
+   * @param filt Compression filters, "" to use the file default.
    */
-  function new(svpDumpFile fobj, string signame);
-    int status = super.alloc(fobj, signame, 0, 1, "time");
+  function new(svpDumpFile fobj, string signame, string filt="");
+    int status = super.alloc(fobj, signame, 0, 1, "time", 0, filt);
     // Add SV type
     svp_dstore_svattr(this.dat, "svtype", "time");
   endfunction
@@ -778,12 +1363,135 @@ class svpTimeDump extends svpDumpAbc;
    * @param dwrite Data to be written.
    */
   function void write(input svp_sim_time_t dwrite);
-    this.ns[0] = dwrite.ns;
-    void'(svp_dstore_write_int64(super.dat, dwrite.rem, this.ns));
+    void'(svp_dstore_write_scalar_int64(super.dat, dwrite.rem, dwrite.ns));
+  endfunction
+
+  /**
+   * Write many data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   */
+  function void write_block(input svp_sim_time_t dwrite[]);
+    int num = dwrite.size();
+    stage(num, 64);
+    if (num != this.blkt.size()) begin
+      this.blkt = new[num];
+    end
+    foreach (dwrite[ii]) begin
+      this.blk64[ii] = dwrite[ii].ns;
+      this.blkt[ii] = dwrite[ii].rem;
+    end
+    void'(svp_dstore_write_block_int64(super.dat, num, this.blkt, this.blk64));
+  endfunction
+
+  /**
+   * Write a queue of data samples with a single call into the library.
+   *
+   * @param dwrite Data samples to be written, oldest first.
+   */
+  function void write_queue(input svp_sim_time_t dwrite[$]);
+    this.write_block(dwrite);
   endfunction
 endclass  //svpRealDump
 
 
+/**
+ * Write the signals of one clock domain as a single table, one row per tick.
+ *
+ * Fields are added, then the group is created, after which each write
+ * stores a whole row with one call into the library. The row is a packed
+ * vector with the first field added in the most significant bits, which is
+ * the layout of a packed struct whose members are the fields in the same
+ * order. Row k is the sample at start + k * period, both kept as attributes,
+ * and simdump.py presents each field as a signal.
+ *
+ * @tparam NBITS Width of the packed row (the total width of all fields).
+ */
+class svpRowGroup #(int NBITS=32);
+  chandle dat;
+
+  /**
+   * Start a new row group.
+   *
+   * @param fobj Instance of opened data dump file.
+   * @param name Name of the row group (as it will appear in data file).
+   * @param period Clock period.
+   * @param start Time of the first row.
+   */
+  function new(svpDumpFile fobj, string name, real period, real start=0.0);
+    this.dat = svp_rows_create(fobj.dat, name, period, start);
+  endfunction
+
+  /**
+   * Add a field of raw binary signals (as svpBitDump or svpBitArrayDump).
+   *
+   * @param fname Field name.
+   * @param width Number of bits of each lane.
+   * @param is_signed Whether the data should be interpreted as signed.
+   * @param size Number of lanes.
+   */
+  function void add_bit(string fname, int width, int is_signed=1, int size=1);
+    string dtype;
+    if (8 >= width) begin
+      dtype = (is_signed) ? "char" : "uchar";
+    end else if (16 >= width) begin
+      dtype = (is_signed) ? "sint" : "usint";
+    end else if (32 >= width) begin
+      dtype = (is_signed) ? "int" : "uint";
+    end else begin
+      dtype = (is_signed) ? "long" : "ulong";
+    end
+    this.add_field(fname, dtype, width, size);
+  endfunction
+
+  /**
+   * Add a field of reals, each passed in the row as its 64 bits ($realtobits).
+   *
+   * @param fname Field name.
+   * @param size Number of lanes.
+   */
+  function void add_real(string fname, int size=1);
+    this.add_field(fname, "double", 64, size);
+  endfunction
+
+  /**
+   * Add a field of any stored datatype.
+   *
+   * @param fname Field name.
+   * @param dtype Stored datatype: char, uchar, sint, usint, int, uint, long,
+   * ulong or double.
+   * @param width Bits of each lane in the row, 0 for the full datatype.
+   * @param size Number of lanes.
+   */
+  function void add_field(string fname, string dtype, int width=0,
+                          int size=1);
+    if (svp_rows_add_field(this.dat, fname, dtype, width, size)) begin
+      $error("Could not add field: %s", fname);
+    end
+  endfunction
+
+  /**
+   * Create the dataset, once all fields are added.
+   *
+   * @param filt Compression filters, "" to use the file default.
+   */
+  function void create(string filt="");
+    if (svp_rows_register(this.dat, filt)) begin
+      $error("Could not create row group");
+    end
+  endfunction
+
+  /**
+   * Write a row.
+   *
+   * @param row All fields, the first one added in the most significant bits.
+   */
+  function void write(input bit [NBITS-1:0] row);
+    void'(svp_rows_write_bitvec(this.dat, row, NBITS));
+  endfunction
+endclass  // svpRowGroup
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Math functions
 
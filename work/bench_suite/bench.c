@@ -0,0 +1,250 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Benchmark suite of the dump and noise libraries, run without a simulator.
+// Every dtype is written with each storage type, as scalars and arrays, to a
+// range of signal counts, and the noise generators are sampled. Results are
+// written as JSON, to track regressions against a baseline.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "../../csrc/svp_file.h"
+#include "../../csrc/svp_dstore.h"
+#include "../../csrc/svp_noise.h"
+
+/// Samples written in each dump run, over all of its signals
+#define NUM_WRITE 2000000
+/// Samples drawn from each noise generator
+#define NUM_NOISE 20000000
+/// Lanes of the array signals
+#define ARRAY_WIDTH 16
+/// Output file of the dump runs
+#define FNAME "bench.h5"
+
+/// Datatypes accepted by svp_dstore_svcreate
+static const char *DTYPES[] = {"char", "uchar", "sint", "usint", "int", "uint",
+                               "long", "ulong", "double"};
+/// Storage types, by the is_async argument of svp_dstore_svcreate
+static const char *STORAGE[] = {"sync", "async", "change"};
+/// Signal counts, the samples are shared between the signals
+static const int NUM_SIGNALS[] = {1, 16, 256};
+
+
+/**
+ * @brief Wall-clock time.
+ *
+ * @return double Seconds since an arbitrary origin.
+ */
+double now(void) {
+  struct timespec tnow;
+  clock_gettime(CLOCK_MONOTONIC, &tnow);
+  return tnow.tv_sec + 1e-9 * tnow.tv_nsec;
+}  // now
+
+
+/**
+ * @brief Write a sample to a signal.
+ *
+ * @param ds Data store.
+ * @param esize Size of the datatype (bytes).
+ * @param is_real Datatype is a double.
+ * @param width Number of lanes, 1 uses the scalar writers.
+ * @param simtime Timestamp of the sample.
+ * @param val Value of the sample.
+ * @param buf Sample of width lanes, lane 0 is set to val.
+ */
+static inline void write_sample(struct svp_dstore_t *ds, int esize,
+                                int is_real, int width, double simtime,
+                                long val, char *buf) {
+  if (1 < width) {
+    memcpy(buf, &val, esize);
+    svp_dstore_write_data(ds, simtime, buf);
+    return;
+  }
+  switch (esize) {
+    case (1) :
+      svp_dstore_write_scalar_int8(ds, simtime, val);
+      break;
+    case (2) :
+      svp_dstore_write_scalar_int16(ds, simtime, val);
+      break;
+    case (4) :
+      svp_dstore_write_scalar_int32(ds, simtime, val);
+      break;
+    default :
+      if (is_real) {
+        svp_dstore_write_scalar_float64(ds, simtime, val);
+      } else {
+        svp_dstore_write_scalar_int64(ds, simtime, val);
+      }
+  }
+}  // write_sample
+
+
+/**
+ * @brief Dump one configuration, and append its result.
+ *
+ * @param fp JSON output, positioned inside the dstore list.
+ * @param first No result has been written to the list yet.
+ * @param dtype Datatype name, "time" for simulation time storage.
+ * @param storage Index in STORAGE.
+ * @param width Number of lanes, 1 for scalars.
+ * @param nsig Number of signals.
+ */
+static void run_dstore(FILE *fp, int first, const char *dtype, int storage,
+                       int width, int nsig) {
+  char name[32];
+  struct svp_dstore_t **ds = malloc(nsig * sizeof(struct svp_dstore_t *));
+  int is_time = (0 == strcmp(dtype, "time"));
+  hid_t h5type = is_time ? H5T_NATIVE_DOUBLE : svp_dtype_lookup(dtype);
+  int esize = H5Tget_size(h5type);
+  int is_real = (H5T_FLOAT == H5Tget_class(h5type));
+  char *buf = calloc(width, esize);
+  long nwrite = NUM_WRITE / nsig;
+  // Signals are created outside of the measurement
+  struct svp_hdf5_data *dat = svp_hdf5_fopen(FNAME);
+  for (int ii = 0; nsig > ii; ++ii) {
+    sprintf(name, "top.sig%d", ii);
+    ds[ii] = svp_dstore_svcreate(dat, name, storage, width, dtype, 0, "");
+    svp_hdf5_addsig(dat, ds[ii]);
+  }
+  // The values change every few samples, so value changes keep a quarter
+  double t0 = now();
+  for (long jj = 0; nwrite > jj; ++jj) {
+    double simtime = 1e-9 * jj;
+    for (int ii = 0; nsig > ii; ++ii) {
+      if (is_time) {
+        struct svp_sim_time_t stime = {jj, 0.25};
+        svp_dstore_write_time(ds[ii], stime);
+      } else {
+        write_sample(ds[ii], esize, is_real, width, simtime, (jj >> 2) + ii,
+                     buf);
+      }
+    }
+  }
+  svp_hdf5_fclose(dat);
+  double elapsed = now() - t0;
+  struct stat fstat;
+  stat(FNAME, &fstat);
+  // Data bytes given to the writers, without timestamps
+  double nsamp = (double)nwrite * nsig;
+  double nbytes = nsamp * (is_time ? sizeof(struct svp_sim_time_t)
+                                   : (size_t)esize * width);
+  const char *sname = is_time ? "time" : STORAGE[storage];
+  printf("%-7s %-6s %5d %6d %14.3e %10.1f\n", dtype, sname, width, nsig,
+         nsamp / elapsed, 1e-6 * nbytes / elapsed);
+  fprintf(fp, "%s\n    {\"dtype\": \"%s\", \"storage\": \"%s\", "
+          "\"rank\": \"%s\", \"width\": %d, \"signals\": %d, "
+          "\"samples\": %.0f, \"seconds\": %.6f, \"samples_per_s\": %.6g, "
+          "\"mb_per_s\": %.6g, \"file_bytes\": %ld}", first ? "" : ",",
+          dtype, sname,
+          (1 < width) ? "array" : "scalar", width, nsig, nsamp, elapsed,
+          nsamp / elapsed, 1e-6 * nbytes / elapsed, (long)fstat.st_size);
+  free(buf);
+  free(ds);
+}  // run_dstore
+
+
+/**
+ * @brief Append the sampling rate of a noise generator.
+ *
+ * @param fp JSON output, positioned inside the noise list.
+ * @param first No result has been written to the list yet.
+ * @param func Name of the generator.
+ * @param elapsed Time taken for NUM_NOISE samples.
+ * @param sum Sum of the samples, printed so the calls are not optimized out.
+ */
+static void put_noise(FILE *fp, int first, const char *func, double elapsed,
+                      double sum) {
+  printf("%-24s %14.3e %14.6g\n", func, NUM_NOISE / elapsed, sum / NUM_NOISE);
+  fprintf(fp, "%s\n    {\"function\": \"%s\", \"samples\": %d, "
+          "\"seconds\": %.6f, \"samples_per_s\": %.6g}", first ? "" : ",",
+          func, NUM_NOISE, elapsed, NUM_NOISE / elapsed);
+}  // put_noise
+
+
+/**
+ * Usage: bench.out [json]
+ *
+ * json: Results file, default bench.json.
+ */
+int main(int argc, char **argv) {
+  const char *jname = (1 < argc) ? argv[1] : "bench.json";
+  FILE *fp = fopen(jname, "w");
+  if (!fp) {
+    fprintf(stderr, "ERROR %s: Could not open %s\n", __func__, jname);
+    return 1;
+  }
+  fprintf(fp, "{\n  \"hdf5\": \"%d.%d.%d\",\n  \"compiler\": \"%s\",\n"
+          "  \"dstore\": [", H5_VERS_MAJOR, H5_VERS_MINOR, H5_VERS_RELEASE,
+          __VERSION__);
+  // Every dtype, storage and rank, over the signal counts
+  printf("%-7s %-6s %5s %6s %14s %10s\n", "dtype", "store", "width",
+         "sigs", "samples/s", "MB/s");
+  int first = 1;
+  int widths[2] = {1, ARRAY_WIDTH};
+  for (int ii = 0; sizeof(DTYPES) / sizeof(DTYPES[0]) > ii; ++ii) {
+    for (int jj = 0; sizeof(STORAGE) / sizeof(STORAGE[0]) > jj; ++jj) {
+      for (int kk = 0; 2 > kk; ++kk) {
+        for (int ll = 0; sizeof(NUM_SIGNALS) / sizeof(int) > ll; ++ll) {
+          run_dstore(fp, first, DTYPES[ii], jj, widths[kk], NUM_SIGNALS[ll]);
+          first = 0;
+        }
+      }
+    }
+  }
+  // Simulation time is always a scalar
+  for (int ll = 0; sizeof(NUM_SIGNALS) / sizeof(int) > ll; ++ll) {
+    run_dstore(fp, first, "time", 0, 1, NUM_SIGNALS[ll]);
+  }
+  fprintf(fp, "\n  ],\n  \"noise\": [");
+  // Noise generators
+  printf("\n%-24s %14s %14s\n", "function", "samples/s", "mean");
+  struct svp_rng_state_t gen = {};
+  struct svp_rng_flicker_state_t *flk =
+      svp_rng_flicker_new(1e5, 1e7, 1e6, 1e-6, 1e9);
+  double sum = 0;
+  double t0 = now();
+  for (int ii = 0; NUM_NOISE > ii; ++ii) {
+    sum += svp_rng_rand();
+  }
+  put_noise(fp, 1, "svp_rng_rand", now() - t0, sum);
+  sum = 0;
+  t0 = now();
+  for (int ii = 0; NUM_NOISE > ii; ++ii) {
+    sum += svp_rng_randn(&gen);
+  }
+  put_noise(fp, 0, "svp_rng_randn", now() - t0, sum);
+  sum = 0;
+  t0 = now();
+  for (int ii = 0; NUM_NOISE > ii; ++ii) {
+    sum += svp_rng_randn_bnd(&gen, -1.5, 1);
+  }
+  put_noise(fp, 0, "svp_rng_randn_bnd", now() - t0, sum);
+  sum = 0;
+  t0 = now();
+  for (int ii = 0; NUM_NOISE > ii; ++ii) {
+    sum += svp_rng_flicker_samp(flk);
+  }
+  put_noise(fp, 0, "svp_rng_flicker_samp", now() - t0, sum);
+  svp_rng_flicker_free(flk);
+  fprintf(fp, "\n  ]\n}\n");
+  fclose(fp);
+  return 0;
+}
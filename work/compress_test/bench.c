@@ -0,0 +1,127 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Compare file size and write throughput of the compression filters, on a
+// mix of narrow bit, integer and real signals.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: Added compression worker pool comparison.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "../../csrc/svp_file.h"
+#include "../../csrc/svp_dstore.h"
+
+#define NUM_WRITE 1000000
+#define NUM_SIGNALS 5
+
+/// Filter settings to be compared
+static const char *FILTERS[] = {"none", "deflate:1", "shuffle+deflate:4",
+                                "nbit", "nbit+shuffle+deflate:4",
+                                "scaleoffset", "scaleoffset+deflate:4"};
+/// Filter used to compare compression worker pool sizes
+#define POOL_FILTER "shuffle+deflate:4"
+/// Worker pool sizes to be compared (0 compresses in the HDF5 pipeline)
+static const int POOL_THREADS[] = {0, 1, 2, 4};
+
+
+/**
+ * @brief Write the test signals with the given filters.
+ *
+ * @param fname Output file name.
+ * @param filt Filter spec used for all signals.
+ * @param nthreads Number of compression workers, 0 to disable the pool.
+ * @return double Elapsed time in seconds, including the final close.
+ */
+double run(const char *fname, const char *filt, int nthreads) {
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  struct svp_hdf5_data *dat = svp_hdf5_fopen(fname);
+  svp_hdf5_set_filter(dat, filt);
+  if (nthreads) {
+    svp_hdf5_set_compress_threads(dat, nthreads);
+  }
+  // 3-bit control signal, slowly-varying counter, bus, real and async real
+  int d1[1] = {1};
+  int d4[1] = {4};
+  struct svp_dstore_opt_t opt3 = {};
+  opt3.precision = 3;
+  struct svp_dstore_t *ds[NUM_SIGNALS];
+  ds[0] = svp_dstore_create_opt(dat, "top.ctl3", SVP_STORE_SYNC_DATA, 1, d1,
+                                H5T_NATIVE_UCHAR, &opt3);
+  ds[1] = svp_dstore_create(dat, "top.count", SVP_STORE_SYNC_DATA, 1, d1,
+                            H5T_NATIVE_INT);
+  ds[2] = svp_dstore_create(dat, "top.bus4", SVP_STORE_SYNC_DATA, 1, d4,
+                            H5T_NATIVE_SHORT);
+  ds[3] = svp_dstore_create(dat, "top.vout", SVP_STORE_SYNC_DATA, 1, d1,
+                            H5T_NATIVE_DOUBLE);
+  ds[4] = svp_dstore_create(dat, "top.vasync", SVP_STORE_ASYNC_DATA, 1, d1,
+                            H5T_NATIVE_DOUBLE);
+  for (int ii = 0; NUM_SIGNALS > ii; ++ii) {
+    svp_hdf5_addsig(dat, ds[ii]);
+  }
+  // Write the data
+  unsigned char ctl;
+  int count;
+  short bus[4];
+  double vout;
+  for (int ii = 0; NUM_WRITE > ii; ++ii) {
+    ctl = (ii >> 10) & 0x7;
+    count = ii / 3;
+    for (int jj = 0; 4 > jj; ++jj) {
+      bus[jj] = (ii + jj) & 0x3ff;
+    }
+    vout = sin(1e-3 * ii);
+    svp_dstore_write_data(ds[0], 0, &ctl);
+    svp_dstore_write_data(ds[1], 0, &count);
+    svp_dstore_write_data(ds[2], 0, bus);
+    svp_dstore_write_data(ds[3], 0, &vout);
+    svp_dstore_write_data(ds[4], 1e-9 * ii, &vout);
+  }
+  svp_hdf5_fclose(dat);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  return (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+}  // run
+
+
+int main(void) {
+  char fname[64];
+  struct stat fstat;
+  printf("%-24s %12s %8s %14s\n", "filter", "bytes", "ratio", "samples/s");
+  double ref_bytes = 0;
+  for (int ii = 0; sizeof(FILTERS) / sizeof(FILTERS[0]) > ii; ++ii) {
+    sprintf(fname, "bench_%d.h5", ii);
+    double elapsed = run(fname, FILTERS[ii], 0);
+    stat(fname, &fstat);
+    if (0 == ii) {
+      ref_bytes = fstat.st_size;
+    }
+    printf("%-24s %12ld %8.2f %14.3e\n", FILTERS[ii], (long)fstat.st_size,
+           ref_bytes / fstat.st_size, NUM_SIGNALS * NUM_WRITE / elapsed);
+  }
+  // Same data, compressed by the worker pool
+  printf("\n%-24s %12s %8s %14s\n", POOL_FILTER " threads", "bytes", "ratio",
+         "samples/s");
+  for (int ii = 0; sizeof(POOL_THREADS) / sizeof(POOL_THREADS[0]) > ii; ++ii) {
+    sprintf(fname, "bench_pool_%d.h5", POOL_THREADS[ii]);
+    double elapsed = run(fname, POOL_FILTER, POOL_THREADS[ii]);
+    stat(fname, &fstat);
+    printf("%-24d %12ld %8.2f %14.3e\n", POOL_THREADS[ii], (long)fstat.st_size,
+           ref_bytes / fstat.st_size, NUM_SIGNALS * NUM_WRITE / elapsed);
+  }
+}
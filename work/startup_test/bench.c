@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// UCSD ISPG Group 2022
+//
+// Created on 16-Oct-26
+// @author: Colin Weltin-Wu
+//
+// Description
+// -----------
+// Measure the time to set up (and tear down) a dump of many signals spread
+// over a deep module hierarchy, as done at elaboration of a large testbench.
+//
+// Version History
+// ---------------
+// 16-Oct-26: Initial version
+// 16-Oct-26: Lazy creation mode, and a fraction of idle signals.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "../../csrc/svp_file.h"
+#include "../../csrc/svp_dstore.h"
+
+/// Default number of signals
+#define NUM_SIGNALS 50000
+/// Module instances per hierarchy level
+#define FANOUT 6
+/// Module levels between the top and the signals
+#define DEPTH 6
+/// Samples written to each signal
+#define NUM_WRITE 4
+
+
+/**
+ * @brief Wall-clock time.
+ *
+ * @return double Seconds since an arbitrary origin.
+ */
+double now(void) {
+  struct timespec tnow;
+  clock_gettime(CLOCK_MONOTONIC, &tnow);
+  return tnow.tv_sec + 1e-9 * tnow.tv_nsec;
+}  // now
+
+
+/**
+ * Usage: bench.out [nsig] [lazy] [active]
+ *
+ * nsig: Number of signals.
+ * lazy: Dataset creation mode (see svp_hdf5_set_lazy), default 0.
+ * active: Only one signal in this many is written, default 1 (all).
+ */
+int main(int argc, char **argv) {
+  int nsig = (1 < argc) ? atoi(argv[1]) : NUM_SIGNALS;
+  int lazy = (2 < argc) ? atoi(argv[2]) : 0;
+  int active = (3 < argc) ? atoi(argv[3]) : 1;
+  char name[256];
+  int dims[1] = {1};
+  double t0 = now();
+  struct svp_hdf5_data *dat = svp_hdf5_fopen("bench.h5");
+  // Small chunks, this is about setup cost and not the cache memory
+  svp_hdf5_set_chunk_bytes(dat, 4096);
+  svp_hdf5_set_lazy(dat, lazy);
+  for (int ii = 0; nsig > ii; ++ii) {
+    // Sibling signals share a leaf module, leaf modules are spread over the
+    // hierarchy tree
+    int leaf = ii / 16;
+    int len = sprintf(name, "tb.u_dut");
+    for (int jj = 0; DEPTH > jj; ++jj) {
+      len += sprintf(name + len, ".u_l%d_%d", jj, leaf % FANOUT);
+      leaf /= FANOUT;
+    }
+    sprintf(name + len, ".sig%d", ii);
+    struct svp_dstore_t *ds = svp_dstore_create(dat, name, SVP_STORE_SYNC_DATA,
+                                                1, dims, H5T_NATIVE_INT);
+    if (svp_hdf5_addsig(dat, ds)) {
+      fprintf(stderr, "Could not add signal %s\n", name);
+      return 1;
+    }
+  }
+  double t1 = now();
+  // Write a few samples, so the close includes flushing
+  for (int kk = 0; NUM_WRITE > kk; ++kk) {
+    for (int ii = 0; nsig > ii; ii += active) {
+      svp_dstore_write_data(dat->dptr[ii], 0, &kk);
+    }
+  }
+  double t2 = now();
+  svp_hdf5_fclose(dat);
+  double t3 = now();
+  printf("%d signals (1 in %d written), depth %d, lazy %d: create %.3f s "
+         "(%.1f us/signal), write %.3f s, close %.3f s (%.1f us/signal)\n",
+         nsig, active, DEPTH + 2, lazy, t1 - t0, 1e6 * (t1 - t0) / nsig,
+         t2 - t1, t3 - t2, 1e6 * (t3 - t2) / nsig);
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  printf("peak resident memory %.1f MiB\n", usage.ru_maxrss / 1024.0);
+  return 0;
+}  // main